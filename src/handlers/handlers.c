@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <dirent.h>
 #include <sys/stat.h>
@@ -13,6 +14,12 @@
 #include "handlers.h"
 #include "dbus_core.h"
 #include "sysinfo.h"
+#include "sysinfo_collector.h"
+#include "cpu_monitor.h"
+#include "at_cache.h"
+#include "at_scheduler.h"
+#include "at_batch.h"
+#include "dbus_query.h"
 #include "exec_utils.h"
 #include "airplane.h"
 #include "modem.h"
@@ -20,62 +27,258 @@
 #include "apn.h"
 #include "ofono.h"
 #include "json_builder.h"
+#include "http_server.h"
+#include "db_worker.h"
 
 
-/* GET /api/info - 获取系统信息 */
+/* 读取整数查询参数，不存在返回 def */
+static int query_int(struct mg_http_message *hm, const char *name, int def) {
+    char buf[16];
+    if (mg_http_get_var(&hm->query, name, buf, sizeof(buf)) <= 0) {
+        return def;
+    }
+    return atoi(buf);
+}
+
+/* /api/info 字段 */
+typedef enum {
+    INFO_STR,
+    INFO_INT,
+    INFO_UINT,
+    INFO_ULONG,
+    INFO_DOUBLE,
+    INFO_BOOL,
+    INFO_ZONES
+} InfoFieldType;
+
+#define INFO_GROUP_NONE  (-1)  /* 固定值，不需要采集 */
+
+/* 按输出顺序排列；group 为产生该字段的采集分组 */
+static const struct {
+    const char *name;
+    int group;
+    InfoFieldType type;
+    size_t offset;
+} g_info_fields[] = {
+    { "hostname",            SYSINFO_GROUP_UNAME,    INFO_STR,    offsetof(SystemInfo, hostname) },
+    { "sysname",             SYSINFO_GROUP_UNAME,    INFO_STR,    offsetof(SystemInfo, sysname) },
+    { "release",             SYSINFO_GROUP_UNAME,    INFO_STR,    offsetof(SystemInfo, release) },
+    { "version",             SYSINFO_GROUP_UNAME,    INFO_STR,    offsetof(SystemInfo, version) },
+    { "machine",             SYSINFO_GROUP_UNAME,    INFO_STR,    offsetof(SystemInfo, machine) },
+    { "total_ram",           SYSINFO_GROUP_MEMORY,   INFO_ULONG,  offsetof(SystemInfo, total_ram) },
+    { "free_ram",            SYSINFO_GROUP_MEMORY,   INFO_ULONG,  offsetof(SystemInfo, free_ram) },
+    { "cached_ram",          SYSINFO_GROUP_MEMORY,   INFO_ULONG,  offsetof(SystemInfo, cached_ram) },
+    { "cpu_usage",           SYSINFO_GROUP_CPU,      INFO_DOUBLE, offsetof(SystemInfo, cpu_usage) },
+    { "uptime",              SYSINFO_GROUP_UPTIME,   INFO_DOUBLE, offsetof(SystemInfo, uptime) },
+    { "bridge_status",       INFO_GROUP_NONE,        INFO_STR,    offsetof(SystemInfo, bridge_status) },
+    { "sim_slot",            SYSINFO_GROUP_SLOT,     INFO_STR,    offsetof(SystemInfo, sim_slot) },
+    { "signal_strength",     SYSINFO_GROUP_SIGNAL,   INFO_STR,    offsetof(SystemInfo, signal_strength) },
+    { "thermal_temp",        SYSINFO_GROUP_THERMAL,  INFO_DOUBLE, offsetof(SystemInfo, thermal_temp) },
+    { "thermal_zones",       SYSINFO_GROUP_THERMAL,  INFO_ZONES,  0 },
+    { "power_status",        SYSINFO_GROUP_BATTERY,  INFO_STR,    offsetof(SystemInfo, power_status) },
+    { "battery_health",      SYSINFO_GROUP_BATTERY,  INFO_STR,    offsetof(SystemInfo, battery_health) },
+    { "battery_capacity",    SYSINFO_GROUP_BATTERY,  INFO_UINT,   offsetof(SystemInfo, battery_capacity) },
+    { "ssid",                SYSINFO_GROUP_WIFI,     INFO_STR,    offsetof(SystemInfo, ssid) },
+    { "passwd",              INFO_GROUP_NONE,        INFO_STR,    offsetof(SystemInfo, passwd) },
+    { "select_network_mode", SYSINFO_GROUP_NET_MODE, INFO_STR,    offsetof(SystemInfo, select_network_mode) },
+    { "is_activated",        INFO_GROUP_NONE,        INFO_INT,    offsetof(SystemInfo, is_activated) },
+    { "serial",              SYSINFO_GROUP_SERIAL,   INFO_STR,    offsetof(SystemInfo, serial) },
+    { "network_mode",        SYSINFO_GROUP_SLOT,     INFO_STR,    offsetof(SystemInfo, network_mode) },
+    { "airplane_mode",       SYSINFO_GROUP_AIRPLANE, INFO_BOOL,   offsetof(SystemInfo, airplane_mode) },
+    { "imei",                SYSINFO_GROUP_IDENTITY, INFO_STR,    offsetof(SystemInfo, imei) },
+    { "iccid",               SYSINFO_GROUP_IDENTITY, INFO_STR,    offsetof(SystemInfo, iccid) },
+    { "imsi",                SYSINFO_GROUP_IDENTITY, INFO_STR,    offsetof(SystemInfo, imsi) },
+    { "carrier",             SYSINFO_GROUP_IDENTITY, INFO_STR,    offsetof(SystemInfo, carrier) },
+    { "network_type",        SYSINFO_GROUP_SERVING,  INFO_STR,    offsetof(SystemInfo, network_type) },
+    { "network_band",        SYSINFO_GROUP_SERVING,  INFO_STR,    offsetof(SystemInfo, network_band) },
+    { "qci",                 SYSINFO_GROUP_QOS,      INFO_INT,    offsetof(SystemInfo, qci) },
+    { "downlink_rate",       SYSINFO_GROUP_QOS,      INFO_INT,    offsetof(SystemInfo, downlink_rate) },
+    { "uplink_rate",         SYSINFO_GROUP_QOS,      INFO_INT,    offsetof(SystemInfo, uplink_rate) },
+};
+
+#define INFO_FIELD_COUNT  (sizeof(g_info_fields) / sizeof(g_info_fields[0]))
+
+/**
+ * 解析 ?fields=a,b,c，未知字段忽略
+ * @param selected 输出各字段是否被选中
+ * @return 选中字段所需的分组掩码；没有 fields 参数时选中全部
+ */
+static unsigned int parse_info_fields(struct mg_http_message *hm, unsigned char selected[INFO_FIELD_COUNT]) {
+    char buf[512];
+    unsigned int groups = 0;
+
+    if (mg_http_get_var(&hm->query, "fields", buf, sizeof(buf)) <= 0) {
+        memset(selected, 1, INFO_FIELD_COUNT);
+        return SYSINFO_GROUP_ALL;
+    }
+
+    memset(selected, 0, INFO_FIELD_COUNT);
+    char *save = NULL;
+    for (char *name = strtok_r(buf, ", ", &save); name; name = strtok_r(NULL, ", ", &save)) {
+        for (size_t i = 0; i < INFO_FIELD_COUNT; i++) {
+            if (strcmp(name, g_info_fields[i].name) == 0) {
+                selected[i] = 1;
+                if (g_info_fields[i].group != INFO_GROUP_NONE) {
+                    groups |= SYSINFO_GROUP_BIT(g_info_fields[i].group);
+                }
+                break;
+            }
+        }
+    }
+    return groups;
+}
+
+static void add_info_field(JsonBuilder *j, size_t i, const SystemInfo *info) {
+    const char *name = g_info_fields[i].name;
+    const char *p = (const char *)info + g_info_fields[i].offset;
+
+    switch (g_info_fields[i].type) {
+    case INFO_STR:
+        json_add_str(j, name, p);
+        break;
+    case INFO_INT:
+        json_add_int(j, name, *(const int *)p);
+        break;
+    case INFO_UINT:
+        json_add_int(j, name, (int)*(const unsigned int *)p);
+        break;
+    case INFO_ULONG:
+        json_add_ulong(j, name, *(const unsigned long *)p);
+        break;
+    case INFO_DOUBLE:
+        json_add_double(j, name, *(const double *)p);
+        break;
+    case INFO_BOOL:
+        json_add_bool(j, name, *(const int *)p);
+        break;
+    case INFO_ZONES:
+        json_arr_open(j, name);
+        for (int z = 0; z < info->thermal_zone_count; z++) {
+            json_arr_obj_open(j);
+            json_add_int(j, "id", info->thermal_zones[z].id);
+            json_add_str(j, "name", info->thermal_zones[z].name);
+            json_add_double(j, "temp", info->thermal_zones[z].temp);
+            json_obj_close(j);
+        }
+        json_arr_close(j);
+        break;
+    }
+}
+
+/* GET /api/info[?fields=a,b] - 获取系统信息（来自后台采集的快照） */
 void handle_info(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
 
+    unsigned char selected[INFO_FIELD_COUNT];
+    unsigned int groups = parse_info_fields(hm, selected);
+
     SystemInfo info;
-    get_system_info(&info);
+    long long age_ms[SYSINFO_GROUP_COUNT];
+    if (sysinfo_collector_snapshot(&info, age_ms, groups) != 0) {
+        /* 采集线程未运行时同步采集，只执行所选字段需要的探测 */
+        sysinfo_init_defaults(&info);
+        sysinfo_probe_groups(groups, &info);
+        memset(age_ms, 0, sizeof(age_ms));
+    }
 
     JsonBuilder *j = json_new();
     json_obj_open(j);
-    json_add_str(j, "hostname", info.hostname);
-    json_add_str(j, "sysname", info.sysname);
-    json_add_str(j, "release", info.release);
-    json_add_str(j, "version", info.version);
-    json_add_str(j, "machine", info.machine);
-    json_add_ulong(j, "total_ram", info.total_ram);
-    json_add_ulong(j, "free_ram", info.free_ram);
-    json_add_ulong(j, "cached_ram", info.cached_ram);
-    json_add_double(j, "cpu_usage", info.cpu_usage);
-    json_add_double(j, "uptime", info.uptime);
-    json_add_str(j, "bridge_status", info.bridge_status);
-    json_add_str(j, "sim_slot", info.sim_slot);
-    json_add_str(j, "signal_strength", info.signal_strength);
-    json_add_double(j, "thermal_temp", info.thermal_temp);
-    json_add_str(j, "power_status", info.power_status);
-    json_add_str(j, "battery_health", info.battery_health);
-    json_add_int(j, "battery_capacity", info.battery_capacity);
-    json_add_str(j, "ssid", info.ssid);
-    json_add_str(j, "passwd", info.passwd);
-    json_add_str(j, "select_network_mode", info.select_network_mode);
-    json_add_int(j, "is_activated", info.is_activated);
-    json_add_str(j, "serial", info.serial);
-    json_add_str(j, "network_mode", info.network_mode);
-    json_add_bool(j, "airplane_mode", info.airplane_mode);
-    json_add_str(j, "imei", info.imei);
-    json_add_str(j, "iccid", info.iccid);
-    json_add_str(j, "imsi", info.imsi);
-    json_add_str(j, "carrier", info.carrier);
-    json_add_str(j, "network_type", info.network_type);
-    json_add_str(j, "network_band", info.network_band);
-    json_add_int(j, "qci", info.qci);
-    json_add_int(j, "downlink_rate", info.downlink_rate);
-    json_add_int(j, "uplink_rate", info.uplink_rate);
+    for (size_t i = 0; i < INFO_FIELD_COUNT; i++) {
+        if (selected[i]) add_info_field(j, i, &info);
+    }
+
+    /* 各字段距上次采集的毫秒数，-1 表示尚未采集 */
+    json_key_obj_open(j, "field_age_ms");
+    for (size_t i = 0; i < INFO_FIELD_COUNT; i++) {
+        if (selected[i] && g_info_fields[i].group != INFO_GROUP_NONE) {
+            json_add_long(j, g_info_fields[i].name, age_ms[g_info_fields[i].group]);
+        }
+    }
+    json_obj_close(j);
+    json_obj_close(j);
+
+    HTTP_OK_FREE(c, json_finish(j));
+}
+
+
+/* GET /api/cpu[?window=秒] - CPU 使用率（总计、各核、占用最高的进程） */
+void handle_cpu_stats(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    int window = query_int(hm, "window", CPU_MONITOR_DEFAULT_WINDOW);
+    CpuMonitorStats st;
+    if (cpu_monitor_get_stats(window, &st) != 0) {
+        HTTP_ERROR(c, 503, "CPU 监控尚无采样数据，请稍后重试");
+        return;
+    }
+
+    JsonBuilder *j = json_new();
+    json_obj_open(j);
+    json_add_int(j, "interval_ms", st.interval_ms);
+    json_add_int(j, "samples", st.samples);
+
+    json_key_obj_open(j, "total");
+    json_add_double(j, "now", st.total_now);
+    json_add_double(j, "avg", st.total_avg);
+    json_obj_close(j);
+
+    json_arr_open(j, "cores");
+    for (int i = 0; i < st.core_count; i++) {
+        json_arr_obj_open(j);
+        json_add_int(j, "id", i);
+        json_add_double(j, "now", st.core_now[i]);
+        json_add_double(j, "avg", st.core_avg[i]);
+        json_obj_close(j);
+    }
+    json_arr_close(j);
+
+    /* 进程使用率为占全部核总能力的百分比 */
+    json_arr_open(j, "processes");
+    for (int i = 0; i < st.proc_count; i++) {
+        json_arr_obj_open(j);
+        json_add_int(j, "pid", st.procs[i].pid);
+        json_add_str(j, "name", st.procs[i].name);
+        json_add_double(j, "now", st.procs[i].now);
+        json_add_double(j, "avg", st.procs[i].avg);
+        json_obj_close(j);
+    }
+    json_arr_close(j);
     json_obj_close(j);
 
     HTTP_OK_FREE(c, json_finish(j));
 }
 
+/* AT 命令完成后回复 /api/at */
+static void execute_at_done(AtBatch *batch, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    if (!c) return;  /* 连接已关闭 */
+
+    JsonBuilder *j = json_new();
+    json_obj_open(j);
+
+    if (at_batch_rc(batch, 0) == 0) {
+        const char *result = at_batch_result(batch, 0);
+        printf("AT 命令执行成功: %s\n", result);
+        json_add_int(j, "Code", 0);
+        json_add_str(j, "Error", "");
+        json_add_str(j, "Data", result ? result : "");
+    } else {
+        const char *error = at_batch_error(batch, 0);
+        printf("AT 命令执行失败: %s\n", error ? error : "");
+        json_add_int(j, "Code", 1);
+        json_add_str(j, "Error", error ? error : "");
+        json_add_null(j, "Data");
+    }
+
+    json_obj_close(j);
+    HTTP_OK_FREE(c, json_finish(j));
+}
 
 /* POST /api/at - 执行 AT 命令 */
 void handle_execute_at(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
 
     char cmd[256] = {0};
-    char *result = NULL;
 
     /* 使用mongoose内置JSON解析 */
     char *cmd_str = mg_json_get_str(hm->body, "$.command");
@@ -98,24 +301,45 @@ void handle_execute_at(struct mg_connection *c, struct mg_http_message *hm) {
 
     printf("执行 AT 命令: %s\n", cmd);
 
+    /* 异步执行，完成后按连接 ID 回复 */
+    AtBatch *batch = at_batch_new();
+    at_batch_add(batch, cmd, 0, 0);
+    at_batch_run_async(batch, c->id, execute_at_done, GSIZE_TO_POINTER(c->id));
+}
+
+/* GET /api/at/stats - AT 调度器队列深度和等待时间 */
+void handle_at_stats(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    static const char *prio_names[AT_PRIO_COUNT] = { "write", "read", "background" };
+    AtSchedulerStats st;
+    at_scheduler_get_stats(&st);
+
     JsonBuilder *j = json_new();
     json_obj_open(j);
-
-    /* 执行 AT 命令 */
-    if (execute_at(cmd, &result) == 0) {
-        printf("AT 命令执行成功: %s\n", result);
-        json_add_int(j, "Code", 0);
-        json_add_str(j, "Error", "");
-        json_add_str(j, "Data", result ? result : "");
-        g_free(result);
-    } else {
-        printf("AT 命令执行失败: %s\n", dbus_get_last_error());
-        json_add_int(j, "Code", 1);
-        json_add_str(j, "Error", dbus_get_last_error());
-        json_add_null(j, "Data");
+    json_add_bool(j, "running", st.running);
+    json_arr_open(j, "queues");
+    for (int p = 0; p < AT_PRIO_COUNT; p++) {
+        AtSchedulerPrioStats *ps = &st.prio[p];
+        json_arr_obj_open(j);
+        json_add_str(j, "priority", prio_names[p]);
+        json_add_int(j, "depth", ps->depth);
+        json_add_int(j, "max_depth", ps->max_depth);
+        json_add_ulong(j, "submitted", ps->submitted);
+        json_add_ulong(j, "completed", ps->completed);
+        json_add_ulong(j, "failed", ps->failed);
+        json_add_ulong(j, "expired", ps->expired);
+        json_add_ulong(j, "cancelled", ps->cancelled);
+        json_add_ulong(j, "retries", ps->retries);
+        json_add_ulong(j, "coalesced", ps->coalesced);
+        json_add_double(j, "avg_wait_ms", ps->avg_wait_ms);
+        json_add_long(j, "max_wait_ms", ps->max_wait_ms);
+        json_add_double(j, "avg_exec_ms", ps->avg_exec_ms);
+        json_obj_close(j);
     }
-
+    json_arr_close(j);
     json_obj_close(j);
+
     HTTP_OK_FREE(c, json_finish(j));
 }
 
@@ -149,6 +373,8 @@ void handle_set_network(struct mg_connection *c, struct mg_http_message *hm) {
     }
 
     if (set_network_mode_for_slot(mode, strlen(slot) > 0 ? slot : NULL) == 0) {
+        at_cache_invalidate_all();
+        sysinfo_collector_refresh(SYSINFO_GROUP_NET_MODE);
         HTTP_SUCCESS(c, "Network mode updated successfully");
     } else {
         HTTP_OK(c, "{\"status\":\"error\",\"message\":\"Failed to update network mode\"}");
@@ -176,6 +402,8 @@ void handle_switch(struct mg_connection *c, struct mg_http_message *hm) {
     JsonBuilder *j = json_new();
     json_obj_open(j);
     if (switch_slot(slot) == 0) {
+        at_cache_invalidate_all();
+        sysinfo_collector_refresh(SYSINFO_GROUP_SLOT);
         json_add_str(j, "status", "success");
         char msg[64];
         snprintf(msg, sizeof(msg), "Slot switched to %s successfully", slot);
@@ -206,6 +434,8 @@ void handle_airplane_mode(struct mg_connection *c, struct mg_http_message *hm) {
     }
 
     if (set_airplane_mode(enabled) == 0) {
+        at_cache_invalidate_all();
+        sysinfo_collector_refresh(SYSINFO_GROUP_AIRPLANE);
         HTTP_SUCCESS(c, "Airplane mode updated successfully");
     } else {
         HTTP_ERROR(c, 500, "Failed to set airplane mode: AT command failed");
@@ -368,23 +598,25 @@ static int is_5g_network(void) {
     return 0; /* 4G 或其他 */
 }
 
-/* GET /api/current_band - 获取当前连接频段 */
-void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_GET(c, hm);
+/* 当前小区查询的连接和网络类型 */
+typedef struct {
+    unsigned long conn_id;
+    int is_5g;
+} CurrentBandQuery;
 
+/**
+ * 由服务小区 AT+SPENGMD 应答生成 /api/current_band 响应
+ * @param is_5g 1=5G (AT+SPENGMD=0,14,1), 0=4G (AT+SPENGMD=0,6,0)
+ * @param result AT 应答，失败时为 NULL
+ */
+static char *build_current_band_json(int is_5g, const char *result) {
     char net_type[32] = "N/A";
     char band[32] = "N/A";
     int arfcn = 0, pci = 0;
     double rsrp = 0, rsrq = 0, sinr = 0;
-    char response[512];
-
-    /* 通过 D-Bus 判断网络类型 (与 Go 版本一致) */
-    int is_5g = is_5g_network();
-    char *result = NULL;
 
     if (is_5g) {
-        /* 5G 网络: AT+SPENGMD=0,14,1 */
-        if (execute_at("AT+SPENGMD=0,14,1", &result) == 0 && result && strlen(result) > 100) {
+        if (result && strlen(result) > 100) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             
@@ -412,10 +644,8 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
                        band, arfcn, pci, rsrp, rsrq, sinr);
             }
         }
-        if (result) { g_free(result); result = NULL; }
     } else {
-        /* 4G 网络: AT+SPENGMD=0,6,0 */
-        if (execute_at("AT+SPENGMD=0,6,0", &result) == 0 && result && strlen(result) > 100) {
+        if (result && strlen(result) > 100) {
             char data[64][16][32] = {{{0}}};
             int rows = parse_cell_to_vec(result, data);
             
@@ -443,7 +673,6 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
                        band, arfcn, pci, rsrp, rsrq, sinr);
             }
         }
-        if (result) { g_free(result); result = NULL; }
     }
 
     JsonBuilder *j = json_new();
@@ -461,45 +690,282 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
     json_obj_close(j);
     json_obj_close(j);
 
-    HTTP_OK_FREE(c, json_finish(j));
+    return json_finish(j);
+}
+
+/* 服务小区 AT 查询完成后回复 */
+static void current_band_done(AtBatch *batch, void *user_data) {
+    CurrentBandQuery *q = user_data;
+    struct mg_connection *c = http_server_find_conn(q->conn_id);
+    if (c) {
+        HTTP_OK_FREE(c, build_current_band_json(q->is_5g, at_batch_result(batch, 0)));
+    }
+    g_free(q);
+}
+
+static void start_current_band_query(unsigned long conn_id, int is_5g) {
+    CurrentBandQuery *q = g_new0(CurrentBandQuery, 1);
+    q->conn_id = conn_id;
+    q->is_5g = is_5g;
+
+    AtBatch *batch = at_batch_new();
+    at_batch_add(batch, is_5g ? "AT+SPENGMD=0,14,1" : "AT+SPENGMD=0,6,0", 0, 0);
+    at_batch_run_async(batch, conn_id, current_band_done, q);
+}
+
+/* 网络类型查询完成后查询服务小区 */
+static void current_band_tech_done(DbusQueryGroup *group, void *user_data) {
+    unsigned long conn_id = GPOINTER_TO_SIZE(user_data);
+    if (!http_server_find_conn(conn_id)) return;  /* 连接已关闭 */
+
+    char tech[32] = {0};
+    GVariant *tech_val = dbus_query_lookup_property(dbus_query_group_result(group, 0), "Technology");
+    if (tech_val && g_variant_is_of_type(tech_val, G_VARIANT_TYPE_STRING)) {
+        snprintf(tech, sizeof(tech), "%s", g_variant_get_string(tech_val, NULL));
+    } else {
+        printf("D-Bus 查询网络类型失败，默认使用 4G\n");
+    }
+    if (tech_val) g_variant_unref(tech_val);
+
+    start_current_band_query(conn_id, strcmp(tech, "nr") == 0);
+}
+
+/* GET /api/current_band - 获取当前连接频段 */
+void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    /* 通过 D-Bus 判断网络类型 (与 Go 版本一致)，网络类型和 AT 查询都不阻塞主循环 */
+    DbusQueryGroup *q = dbus_query_group_new(OFONO_TIMEOUT_MS);
+    if (q) {
+        dbus_query_group_add(q, "/ril_0", "org.ofono.NetworkMonitor",
+                             "GetServingCellInformation", NULL, "(a{sv})");
+        if (dbus_query_group_run_async(q, current_band_tech_done, GSIZE_TO_POINTER(c->id)) == 0) {
+            return;
+        }
+        dbus_query_group_free(q);
+    }
+
+    start_current_band_query(c->id, is_5g_network());
 }
 
 
 /* ==================== 短信 API ==================== */
 #include "sms.h"
 
-/* GET /api/sms - 获取短信列表 */
+/* 短信列表查询模式 */
+#define SMS_LIST_ALL    0   /* 无参数：返回最新100条的数组（兼容旧版） */
+#define SMS_LIST_PAGE   1   /* ?before_id=&limit= 键集分页 */
+#define SMS_LIST_SINCE  2   /* ?since_id= 增量同步 */
+
+/* 异步短信列表请求 - 查询在数据库线程执行，完成后按连接ID回复 */
+typedef struct {
+    unsigned long conn_id;
+    int mode;
+    int boundary_id;        /* before_id 或 since_id */
+    int limit;
+    int count;
+    SmsStats stats;
+    SmsMessage *messages;   /* limit+1 条，多取一条用于判断 has_more */
+} SmsListJob;
+
+static int sms_list_job(void *arg) {
+    SmsListJob *job = (SmsListJob *)arg;
+    
+    if (job->mode == SMS_LIST_SINCE) {
+        job->count = sms_get_since(job->boundary_id, job->messages, job->limit + 1);
+    } else {
+        job->count = sms_get_page(job->boundary_id, job->messages, job->limit + 1);
+    }
+    if (job->count < 0) {
+        return -1;
+    }
+    if (job->mode != SMS_LIST_ALL && sms_get_stats(&job->stats) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static void sms_json_add_message(JsonBuilder *j, const SmsMessage *m) {
+    char time_str[32];
+    struct tm *tm_info = localtime(&m->timestamp);
+    strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", tm_info);
+    
+    json_arr_obj_open(j);
+    json_add_int(j, "id", m->id);
+    json_add_str(j, "sender", m->sender);
+    json_add_str(j, "content", m->content);
+    json_add_str(j, "timestamp", time_str);
+    json_add_bool(j, "read", m->is_read);
+    json_obj_close(j);
+}
+
+static void sms_list_done(int result, void *arg) {
+    SmsListJob *job = (SmsListJob *)arg;
+    struct mg_connection *c = http_server_find_conn(job->conn_id);
+
+    if (c && result != 0) {
+        HTTP_ERROR(c, 500, "获取短信列表失败");
+    } else if (c) {
+        int has_more = job->count > job->limit;
+        int count = has_more ? job->limit : job->count;
+        JsonBuilder *j = json_new();
+        
+        if (job->mode == SMS_LIST_ALL) {
+            json_arr_open(j, NULL);
+            for (int i = 0; i < count; i++) {
+                sms_json_add_message(j, &job->messages[i]);
+            }
+            json_arr_close(j);
+        } else {
+            json_obj_open(j);
+            json_add_str(j, "status", "ok");
+            json_arr_open(j, "messages");
+            for (int i = 0; i < count; i++) {
+                sms_json_add_message(j, &job->messages[i]);
+            }
+            json_arr_close(j);
+            json_add_bool(j, "has_more", has_more);
+            if (job->mode == SMS_LIST_PAGE) {
+                json_add_int(j, "next_before_id", count > 0 ? job->messages[count - 1].id : 0);
+            }
+            json_add_int(j, "total", job->stats.total);
+            json_add_int(j, "unread", job->stats.unread);
+            json_add_int(j, "oldest_id", job->stats.oldest_id);
+            json_add_int(j, "latest_id", job->stats.latest_id);
+            json_obj_close(j);
+        }
+        HTTP_OK_FREE(c, json_finish(j));
+    }
+
+    g_free(job->messages);
+    g_free(job);
+}
+
+/* GET /api/sms - 获取短信列表
+ *   无 before_id/limit/since_id  最新100条（数组，兼容旧版）
+ *   ?before_id=&limit=         键集分页，next_before_id 作为下一页的 before_id
+ *   ?since_id=                 只返回比 since_id 新的短信及未读数
+ */
 void handle_sms_list(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
 
-    SmsMessage messages[100];
-    int count = sms_get_list(messages, 100);
-    
-    if (count < 0) {
-        HTTP_ERROR(c, 500, "获取短信列表失败");
-        return;
+    SmsListJob *job = g_new0(SmsListJob, 1);
+    job->conn_id = c->id;
+    int limit = query_int(hm, "limit", -1);
+    job->limit = limit;
+    if (job->limit <= 0 || job->limit > SMS_PAGE_MAX) {
+        job->limit = SMS_PAGE_MAX;
+    }
+
+    /* 只有带 before_id 或 limit 才返回分页对象，其他参数（如防缓存的 ?_=）仍按旧版返回数组 */
+    int since_id = query_int(hm, "since_id", -1);
+    int before_id = query_int(hm, "before_id", -1);
+    if (since_id >= 0) {
+        job->mode = SMS_LIST_SINCE;
+        job->boundary_id = since_id;
+    } else if (before_id >= 0 || limit >= 0) {
+        job->mode = SMS_LIST_PAGE;
+        job->boundary_id = before_id;
+    } else {
+        job->mode = SMS_LIST_ALL;
     }
+    job->messages = g_new0(SmsMessage, job->limit + 1);
 
-    /* 使用JSON Builder构建数组 */
-    JsonBuilder *j = json_new();
-    json_arr_open(j, NULL);
-    
-    for (int i = 0; i < count; i++) {
-        char time_str[32];
-        struct tm *tm_info = localtime(&messages[i].timestamp);
-        strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%S", tm_info);
+    if (db_submit(DB_JOB_READ, sms_list_job, sms_list_done, job) != 0) {
+        g_free(job->messages);
+        g_free(job);
+        HTTP_ERROR(c, 503, "数据库繁忙，请稍后重试");
+    }
+}
+
+/* 异步短信搜索请求 */
+typedef struct {
+    unsigned long conn_id;
+    char query[128];
+    int box;
+    int offset;
+    int limit;
+    int count;
+    const char *engine;     /* 实际使用的搜索方式 */
+    SmsSearchHit *hits;     /* limit+1 条，多取一条用于判断 has_more */
+} SmsSearchJob;
+
+static int sms_search_job(void *arg) {
+    SmsSearchJob *job = (SmsSearchJob *)arg;
+    job->count = sms_search(job->query, job->box, job->offset, job->hits, job->limit + 1,
+                            &job->engine);
+    return job->count < 0 ? -1 : 0;
+}
+
+static void sms_search_done(int result, void *arg) {
+    SmsSearchJob *job = (SmsSearchJob *)arg;
+    struct mg_connection *c = http_server_find_conn(job->conn_id);
+
+    if (c && result != 0) {
+        HTTP_ERROR(c, 500, "搜索短信失败");
+    } else if (c) {
+        int has_more = job->count > job->limit;
+        int count = has_more ? job->limit : job->count;
         
-        json_arr_obj_open(j);
-        json_add_int(j, "id", messages[i].id);
-        json_add_str(j, "sender", messages[i].sender);
-        json_add_str(j, "content", messages[i].content);
-        json_add_str(j, "timestamp", time_str);
-        json_add_bool(j, "read", messages[i].is_read);
+        JsonBuilder *j = json_new();
+        json_obj_open(j);
+        json_add_str(j, "status", "ok");
+        json_add_str(j, "engine", job->engine ? job->engine : sms_search_engine());
+        json_arr_open(j, "results");
+        for (int i = 0; i < count; i++) {
+            SmsSearchHit *h = &job->hits[i];
+            json_arr_obj_open(j);
+            json_add_int(j, "id", h->id);
+            json_add_str(j, "box", h->box == SMS_BOX_SENT ? "sent" : "inbox");
+            json_add_str(j, "peer", h->peer);
+            json_add_str(j, "content", h->content);
+            json_add_long(j, "timestamp", (long long)h->timestamp);
+            json_obj_close(j);
+        }
+        json_arr_close(j);
+        json_add_bool(j, "has_more", has_more);
+        json_add_int(j, "next_offset", job->offset + count);
         json_obj_close(j);
+        HTTP_OK_FREE(c, json_finish(j));
     }
+
+    g_free(job->hits);
+    g_free(job);
+}
+
+/* GET /api/sms/search?q=&box=inbox|sent|all&offset=&limit= - 全文搜索短信 */
+void handle_sms_search(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    char query[128] = {0};
+    char box[16] = {0};
     
-    json_arr_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
+    if (mg_http_get_var(&hm->query, "q", query, sizeof(query)) <= 0) {
+        HTTP_ERROR(c, 400, "搜索词不能为空");
+        return;
+    }
+    mg_http_get_var(&hm->query, "box", box, sizeof(box));
+
+    SmsSearchJob *job = g_new0(SmsSearchJob, 1);
+    job->conn_id = c->id;
+    snprintf(job->query, sizeof(job->query), "%s", query);
+    job->box = strcmp(box, "inbox") == 0 ? SMS_BOX_INBOX :
+               strcmp(box, "sent") == 0 ? SMS_BOX_SENT : SMS_BOX_ALL;
+    job->offset = query_int(hm, "offset", 0);
+    if (job->offset < 0) {
+        job->offset = 0;
+    }
+    job->limit = query_int(hm, "limit", 20);
+    if (job->limit <= 0 || job->limit > SMS_SEARCH_MAX) {
+        job->limit = SMS_SEARCH_MAX;
+    }
+    job->hits = g_new0(SmsSearchHit, job->limit + 1);
+
+    if (db_submit(DB_JOB_READ, sms_search_job, sms_search_done, job) != 0) {
+        g_free(job->hits);
+        g_free(job);
+        HTTP_ERROR(c, 503, "数据库繁忙，请稍后重试");
+    }
 }
 
 /* POST /api/sms/send - 发送短信 */
@@ -625,33 +1091,63 @@ void handle_sms_webhook_test(struct mg_connection *c, struct mg_http_message *hm
     }
 }
 
+/* 异步发送记录列表请求 */
+typedef struct {
+    unsigned long conn_id;
+    int max_count;
+    int count;
+    SentSmsMessage *messages;
+} SentListJob;
+
+static int sms_sent_list_job(void *arg) {
+    SentListJob *job = (SentListJob *)arg;
+    job->count = sms_get_sent_list(job->messages, job->max_count);
+    return job->count < 0 ? -1 : 0;
+}
+
+static void sms_sent_list_done(int result, void *arg) {
+    SentListJob *job = (SentListJob *)arg;
+    struct mg_connection *c = http_server_find_conn(job->conn_id);
+
+    if (c && result != 0) {
+        HTTP_ERROR(c, 500, "获取发送记录失败");
+    } else if (c) {
+        JsonBuilder *j = json_new();
+        json_arr_open(j, NULL);
+        
+        for (int i = 0; i < job->count; i++) {
+            SentSmsMessage *m = &job->messages[i];
+            json_arr_obj_open(j);
+            json_add_int(j, "id", m->id);
+            json_add_str(j, "recipient", m->recipient);
+            json_add_str(j, "content", m->content);
+            json_add_long(j, "timestamp", (long long)m->timestamp);
+            json_add_str(j, "status", m->status);
+            json_obj_close(j);
+        }
+        
+        json_arr_close(j);
+        HTTP_OK_FREE(c, json_finish(j));
+    }
+
+    g_free(job->messages);
+    g_free(job);
+}
+
 /* GET /api/sms/sent - 获取发送记录列表 */
 void handle_sms_sent_list(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
 
-    SentSmsMessage messages[150];
-    int count = sms_get_sent_list(messages, 150);
-    
-    if (count < 0) {
-        HTTP_ERROR(c, 500, "获取发送记录失败");
-        return;
-    }
+    SentListJob *job = g_new0(SentListJob, 1);
+    job->conn_id = c->id;
+    job->max_count = 150;
+    job->messages = g_new0(SentSmsMessage, job->max_count);
 
-    JsonBuilder *j = json_new();
-    json_arr_open(j, NULL);
-    
-    for (int i = 0; i < count; i++) {
-        json_arr_obj_open(j);
-        json_add_int(j, "id", messages[i].id);
-        json_add_str(j, "recipient", messages[i].recipient);
-        json_add_str(j, "content", messages[i].content);
-        json_add_long(j, "timestamp", (long long)messages[i].timestamp);
-        json_add_str(j, "status", messages[i].status);
-        json_obj_close(j);
+    if (db_submit(DB_JOB_READ, sms_sent_list_job, sms_sent_list_done, job) != 0) {
+        g_free(job->messages);
+        g_free(job);
+        HTTP_ERROR(c, 503, "数据库繁忙，请稍后重试");
     }
-    
-    json_arr_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
 }
 
 /* GET /api/sms/config - 获取短信配置 */
@@ -785,6 +1281,11 @@ void handle_update_upload(struct mg_connection *c, struct mg_http_message *hm) {
     struct mg_http_part part;
     size_t ofs = 0;
     
+    if (update_is_busy()) {
+        HTTP_ERROR(c, 409, "更新任务正在执行，请稍后重试");
+        return;
+    }
+    
     while ((ofs = mg_http_next_multipart(hm->body, ofs, &part)) > 0) {
         if (part.filename.len > 0) {
             update_cleanup();
@@ -813,6 +1314,19 @@ void handle_update_upload(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_ERROR(c, 400, "未找到上传文件");
 }
 
+static void update_download_done(int result, const char *output, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    (void)output;
+    if (!c) {
+        return;
+    }
+    if (result == 0) {
+        HTTP_SUCCESS(c, "下载成功");
+    } else {
+        HTTP_ERROR(c, 500, "下载失败");
+    }
+}
+
 /* POST /api/update/download - 从URL下载更新包 */
 void handle_update_download(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
@@ -826,74 +1340,125 @@ void handle_update_download(struct mg_connection *c, struct mg_http_message *hm)
         return;
     }
 
-    if (update_download(url) == 0) {
-        HTTP_SUCCESS(c, "下载成功");
-    } else {
+    if (update_is_busy()) {
+        HTTP_ERROR(c, 409, "更新任务正在执行，请稍后重试");
+        return;
+    }
+
+    if (update_download_async(url, update_download_done, GSIZE_TO_POINTER(c->id)) != 0) {
         HTTP_ERROR(c, 500, "下载失败");
     }
 }
 
+static void update_extract_done(int result, const char *output, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    (void)output;
+    if (!c) {
+        return;
+    }
+    if (result == 0) {
+        HTTP_SUCCESS(c, "解压成功");
+    } else {
+        HTTP_ERROR(c, 500, "解压失败");
+    }
+}
+
 /* POST /api/update/extract - 解压更新包 */
 void handle_update_extract(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
 
-    if (update_extract() == 0) {
-        HTTP_SUCCESS(c, "解压成功");
-    } else {
+    if (update_is_busy()) {
+        HTTP_ERROR(c, 409, "更新任务正在执行，请稍后重试");
+        return;
+    }
+
+    if (update_extract_async(update_extract_done, GSIZE_TO_POINTER(c->id)) != 0) {
         HTTP_ERROR(c, 500, "解压失败");
     }
 }
 
-/* POST /api/update/install - 执行安装并重启 */
-void handle_update_install(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_POST(c, hm);
+static gboolean update_reboot_cb(gpointer user_data) {
+    (void)user_data;
+    device_reboot();
+    return G_SOURCE_REMOVE;
+}
 
-    char output[2048] = {0};
-    
-    if (update_install(output, sizeof(output)) == 0) {
+static void update_install_done(int result, const char *output, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+
+    if (result == 0) {
+        if (c) {
+            JsonBuilder *j = json_new();
+            json_obj_open(j);
+            json_add_str(j, "status", "success");
+            json_add_str(j, "message", "安装成功，正在重启...");
+            json_add_str(j, "output", output);
+            json_obj_close(j);
+            HTTP_OK_FREE(c, json_finish(j));
+            c->is_draining = 1;
+        }
+        /* 留出时间把响应发送出去再重启 */
+        g_timeout_add_seconds(2, update_reboot_cb, NULL);
+    } else if (c) {
         JsonBuilder *j = json_new();
         json_obj_open(j);
-        json_add_str(j, "status", "success");
-        json_add_str(j, "message", "安装成功，正在重启...");
+        json_add_str(j, "error", "安装失败");
         json_add_str(j, "output", output);
         json_obj_close(j);
-        HTTP_OK_FREE(c, json_finish(j));
-        c->is_draining = 1;
-        sleep(2);
-        device_reboot();
-    } else {
+        HTTP_JSON_FREE(c, 500, json_finish(j));
+    }
+}
+
+/* POST /api/update/install - 执行安装并重启 */
+void handle_update_install(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_POST(c, hm);
+
+    if (update_is_busy()) {
+        HTTP_ERROR(c, 409, "更新任务正在执行，请稍后重试");
+        return;
+    }
+
+    if (update_install_async(update_install_done, GSIZE_TO_POINTER(c->id)) != 0) {
         JsonBuilder *j = json_new();
         json_obj_open(j);
         json_add_str(j, "error", "安装失败");
-        json_add_str(j, "output", output);
+        json_add_str(j, "output", "安装脚本不存在");
         json_obj_close(j);
         HTTP_JSON_FREE(c, 500, json_finish(j));
     }
 }
 
+static void update_check_done(int result, const update_info_t *info, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    if (!c) {
+        return;
+    }
+    if (result != 0) {
+        HTTP_ERROR(c, 500, "检查版本失败");
+        return;
+    }
+
+    const char *current = update_get_version();
+    int has_update = strcmp(info->version, current) > 0 ? 1 : 0;
+    
+    JsonBuilder *j = json_new();
+    json_obj_open(j);
+    json_add_str(j, "current_version", current);
+    json_add_str(j, "latest_version", info->version);
+    json_add_bool(j, "has_update", has_update);
+    json_add_str(j, "url", info->url);
+    json_add_str(j, "changelog", info->changelog);
+    json_add_ulong(j, "size", (unsigned long)info->size);
+    json_add_bool(j, "required", info->required);
+    json_obj_close(j);
+    HTTP_OK_FREE(c, json_finish(j));
+}
+
 /* GET /api/update/check - 检查远程版本 */
 void handle_update_check(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_ANY(c, hm);
 
-    const char *check_url = UPDATE_CHECK_URL;
-
-    update_info_t info;
-    if (update_check_version(check_url, &info) == 0) {
-        const char *current = update_get_version();
-        int has_update = strcmp(info.version, current) > 0 ? 1 : 0;
-        
-        JsonBuilder *j = json_new();
-        json_obj_open(j);
-        json_add_str(j, "current_version", current);
-        json_add_str(j, "latest_version", info.version);
-        json_add_bool(j, "has_update", has_update);
-        json_add_str(j, "url", info.url);
-        json_add_str(j, "changelog", info.changelog);
-        json_add_ulong(j, "size", (unsigned long)info.size);
-        json_add_bool(j, "required", info.required);
-        json_obj_close(j);
-        HTTP_OK_FREE(c, json_finish(j));
-    } else {
+    if (update_check_version_async(UPDATE_CHECK_URL, update_check_done, GSIZE_TO_POINTER(c->id)) != 0) {
         HTTP_ERROR(c, 500, "检查版本失败");
     }
 }
@@ -943,8 +1508,9 @@ void handle_set_system_time(struct mg_connection *c, struct mg_http_message *hm)
     int success = 0;
     const char *used_server = NULL;
     
+    /* 每个服务器最多等待15秒，避免不可达时阻塞事件循环 */
     for (int i = 0; ntp_servers[i] != NULL; i++) {
-        if (run_command(output, sizeof(output), "ntpdate", ntp_servers[i], NULL) == 0) {
+        if (run_command_timeout(15, output, sizeof(output), "ntpdate", ntp_servers[i], NULL) == EXEC_OK) {
             success = 1;
             used_server = ntp_servers[i];
             break;
@@ -1207,6 +1773,26 @@ void handle_roaming_status(struct mg_connection *c, struct mg_http_message *hm)
 #include "plugin.h"
 
 /* POST /api/shell - 执行Shell命令 */
+static void shell_execute_done(int result, const char *output, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    if (!c) {
+        return;
+    }
+
+    JsonBuilder *j = json_new();
+    json_obj_open(j);
+    if (result == EXEC_OK || result == EXEC_TRUNCATED) {
+        json_add_int(j, "Code", 0);
+        json_add_str(j, "Error", "");
+    } else {
+        json_add_int(j, "Code", 1);
+        json_add_str(j, "Error", result == EXEC_TIMEOUT ? "命令执行超时" : "命令执行失败");
+    }
+    json_add_str(j, "Data", output);
+    json_obj_close(j);
+    HTTP_OK_FREE(c, json_finish(j));
+}
+
 void handle_shell_execute(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
 
@@ -1222,21 +1808,15 @@ void handle_shell_execute(struct mg_connection *c, struct mg_http_message *hm) {
         return;
     }
 
-    char output[8192] = {0};
+    if (!is_command_safe(cmd)) {
+        HTTP_OK(c, "{\"Code\":1,\"Error\":\"命令执行失败\",\"Data\":\"Error: Command blocked for security reasons\"}");
+        return;
+    }
 
-    JsonBuilder *j = json_new();
-    json_obj_open(j);
-    if (execute_shell(cmd, output, sizeof(output)) == 0) {
-        json_add_int(j, "Code", 0);
-        json_add_str(j, "Error", "");
-        json_add_str(j, "Data", output);
-    } else {
-        json_add_int(j, "Code", 1);
-        json_add_str(j, "Error", "命令执行失败");
-        json_add_str(j, "Data", output);
+    /* 命令在子进程中异步执行，完成后按连接ID回复 */
+    if (execute_shell_async(cmd, shell_execute_done, GSIZE_TO_POINTER(c->id)) != 0) {
+        HTTP_OK(c, "{\"Code\":1,\"Error\":\"命令执行失败\",\"Data\":\"Error: Failed to execute command\"}");
     }
-    json_obj_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
 }
 
 /* GET /api/plugins - 获取插件列表 */
@@ -1740,7 +2320,7 @@ void handle_auth_login(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
 
     char password[128] = {0};
-    char token[AUTH_TOKEN_SIZE] = {0};
+    char token[AUTH_TOKEN_MAX_LEN] = {0};
     
     /* 解析密码 */
     char *pwd_str = mg_json_get_str(hm->body, "$.password");
@@ -1778,7 +2358,7 @@ void handle_auth_logout(struct mg_connection *c, struct mg_http_message *hm) {
 
     /* 从Authorization头获取token */
     struct mg_str *auth_header = mg_http_get_header(hm, "Authorization");
-    char token[AUTH_TOKEN_SIZE] = {0};
+    char token[AUTH_TOKEN_MAX_LEN] = {0};
     
     if (auth_header && auth_header->len > 7) {
         /* 格式: "Bearer <token>" */
@@ -1852,15 +2432,12 @@ void handle_auth_status(struct mg_connection *c, struct mg_http_message *hm) {
     
     if (auth_header && auth_header->len > 7) {
         if (strncmp(auth_header->buf, "Bearer ", 7) == 0) {
-            char token[AUTH_TOKEN_SIZE] = {0};
+            char token[AUTH_TOKEN_MAX_LEN] = {0};
             size_t token_len = auth_header->len - 7;
             if (token_len < sizeof(token)) {
                 memcpy(token, auth_header->buf + 7, token_len);
                 token[token_len] = '\0';
-                
-                if (auth_verify_token(token) == 0) {
-                    logged_in = 1;
-                }
+                auth_get_status(token, &logged_in);
             }
         }
     }
@@ -1869,10 +2446,45 @@ void handle_auth_status(struct mg_connection *c, struct mg_http_message *hm) {
     json_obj_open(j);
     json_add_bool(j, "logged_in", logged_in);
     json_add_bool(j, "auth_required", required);
+    json_add_str(j, "token_mode", auth_get_token_mode() == AUTH_MODE_STATELESS ? "stateless" : "table");
     json_obj_close(j);
     HTTP_OK_FREE(c, json_finish(j));
 }
 
+/* GET/POST /api/auth/mode - 查询/设置Token模式（table/stateless） */
+void handle_auth_mode(struct mg_connection *c, struct mg_http_message *hm) {
+    if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
+        JsonBuilder *j = json_new();
+        json_obj_open(j);
+        json_add_str(j, "status", "ok");
+        json_add_str(j, "mode", auth_get_token_mode() == AUTH_MODE_STATELESS ? "stateless" : "table");
+        json_obj_close(j);
+        HTTP_OK_FREE(c, json_finish(j));
+        return;
+    }
+    
+    HTTP_CHECK_POST(c, hm);
+    
+    int mode = -1;
+    char *mode_str = mg_json_get_str(hm->body, "$.mode");
+    if (mode_str) {
+        if (strcmp(mode_str, "table") == 0) mode = AUTH_MODE_TABLE;
+        else if (strcmp(mode_str, "stateless") == 0) mode = AUTH_MODE_STATELESS;
+        free(mode_str);
+    }
+    
+    if (mode < 0) {
+        HTTP_ERROR(c, 400, "mode必须为table或stateless");
+        return;
+    }
+    
+    if (auth_set_token_mode(mode) == 0) {
+        HTTP_SUCCESS(c, "Token模式已更新");
+    } else {
+        HTTP_ERROR(c, 500, "设置Token模式失败");
+    }
+}
+
 /* ==================== APN 配置管理 ==================== */
 
 /* GET /api/apn/config - 获取APN配置 */
@@ -22,6 +22,13 @@
 #include "http_utils.h"
 #include "auth.h"
 #include "apn.h"
+#include "db_worker.h"
+#include "terminal.h"
+#include "sysinfo_collector.h"
+#include "cpu_monitor.h"
+#include "at_scheduler.h"
+#include "at_batch.h"
+#include "ofono_bus.h"
 
 /* 嵌入式文件系统声明 (packed_fs.c) */
 extern int serve_packed_file(struct mg_connection *c, struct mg_http_message *hm);
@@ -62,7 +69,7 @@ static int verify_request_token(struct mg_http_message *hm) {
         return -1;
     }
     
-    char token[65] = {0};
+    char token[AUTH_TOKEN_MAX_LEN] = {0};
     size_t token_len = auth_header->len - 7;
     if (token_len >= sizeof(token)) {
         return -1;
@@ -74,6 +81,20 @@ static int verify_request_token(struct mg_http_message *hm) {
     return auth_verify_token(token);
 }
 
+/**
+ * 验证URL参数中的Token（浏览器WebSocket无法设置Authorization头）
+ * @return 0验证通过，-1验证失败
+ */
+static int verify_query_token(struct mg_http_message *hm) {
+    char token[AUTH_TOKEN_MAX_LEN] = {0};
+    
+    if (mg_http_get_var(&hm->query, "token", token, sizeof(token)) <= 0) {
+        return -1;
+    }
+    
+    return auth_verify_token(token);
+}
+
 
 /* HTTP 事件处理函数 */
 static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
@@ -108,6 +129,16 @@ static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
             return;
         }
 
+        /* Web终端 WebSocket - Token 通过URL参数传递 */
+        if (mg_match(hm->uri, mg_str("/api/terminal/ws"), NULL)) {
+            if (verify_query_token(hm) != 0) {
+                HTTP_JSON(c, 401, "{\"status\":\"error\",\"message\":\"未授权，请先登录\"}");
+                return;
+            }
+            handle_terminal_ws(c, hm);
+            return;
+        }
+
         /* 认证中间件 - 检查Token */
         if (!is_auth_whitelist(uri)) {
             if (verify_request_token(hm) != 0) {
@@ -120,9 +151,15 @@ static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
         if (mg_match(hm->uri, mg_str("/api/info"), NULL)) {
             handle_info(c, hm);
         }
+        else if (mg_match(hm->uri, mg_str("/api/cpu"), NULL)) {
+            handle_cpu_stats(c, hm);
+        }
         else if (mg_match(hm->uri, mg_str("/api/at"), NULL)) {
             handle_execute_at(c, hm);
         }
+        else if (mg_match(hm->uri, mg_str("/api/at/stats"), NULL)) {
+            handle_at_stats(c, hm);
+        }
         else if (mg_match(hm->uri, mg_str("/api/set_network"), NULL)) {
             handle_set_network(c, hm);
         }
@@ -201,6 +238,9 @@ static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
         else if (mg_match(hm->uri, mg_str("/api/sms"), NULL)) {
             handle_sms_list(c, hm);
         }
+        else if (mg_match(hm->uri, mg_str("/api/sms/search"), NULL)) {
+            handle_sms_search(c, hm);
+        }
         else if (mg_match(hm->uri, mg_str("/api/sms/send"), NULL)) {
             handle_sms_send(c, hm);
         }
@@ -282,6 +322,9 @@ static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
         //         handle_apn_set(c, hm);
         //     }
         // }
+        else if (mg_match(hm->uri, mg_str("/api/auth/mode"), NULL)) {
+            handle_auth_mode(c, hm);
+        }
         /* APN 配置管理 API */
         else if (mg_match(hm->uri, mg_str("/api/apn/config"), NULL)) {
             if (hm->method.len == 3 && memcmp(hm->method.buf, "GET", 3) == 0) {
@@ -359,6 +402,18 @@ static void http_handler(struct mg_connection *c, int ev, void *ev_data) {
             HTTP_ERROR(c, 404, "Endpoint not found");
         }
     }
+    /* WebSocket 事件 - 目前只有Web终端 */
+    else if (ev == MG_EV_WS_MSG) {
+        terminal_ws_message(c, (struct mg_ws_message *)ev_data);
+    }
+    else if (c->is_websocket && (ev == MG_EV_WRITE || ev == MG_EV_POLL)) {
+        terminal_ws_poll(c);
+    }
+    else if (ev == MG_EV_CLOSE) {
+        /* 客户端断开: 停止为它排队的 AT 查询，释放它的终端会话（按连接ID查找，无会话时忽略） */
+        at_batch_abort_owner(c->id);
+        terminal_ws_close(c);
+    }
 }
 
 
@@ -381,6 +436,11 @@ int http_server_start(const char *port) {
         printf("警告: 短信模块初始化失败\n");
     }
 
+    /* 启动数据库工作线程（数据库已由短信模块初始化） */
+    if (db_worker_start() != 0) {
+        printf("警告: 数据库工作线程启动失败，数据库任务将同步执行\n");
+    }
+
     /* 初始化认证模块 */
     if (auth_init() != 0) {
         printf("警告: 认证模块初始化失败\n");
@@ -391,6 +451,16 @@ int http_server_start(const char *port) {
         printf("警告: APN模块初始化失败\n");
     }
 
+    /* CPU 使用率定时采样 */
+    if (cpu_monitor_start() != 0) {
+        printf("警告: CPU 使用率监控启动失败\n");
+    }
+
+    /* 启动系统信息后台采集（依赖 D-Bus） */
+    if (sysinfo_collector_start() != 0) {
+        printf("警告: 系统信息采集线程启动失败，/api/info 将同步采集\n");
+    }
+
     /* 初始化 mongoose */
     mg_mgr_init(&g_mgr);
 
@@ -416,12 +486,27 @@ int http_server_start(const char *port) {
 
 void http_server_stop(void) {
     g_running = 0;
+    terminal_shutdown();
+    sysinfo_collector_stop();
+    cpu_monitor_stop();
     mg_mgr_free(&g_mgr);
+    db_worker_stop();
     sms_deinit();
+    at_scheduler_stop();
     close_dbus();
+    ofono_bus_close();
     printf("服务器已停止\n");
 }
 
+struct mg_connection *http_server_find_conn(unsigned long id) {
+    for (struct mg_connection *c = g_mgr.conns; c != NULL; c = c->next) {
+        if (c->id == id) {
+            return (c->is_closing || c->is_draining) ? NULL : c;
+        }
+    }
+    return NULL;
+}
+
 void http_server_run(void) {
     GMainContext *context = g_main_context_default();
     static int maintenance_counter = 0;
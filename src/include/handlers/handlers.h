@@ -14,7 +14,9 @@ extern "C" {
 
 /* API 处理器 */
 void handle_info(struct mg_connection *c, struct mg_http_message *hm);
+void handle_cpu_stats(struct mg_connection *c, struct mg_http_message *hm);
 void handle_execute_at(struct mg_connection *c, struct mg_http_message *hm);
+void handle_at_stats(struct mg_connection *c, struct mg_http_message *hm);
 void handle_set_network(struct mg_connection *c, struct mg_http_message *hm);
 void handle_switch(struct mg_connection *c, struct mg_http_message *hm);
 void handle_airplane_mode(struct mg_connection *c, struct mg_http_message *hm);
@@ -25,6 +27,7 @@ void handle_get_current_band(struct mg_connection *c, struct mg_http_message *hm
 /* 短信 API */
 void handle_sms_list(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_send(struct mg_connection *c, struct mg_http_message *hm);
+void handle_sms_search(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_delete(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_webhook_get(struct mg_connection *c, struct mg_http_message *hm);
 void handle_sms_webhook_save(struct mg_connection *c, struct mg_http_message *hm);
@@ -89,6 +92,7 @@ void handle_auth_login(struct mg_connection *c, struct mg_http_message *hm);
 void handle_auth_logout(struct mg_connection *c, struct mg_http_message *hm);
 void handle_auth_password(struct mg_connection *c, struct mg_http_message *hm);
 void handle_auth_status(struct mg_connection *c, struct mg_http_message *hm);
+void handle_auth_mode(struct mg_connection *c, struct mg_http_message *hm);
 
 #ifdef __cplusplus
 }
@@ -10,6 +10,8 @@
 extern "C" {
 #endif
 
+struct mg_connection;
+
 /**
  * @brief 启动 HTTP 服务器
  * @param port 监听端口 (如 "80" 或 "8080")
@@ -27,6 +29,14 @@ void http_server_stop(void);
  */
 void http_server_run(void);
 
+/**
+ * @brief 按ID查找连接，用于异步任务完成后延迟回复
+ * 异步任务只应保存 c->id 而不是连接指针，客户端可能在任务完成前断开
+ * @param id 连接ID (c->id)
+ * @return 连接指针，已断开或正在关闭返回 NULL
+ */
+struct mg_connection *http_server_find_conn(unsigned long id);
+
 #ifdef __cplusplus
 }
 #endif
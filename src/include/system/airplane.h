@@ -11,7 +11,7 @@ extern "C" {
 #endif
 
 /**
- * @brief 通过 D-Bus 发送 AT 命令 (简单版本)
+ * @brief 发送 AT 命令（经 AT 调度器，查询按后台优先级）
  * @param cmd AT 命令
  * @param result 返回结果 (调用者需 g_free)
  * @return 0 成功, -1 失败
@@ -0,0 +1,106 @@
+/**
+ * @file at_batch.h
+ * @brief 异步 AT 命令序列
+ *
+ * HTTP 处理函数把要执行的 AT 命令（可带步骤间隔）加入序列后立即返回，
+ * 序列经 execute_at_async 依次执行，全部完成后在主循环中回调，
+ * 处理函数在回调中用保存的 c->id 找回连接并回复，主循环不再被 modem 应答阻塞。
+ *
+ * 客户端提前断开时调用 at_batch_abort_owner：只含查询命令的序列取消排队中的命令并
+ * 立即结束；含写命令的序列继续执行完（中途停止可能让射频保持关闭），只是不再回复。
+ *
+ * 所有函数只能在主循环线程中调用。
+ */
+
+#ifndef AT_BATCH_H
+#define AT_BATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 单个序列最多的命令数 */
+#define AT_BATCH_MAX_STEPS   8
+
+/* 步骤标志: 失败时跳过后续命令 */
+#define AT_BATCH_REQUIRED    0x1
+
+typedef struct AtBatch AtBatch;
+
+/**
+ * 序列结束回调（在主循环中执行，恰好调用一次，包括被中止的情况）
+ * 回调返回后序列自动释放
+ * @param batch 序列，可读取各步骤的结果
+ * @param user_data 用户数据
+ */
+typedef void (*AtBatchDoneFunc)(AtBatch *batch, void *user_data);
+
+/**
+ * @brief 创建序列
+ * @return 序列
+ */
+AtBatch *at_batch_new(void);
+
+/**
+ * @brief 添加命令
+ * @param batch 序列
+ * @param command AT 命令（复制保存）
+ * @param flags 0 或 AT_BATCH_REQUIRED
+ * @param delay_ms 本条完成后到下一条开始的间隔
+ * @return 步骤下标, -1 已满
+ */
+int at_batch_add(AtBatch *batch, const char *command, int flags, int delay_ms);
+
+/**
+ * @brief 开始执行，完成后调用 done 并释放序列
+ * @param batch 序列
+ * @param owner 所属连接 ID (c->id)，用于断开时中止
+ * @param done 完成回调
+ * @param user_data 用户数据
+ */
+void at_batch_run_async(AtBatch *batch, unsigned long owner, AtBatchDoneFunc done, void *user_data);
+
+/**
+ * @brief 释放未执行的序列
+ */
+void at_batch_free(AtBatch *batch);
+
+/**
+ * @brief 中止连接的序列（连接关闭时调用）
+ * @param owner 连接 ID
+ */
+void at_batch_abort_owner(unsigned long owner);
+
+/**
+ * @brief 步骤执行结果
+ * @return 0 成功, -1 失败或未执行
+ */
+int at_batch_rc(AtBatch *batch, int index);
+
+/**
+ * @brief 步骤应答（失败或未执行时为 NULL）
+ */
+const char *at_batch_result(AtBatch *batch, int index);
+
+/**
+ * @brief 步骤错误信息（成功时为 NULL）
+ */
+const char *at_batch_error(AtBatch *batch, int index);
+
+/**
+ * @brief 导致序列提前结束的 AT_BATCH_REQUIRED 步骤
+ * @return 步骤下标, -1 没有
+ */
+int at_batch_failed_step(AtBatch *batch);
+
+/**
+ * @brief 序列是否因连接断开被中止
+ * @return 1 是, 0 否
+ */
+int at_batch_aborted(AtBatch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AT_BATCH_H */
@@ -0,0 +1,65 @@
+/**
+ * @file at_cache.h
+ * @brief AT 命令结果缓存
+ *
+ * 前端多个页面/标签页以 5~10 秒周期轮询同样的只读查询命令（工程模式小区信息、
+ * 频段锁定状态等），每次都要占用 modem 串行执行。只读查询命令的成功结果按命令
+ * 字符串缓存一段时间，在有效期内直接返回；写命令执行后使受影响的缓存失效。
+ */
+
+#ifndef AT_CACHE_H
+#define AT_CACHE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 缓存有效期 (ms)，0 表示不缓存 */
+#define AT_CACHE_TTL_ENGMODE_MS   4000      /* AT+SPENGMD=0,... 小区/服务小区信息 */
+#define AT_CACHE_TTL_BAND_MS      30000     /* AT+SPLBAND=0/3 频段锁定状态（写命令会使其失效） */
+#define AT_CACHE_TTL_QOS_MS       5000      /* AT+CGEQOSRDP QoS 参数 */
+
+/* 最多缓存的命令数，超出时先清理过期项，仍然满则全部清空 */
+#define AT_CACHE_MAX_ENTRIES      32
+
+/**
+ * @brief 查找未过期的缓存结果
+ * @param command AT 命令
+ * @param result 命中时输出结果副本（调用者需用 g_free 释放）
+ * @return 0 命中, -1 未命中或该命令不可缓存
+ */
+int at_cache_lookup(const char *command, char **result);
+
+/**
+ * @brief 命令执行后更新缓存
+ * 可缓存的查询命令保存成功结果；非查询命令视为写命令，使受影响的缓存失效
+ * （写命令失败也同样处理，modem 状态可能已部分改变）
+ * @param command AT 命令
+ * @param result 执行结果，失败时为 NULL
+ */
+void at_cache_update(const char *command, const char *result);
+
+/**
+ * @brief 判断是否为只读查询命令（不改变 modem 状态，可以合并并发请求）
+ * @param command AT 命令
+ * @return 1 是, 0 否
+ */
+int at_cache_is_query(const char *command);
+
+/**
+ * @brief 生成命令的规范化键（去除首尾空白并转为大写）
+ * @param command AT 命令
+ * @return 新分配的字符串（调用者需用 g_free 释放）
+ */
+char *at_cache_key(const char *command);
+
+/**
+ * @brief 清空缓存（通过 D-Bus 属性切换网络模式/卡槽/飞行模式后调用）
+ */
+void at_cache_invalidate_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AT_CACHE_H */
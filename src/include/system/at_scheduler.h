@@ -0,0 +1,147 @@
+/**
+ * @file at_scheduler.h
+ * @brief AT 命令调度器
+ *
+ * 由一个调度线程独占 modem 的 AT 通道，请求按优先级排队：
+ * 用户写命令 > 用户查询 > 后台轮询，同优先级先进先出。
+ * 每个请求带截止时间，可取消；失败按错误类型退避重试
+ * （modem 忙指数退避，连接断开重连后重试，写命令超时不重试）。
+ * 只读查询与正在发送或同等及更高优先级排队中的相同查询合并，共用一次 modem 往返的结果。
+ */
+
+#ifndef AT_SCHEDULER_H
+#define AT_SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 请求优先级（数值越小越优先） */
+typedef enum {
+    AT_PRIO_WRITE = 0,      /* 用户发起的写命令（锁频、锁小区等） */
+    AT_PRIO_READ,           /* 用户发起的查询 */
+    AT_PRIO_BACKGROUND,     /* 后台轮询 */
+    AT_PRIO_COUNT
+} AtPriority;
+
+/* 单次发送结果（由传输函数根据 D-Bus 错误分类） */
+typedef enum {
+    AT_SEND_OK = 0,
+    AT_SEND_BUSY,           /* modem 正在执行其他操作，退避后重试 */
+    AT_SEND_DISCONNECTED,   /* D-Bus 连接断开或 oFono 不可用，重连后重试 */
+    AT_SEND_TIMEOUT,        /* 调用超时，命令可能已执行 */
+    AT_SEND_ERROR           /* 其他错误，不重试 */
+} AtSendStatus;
+
+/* 请求结果 */
+#define AT_SCHED_OK          0
+#define AT_SCHED_ERROR      -1
+#define AT_SCHED_CANCELLED  -2
+#define AT_SCHED_EXPIRED    -3      /* 截止时间前未能完成 */
+
+/* 默认截止时间 (ms)，从提交时开始计算 */
+#define AT_SCHED_DEADLINE_MS             15000
+#define AT_SCHED_DEADLINE_BACKGROUND_MS  30000
+
+/* 单次发送超时上限 (ms)，不超过请求剩余时间 */
+#define AT_SCHED_SEND_TIMEOUT_MS         8000
+
+/* 重试: 最多发送次数，modem 忙时的初始/最大退避，重连退避 */
+#define AT_SCHED_MAX_ATTEMPTS            4
+#define AT_SCHED_BUSY_BACKOFF_MS         200
+#define AT_SCHED_BUSY_BACKOFF_MAX_MS     2000
+#define AT_SCHED_RECONNECT_BACKOFF_MS    1000
+
+/**
+ * @brief 发送一条 AT 命令并等待应答
+ * @param command AT 命令
+ * @param timeout_ms 超时
+ * @param result 成功时输出应答（调用者需用 g_free 释放）
+ * @param error 失败时输出错误信息（调用者需用 g_free 释放）
+ * @return 发送结果
+ */
+typedef AtSendStatus (*AtTransportFunc)(const char *command, int timeout_ms, char **result, char **error);
+
+/**
+ * @brief 请求完成回调（在调度线程中调用；取消排队中的请求时在调用取消的线程中调用）
+ * @param rc AT_SCHED_OK / AT_SCHED_ERROR / AT_SCHED_CANCELLED / AT_SCHED_EXPIRED
+ * @param result 应答，仅在 AT_SCHED_OK 时有效，回调返回后释放
+ * @param error 错误信息，仅在失败时有效，回调返回后释放
+ * @param user_data 用户数据
+ */
+typedef void (*AtDoneFunc)(int rc, const char *result, const char *error, void *user_data);
+
+/* 单个优先级的统计 */
+typedef struct {
+    int depth;                          /* 当前排队数 */
+    int max_depth;                      /* 排队数峰值 */
+    unsigned long submitted;
+    unsigned long completed;            /* 成功 */
+    unsigned long failed;
+    unsigned long expired;
+    unsigned long cancelled;
+    unsigned long retries;              /* 重试发送次数 */
+    unsigned long coalesced;            /* 合并到相同查询、未单独发送的请求数 */
+    double avg_wait_ms;                 /* 提交到首次发送的平均等待 */
+    long long max_wait_ms;
+    double avg_exec_ms;                 /* 每次发送的平均耗时 */
+} AtSchedulerPrioStats;
+
+typedef struct {
+    int running;
+    AtSchedulerPrioStats prio[AT_PRIO_COUNT];
+} AtSchedulerStats;
+
+/**
+ * @brief 启动调度线程（已启动时直接返回成功）
+ * @param send 传输函数
+ * @return 0 成功, -1 失败
+ */
+int at_scheduler_start(AtTransportFunc send);
+
+/**
+ * @brief 停止调度线程，等待正在发送的命令结束，排队中的请求以 AT_SCHED_CANCELLED 结束
+ */
+void at_scheduler_stop(void);
+
+/**
+ * @brief 提交请求（异步）
+ * @param command AT 命令
+ * @param prio 优先级
+ * @param deadline_ms 截止时间（从现在起），<=0 使用默认值
+ * @param done 完成回调（必须非 NULL，恰好调用一次）
+ * @param user_data 用户数据
+ * @return 请求 ID (>0), 0 调度器未运行（此时不会调用 done）
+ */
+unsigned int at_scheduler_submit(const char *command, AtPriority prio, int deadline_ms,
+                                 AtDoneFunc done, void *user_data);
+
+/**
+ * @brief 取消请求；排队中的请求立即结束，正在发送的请求完成后以 AT_SCHED_CANCELLED 结束
+ * @param id 请求 ID
+ * @return 0 成功, -1 请求不存在或已完成
+ */
+int at_scheduler_cancel(unsigned int id);
+
+/**
+ * @brief 提交请求并等待完成
+ * @param command AT 命令
+ * @param prio 优先级
+ * @param deadline_ms 截止时间（从现在起），<=0 使用默认值
+ * @param result 成功时输出应答（调用者需用 g_free 释放）
+ * @param error 失败时输出错误信息（可为 NULL，调用者需用 g_free 释放）
+ * @return AT_SCHED_OK / AT_SCHED_ERROR / AT_SCHED_CANCELLED / AT_SCHED_EXPIRED
+ */
+int at_scheduler_run(const char *command, AtPriority prio, int deadline_ms, char **result, char **error);
+
+/**
+ * @brief 获取统计
+ * @param stats 输出
+ */
+void at_scheduler_get_stats(AtSchedulerStats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AT_SCHEDULER_H */
@@ -15,6 +15,13 @@ extern "C" {
 /* Token长度 */
 #define AUTH_TOKEN_SIZE 65  /* 64 hex chars + null */
 
+/* 任意模式Token的最大长度（含结尾0），接收和签发Token的缓冲区应使用此大小 */
+#define AUTH_TOKEN_MAX_LEN 128
+
+/* Token模式 */
+#define AUTH_MODE_TABLE      0  /* 随机Token，服务端保存 */
+#define AUTH_MODE_STATELESS  1  /* HMAC-SHA256签名Token，服务端不保存 */
+
 /* 默认密码 */
 #define AUTH_DEFAULT_PASSWORD "admin"
 
@@ -34,7 +41,7 @@ int auth_init(void);
 /**
  * 用户登录
  * @param password 用户输入的密码
- * @param token 输出token缓冲区（至少65字节）
+ * @param token 输出token缓冲区（建议 AUTH_TOKEN_MAX_LEN 字节，无状态模式必须）
  * @param token_size 缓冲区大小
  * @return 0成功，-1密码错误，-2系统错误
  */
@@ -43,6 +50,7 @@ int auth_login(const char *password, char *token, size_t token_size);
 /**
  * 验证Token
  * @param token 要验证的token
+ * 仅查询内存Token表，不访问数据库
  * @return 0有效，-1无效或过期
  */
 int auth_verify_token(const char *token);
@@ -63,11 +71,12 @@ int auth_change_password(const char *old_password, const char *new_password);
 int auth_logout(const char *token);
 
 /**
- * 获取登录状态
- * @param logged_in 输出是否已登录（1=已登录，0=未登录）
+ * 获取调用者的登录状态
+ * @param token 调用者的token（可为NULL）
+ * @param logged_in 输出是否已登录（1=token有效且未注销，0=未登录）
  * @return 0成功，-1失败
  */
-int auth_get_status(int *logged_in);
+int auth_get_status(const char *token, int *logged_in);
 
 /**
  * 检查是否需要认证（首次使用检查）
@@ -75,6 +84,20 @@ int auth_get_status(int *logged_in);
  */
 int auth_is_required(void);
 
+/**
+ * 获取登录时签发的Token模式
+ * @return AUTH_MODE_TABLE 或 AUTH_MODE_STATELESS
+ */
+int auth_get_token_mode(void);
+
+/**
+ * 设置登录时签发的Token模式（保存到配置）
+ * 已签发的两种Token在切换后仍然有效
+ * @param mode AUTH_MODE_TABLE 或 AUTH_MODE_STATELESS
+ * @return 0成功，-1失败
+ */
+int auth_set_token_mode(int mode);
+
 #ifdef __cplusplus
 }
 #endif
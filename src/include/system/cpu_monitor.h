@@ -0,0 +1,86 @@
+/**
+ * @file cpu_monitor.h
+ * @brief CPU 使用率监控
+ *
+ * GLib 定时器按固定间隔采样 /proc/stat（总计和各核）以及 /proc/[pid]/stat，
+ * 每次采样的总使用率、各核使用率和占用最高的若干进程写入固定大小的环形缓冲区，
+ * 读取时给出最新一次采样的瞬时值和指定时间窗口内的平均值。
+ * 使用率与采样频率无关，不再取决于 HTTP 请求的间隔。
+ */
+
+#ifndef CPU_MONITOR_H
+#define CPU_MONITOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 采样间隔 (ms) */
+#define CPU_MONITOR_INTERVAL_MS   1000
+
+/* 环形缓冲区保存的样本数（间隔 1s 时为 60s 历史） */
+#define CPU_MONITOR_HISTORY       60
+
+/* 最多统计的核数 */
+#define CPU_MONITOR_MAX_CORES     8
+
+/* /api/cpu 默认平均窗口（秒） */
+#define CPU_MONITOR_DEFAULT_WINDOW 10
+
+/* 每次采样保存的进程数 */
+#define CPU_MONITOR_TOP_N         8
+
+/* 单次采样最多读取的进程数 */
+#define CPU_MONITOR_MAX_PROCS     1024
+
+/* 单个进程的使用率（占全部核总能力的百分比，与总使用率可直接比较） */
+typedef struct {
+    int pid;
+    char name[16];
+    double now;                   /* 最新一次采样 */
+    double avg;                   /* 窗口平均 */
+} CpuProcUsage;
+
+/* 统计结果 */
+typedef struct {
+    int interval_ms;              /* 采样间隔 */
+    int samples;                  /* 参与窗口平均的样本数 */
+    double total_now;             /* 总使用率 (%) */
+    double total_avg;
+    int core_count;
+    double core_now[CPU_MONITOR_MAX_CORES];
+    double core_avg[CPU_MONITOR_MAX_CORES];
+    int proc_count;
+    CpuProcUsage procs[CPU_MONITOR_TOP_N];  /* 按窗口平均降序 */
+} CpuMonitorStats;
+
+/**
+ * @brief 启动定时采样（在 GLib 主循环中执行）
+ * @return 0 成功, -1 失败
+ */
+int cpu_monitor_start(void);
+
+/**
+ * @brief 停止采样并清空历史
+ */
+void cpu_monitor_stop(void);
+
+/**
+ * @brief 获取统计结果（可在任意线程调用）
+ * @param window_sec 平均窗口（秒），超出历史长度时按全部历史计算，<=0 表示只用最新样本
+ * @param stats 输出
+ * @return 0 成功, -1 尚无样本
+ */
+int cpu_monitor_get_stats(int window_sec, CpuMonitorStats *stats);
+
+/**
+ * @brief 获取最新一次采样的总使用率
+ * @return 使用率 (%), -1 尚无样本
+ */
+double cpu_monitor_total_now(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CPU_MONITOR_H */
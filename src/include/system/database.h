@@ -3,6 +3,7 @@
  * @brief 数据库操作模块 - SQLite3 统一接口
  * 
  * 提供数据库初始化、SQL执行、配置管理等功能
+ * 运行时加载 libsqlite3，进程内保持一个持久连接，所有接口线程安全
  */
 
 #ifndef DATABASE_H
@@ -19,14 +20,15 @@ extern "C" {
  *============================================================================*/
 
 /**
- * 初始化数据库
+ * 初始化数据库（打开连接并执行未完成的结构迁移）
+ * 在此之前调用的接口会按需打开默认路径的数据库
  * @param path 数据库文件路径，NULL则使用默认路径
  * @return 0成功, -1失败
  */
 int db_init(const char *path);
 
 /**
- * 关闭数据库模块
+ * 关闭数据库模块（关闭数据库连接）
  */
 void db_deinit(void);
 
@@ -41,14 +43,14 @@ const char *db_get_path(void);
  *============================================================================*/
 
 /**
- * 执行SQL命令（无锁）
+ * 执行SQL命令（可包含多条语句）
  * @param sql SQL语句
  * @return 0成功, -1失败
  */
 int db_execute(const char *sql);
 
 /**
- * 执行SQL命令（带互斥锁，线程安全）
+ * 执行SQL命令（兼容接口，与 db_execute 相同）
  * @param sql SQL语句
  * @return 0成功, -1失败
  */
@@ -63,7 +65,7 @@ int db_execute_safe(const char *sql);
 int db_query_int(const char *sql, int default_val);
 
 /**
- * 查询字符串结果
+ * 查询字符串结果（多列以"|"分隔，多行以换行分隔）
  * @param sql SQL查询语句
  * @param buf 输出缓冲区
  * @param size 缓冲区大小
@@ -81,6 +83,122 @@ int db_query_string(const char *sql, char *buf, size_t size);
  */
 int db_query_rows(const char *sql, const char *separator, char *buf, size_t size);
 
+/*============================================================================
+ * 预编译语句接口
+ *
+ * 用法: st = db_prepare_cached("key", "SELECT ... WHERE a = ?1");
+ *       db_bind_xxx(st, 1, ...);
+ *       while (db_step(st) == DB_ROW) { db_column_xxx(st, 0); ... }
+ *       db_finalize(st);
+ * 从 prepare 到 finalize 期间持有数据库锁，应尽快 finalize
+ *============================================================================*/
+
+/* 预编译语句句柄 */
+typedef struct db_stmt db_stmt;
+
+/* db_step 返回值 */
+#define DB_ROW      1   /* 有一行结果可读取 */
+#define DB_DONE     0   /* 执行完毕 */
+#define DB_ERROR    -1  /* 执行失败 */
+
+/**
+ * 编译SQL语句
+ * @param sql 单条SQL语句，参数使用 ?1、?2 占位
+ * @return 语句句柄，失败返回NULL；用完须调用 db_finalize
+ */
+db_stmt *db_prepare(const char *sql);
+
+/**
+ * 获取缓存的预编译语句（首次使用时编译，之后跳过SQL解析）
+ * @param key 缓存键（须为静态字符串）
+ * @param sql 单条SQL语句
+ * @return 语句句柄，失败返回NULL；用完须调用 db_finalize 归还
+ */
+db_stmt *db_prepare_cached(const char *key, const char *sql);
+
+/**
+ * 释放语句（缓存语句会被重置并归还缓存）
+ * @param st 语句句柄，可为NULL
+ */
+void db_finalize(db_stmt *st);
+
+/**
+ * 绑定参数（序号从1开始）
+ * @return 0成功, -1失败
+ */
+int db_bind_int(db_stmt *st, int idx, int value);
+int db_bind_int64(db_stmt *st, int idx, long long value);
+int db_bind_text(db_stmt *st, int idx, const char *value);   /* NULL绑定为SQL NULL */
+int db_bind_blob(db_stmt *st, int idx, const void *data, size_t len);
+int db_bind_null(db_stmt *st, int idx);
+
+/**
+ * 执行一步
+ * @return DB_ROW有结果行, DB_DONE执行完毕, DB_ERROR失败
+ */
+int db_step(db_stmt *st);
+
+/**
+ * 读取当前行的列值（序号从0开始）
+ * 返回的指针在下一次 db_step / db_finalize 前有效
+ */
+int db_column_is_null(db_stmt *st, int col);
+int db_column_int(db_stmt *st, int col);
+long long db_column_int64(db_stmt *st, int col);
+const char *db_column_text(db_stmt *st, int col);            /* NULL返回空串 */
+const void *db_column_blob(db_stmt *st, int col);
+int db_column_bytes(db_stmt *st, int col);
+
+/**
+ * 将文本列复制到缓冲区（超长截断，始终以'\0'结尾）
+ * @return 复制的字节数
+ */
+size_t db_column_copy(db_stmt *st, int col, char *buf, size_t size);
+
+/**
+ * 行回调
+ * @param row 当前行，用 db_column_xxx 读取列值
+ * @param user_data 用户数据
+ * @return 0继续, 非0停止遍历
+ */
+typedef int (*db_row_cb)(db_stmt *row, void *user_data);
+
+/**
+ * 逐行执行语句并回调（不释放语句，调用者仍须 db_finalize）
+ * @param st 已绑定参数的语句
+ * @param cb 行回调
+ * @param user_data 用户数据
+ * @return 回调的行数, -1失败
+ */
+int db_foreach(db_stmt *st, db_row_cb cb, void *user_data);
+
+/**
+ * 开始事务（持有数据库锁直到 db_commit / db_rollback）
+ * @return 0成功, -1失败
+ */
+int db_begin(void);
+
+/**
+ * 提交事务，失败时自动回滚
+ * @return 0成功, -1失败
+ */
+int db_commit(void);
+
+/**
+ * 回滚事务
+ */
+void db_rollback(void);
+
+/**
+ * 最近一次写操作影响的行数
+ */
+int db_changes(void);
+
+/**
+ * 最近一次插入的行ID
+ */
+long long db_last_insert_id(void);
+
 /*============================================================================
  * 字符串处理
  *============================================================================*/
@@ -101,6 +219,8 @@ void db_unescape_string(char *str);
 
 /*============================================================================
  * 配置管理接口
+ *
+ * config 表在内存中有一份缓存：读取只查哈希表，写入时同步落库并更新缓存
  *============================================================================*/
 
 /**
@@ -152,6 +272,29 @@ long long config_get_ll(const char *key, long long default_val);
  */
 int config_set_ll(const char *key, long long value);
 
+/**
+ * 配置变更回调（在 config_set 的调用线程中执行，不持有数据库锁）
+ * @param key 配置键名
+ * @param value 新的配置值
+ * @param user_data 用户数据
+ */
+typedef void (*config_change_cb)(const char *key, const char *value, void *user_data);
+
+/**
+ * 注册配置变更监听
+ * @param prefix 键名前缀（如 "traffic_"），NULL或空串监听所有键
+ * @param cb 回调函数
+ * @param user_data 用户数据
+ * @return 监听ID(>0), -1失败
+ */
+int config_add_listener(const char *prefix, config_change_cb cb, void *user_data);
+
+/**
+ * 取消配置变更监听
+ * @param id config_add_listener 返回的ID
+ */
+void config_remove_listener(int id);
+
 #ifdef __cplusplus
 }
 #endif
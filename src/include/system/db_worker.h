@@ -0,0 +1,75 @@
+/**
+ * @file db_worker.h
+ * @brief 数据库异步工作线程
+ *
+ * 耗时的数据库读写放到独立线程执行，HTTP和D-Bus事件循环不再被阻塞。
+ * 任务在工作线程中运行，可调用任意 db_* 接口；完成回调投递回GLib主循环执行，
+ * 因此回调中可以安全地回复mongoose连接、调用GLib/D-Bus接口。
+ * 短时间内连续到达的写任务合并到同一个事务中提交（组提交）。
+ */
+
+#ifndef DB_WORKER_H
+#define DB_WORKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 任务类型 */
+#define DB_JOB_READ   0  /* 只读查询，不参与组提交 */
+#define DB_JOB_WRITE  1  /* 写操作，与相邻写任务合并提交（任务内不要再调用 db_begin） */
+
+/* 队列容量 */
+#define DB_WORKER_QUEUE_MAX         128
+
+/* 组提交: 第一个写任务后最多等待的时间和合并的任务数 */
+#define DB_GROUP_COMMIT_WINDOW_MS   5
+#define DB_GROUP_COMMIT_MAX         32
+
+/**
+ * 任务函数（在工作线程执行）
+ * @param arg 用户数据
+ * @return 任务结果，原样传给完成回调；写任务返回非0时其写入被回滚，不影响同批其他任务
+ */
+typedef int (*db_job_func)(void *arg);
+
+/**
+ * 完成回调（在GLib主循环执行）
+ * 写任务的回调在事务提交之后才会执行，提交失败时 result 为 -1
+ * @param result 任务结果
+ * @param arg 用户数据（由回调负责释放）
+ */
+typedef void (*db_done_func)(int result, void *arg);
+
+/**
+ * 启动数据库工作线程
+ * @return 0成功, -1失败
+ */
+int db_worker_start(void);
+
+/**
+ * 停止数据库工作线程（执行完队列中剩余任务后返回）
+ */
+void db_worker_stop(void);
+
+/**
+ * 提交数据库任务
+ * 工作线程未启动时在当前线程同步执行任务，完成回调仍投递到主循环
+ * @param type DB_JOB_READ 或 DB_JOB_WRITE
+ * @param job 任务函数
+ * @param done 完成回调，可为NULL
+ * @param arg 用户数据
+ * @return 0已提交（done保证被调用一次）, -1队列已满或参数错误（不会调用done）
+ */
+int db_submit(int type, db_job_func job, db_done_func done, void *arg);
+
+/**
+ * 获取当前排队的任务数
+ */
+int db_worker_queue_depth(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DB_WORKER_H */
@@ -28,13 +28,47 @@ void close_dbus(void);
 int is_dbus_initialized(void);
 
 /**
- * @brief 执行 AT 命令 (带重试和超时)
+ * @brief 执行 AT 命令 (经 AT 调度器排队，带重试和超时)
  * @param command AT 命令字符串
  * @param result 返回结果指针 (调用者需用 g_free 释放)
  * @return 0 成功, -1 失败
  */
 int execute_at(const char *command, char **result);
 
+/**
+ * @brief 以后台轮询优先级执行 AT 命令（排在用户请求之后）
+ * @param command AT 命令字符串
+ * @param result 返回结果指针 (调用者需用 g_free 释放)
+ * @return 0 成功, -1 失败
+ */
+int execute_at_background(const char *command, char **result);
+
+/**
+ * @brief 异步 AT 命令完成回调（在主循环中执行）
+ * @param rc 0 成功, -1 失败
+ * @param result 应答，失败时为 NULL，回调返回后释放
+ * @param error 错误信息，成功时为 NULL
+ * @param user_data 用户数据
+ */
+typedef void (*AtAsyncCallback)(int rc, const char *result, const char *error, void *user_data);
+
+/**
+ * @brief 异步执行 AT 命令，不阻塞调用线程
+ * 命令经 AT 调度器排队，回调总是通过 GLib 默认主循环异步调用（恰好一次），
+ * 包括参数错误、命中缓存等立即完成的情况
+ * @param command AT 命令字符串
+ * @param callback 完成回调
+ * @param user_data 用户数据
+ * @return 请求 ID（可用于 execute_at_cancel），立即完成时为 0
+ */
+unsigned int execute_at_async(const char *command, AtAsyncCallback callback, void *user_data);
+
+/**
+ * @brief 取消异步 AT 命令，尚未发送的命令不再发送，回调以失败结果调用
+ * @param id execute_at_async 返回的请求 ID
+ */
+void execute_at_cancel(unsigned int id);
+
 /**
  * @brief 获取最后一次错误信息
  * @return 错误信息字符串
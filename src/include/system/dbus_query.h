@@ -0,0 +1,110 @@
+/**
+ * @file dbus_query.h
+ * @brief oFono D-Bus 并发查询组
+ *
+ * 互不依赖的查询（NetworkMonitor、NetworkRegistration、SimManager、Modem 等）
+ * 通过 g_dbus_connection_call 同时发出，共用同一个截止时间，全部返回后统一取结果。
+ * 组合接口的耗时由各调用超时之和变为最慢的单个调用。
+ *
+ * 一个查询组可以分多轮执行：后一轮的调用依赖前一轮的结果时，
+ * 先 run 第一轮，再 add 新调用并再次 run，各轮共用创建时确定的截止时间。
+ */
+
+#ifndef DBUS_QUERY_H
+#define DBUS_QUERY_H
+
+#include <gio/gio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 单个查询组最多的调用数 */
+#define DBUS_QUERY_MAX_CALLS  16
+
+typedef struct DbusQueryGroup DbusQueryGroup;
+
+/**
+ * 异步查询完成回调（在发起查询的线程的主循环中执行）
+ * 回调返回后查询组自动释放
+ * @param group 查询组，可读取各调用的结果
+ * @param user_data 用户数据
+ */
+typedef void (*dbus_query_done_func)(DbusQueryGroup *group, void *user_data);
+
+/**
+ * @brief 创建查询组
+ * @param timeout_ms 所有调用共用的超时时间（从创建时开始计算）
+ * @return 查询组, 连接系统总线失败返回 NULL
+ */
+DbusQueryGroup *dbus_query_group_new(int timeout_ms);
+
+/**
+ * @brief 添加一个 oFono 方法调用（不立即发出）
+ * @param group 查询组
+ * @param path 对象路径
+ * @param iface 接口名
+ * @param method 方法名
+ * @param params 参数，可为 NULL（浮动引用会被接管）
+ * @param reply_type 返回值类型字符串，如 "(a{sv})"，可为 NULL
+ * @return 调用序号（用于取结果）, -1 失败
+ */
+int dbus_query_group_add(DbusQueryGroup *group, const char *path, const char *iface,
+                         const char *method, GVariant *params, const char *reply_type);
+
+/**
+ * @brief 添加 GetProperties 调用
+ * @return 调用序号, -1 失败
+ */
+int dbus_query_group_add_properties(DbusQueryGroup *group, const char *path, const char *iface);
+
+/**
+ * @brief 并发发出所有尚未发出的调用，阻塞等待全部返回或超时
+ * 使用私有主循环上下文，可在任意线程调用
+ * @param group 查询组
+ * @return 本轮成功的调用数
+ */
+int dbus_query_group_run_sync(DbusQueryGroup *group);
+
+/**
+ * @brief 并发发出所有尚未发出的调用，全部返回后在当前线程的主循环中回调
+ * 成功返回后 done 必定被调用一次，之后查询组自动释放
+ * @param group 查询组
+ * @param done 完成回调
+ * @param user_data 用户数据
+ * @return 0 成功, -1 失败（回调不会被调用，查询组需由调用者释放）
+ */
+int dbus_query_group_run_async(DbusQueryGroup *group, dbus_query_done_func done, void *user_data);
+
+/**
+ * @brief 获取调用结果
+ * @param group 查询组
+ * @param index 调用序号
+ * @return 返回值（由查询组持有）, 调用失败或未完成返回 NULL
+ */
+GVariant *dbus_query_group_result(DbusQueryGroup *group, int index);
+
+/**
+ * @brief 获取调用的错误信息
+ * @return 错误信息, 没有错误返回 NULL
+ */
+const char *dbus_query_group_error(DbusQueryGroup *group, int index);
+
+/**
+ * @brief 释放查询组（不能在调用进行中释放）
+ */
+void dbus_query_group_free(DbusQueryGroup *group);
+
+/**
+ * @brief 从 GetProperties 的返回值 (a{sv}) 中查找属性
+ * @param reply GetProperties 返回值，可为 NULL
+ * @param key 属性名
+ * @return 属性值（新引用，需 g_variant_unref）, 不存在返回 NULL
+ */
+GVariant *dbus_query_lookup_property(GVariant *reply, const char *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DBUS_QUERY_H */
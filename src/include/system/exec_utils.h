@@ -14,8 +14,25 @@ extern "C" {
 
 /* APP_DEMO_PATH 已移除，改用 ofono.h 中的 D-Bus 接口 */
 
+/* run_command_timeout 返回值 */
+#define EXEC_OK          0   /* 成功 */
+#define EXEC_ERROR      -1   /* 启动失败或退出码非0 */
+#define EXEC_TIMEOUT    -2   /* 超时，子进程组已被结束 */
+#define EXEC_TRUNCATED  -3   /* 命令成功，但输出超出缓冲区被截断 */
+
+/* 异步命令默认输出上限 */
+#define EXEC_ASYNC_OUTPUT_MAX  (64 * 1024)
+
+/**
+ * @brief 异步命令完成回调（在GLib主循环执行）
+ * @param result EXEC_OK, EXEC_ERROR, EXEC_TIMEOUT 或 EXEC_TRUNCATED
+ * @param output 捕获的输出（已去除尾部空白），不为NULL
+ * @param user_data 用户数据（由回调负责释放）
+ */
+typedef void (*exec_done_func)(int result, const char *output, void *user_data);
+
 /**
- * @brief 执行命令并获取输出
+ * @brief 执行命令并获取输出（不限时，超出缓冲区的输出被丢弃）
  * @param output 输出缓冲区
  * @param size 缓冲区大小
  * @param cmd 命令
@@ -26,15 +43,44 @@ int run_command(char *output, size_t size, const char *cmd, ...);
 
 /**
  * @brief 带超时执行命令
- * @param timeout_sec 超时秒数
+ * 子进程在独立进程组中运行，超时先发 SIGTERM，500ms 后仍未退出则 SIGKILL 整组
+ * @param timeout_sec 超时秒数，<=0 不限时
  * @param output 输出缓冲区
  * @param size 缓冲区大小
  * @param cmd 命令
  * @param ... 参数列表 (以 NULL 结尾)
- * @return 0 成功, -1 失败
+ * @return EXEC_OK, EXEC_ERROR, EXEC_TIMEOUT 或 EXEC_TRUNCATED
  */
 int run_command_timeout(int timeout_sec, char *output, size_t size, const char *cmd, ...);
 
+/**
+ * @brief 异步执行命令，不阻塞主循环
+ * 输出通过GLib IO监听读入按需增长的缓冲区，子进程退出后回调完成函数；
+ * 超时处理与 run_command_timeout 相同（SIGTERM，宽限期后 SIGKILL 整组）
+ * @param timeout_sec 超时秒数，<=0 不限时
+ * @param max_output 输出上限字节数，0 使用 EXEC_ASYNC_OUTPUT_MAX，超出部分丢弃
+ * @param done 完成回调，可为NULL
+ * @param user_data 用户数据
+ * @param cmd 命令
+ * @param ... 参数列表 (以 NULL 结尾)
+ * @return 0 已启动（done 保证被调用一次）, -1 启动失败（不会调用 done）
+ */
+int run_command_async(int timeout_sec, size_t max_output, exec_done_func done, void *user_data,
+                      const char *cmd, ...);
+
+/**
+ * @brief 异步执行命令，只捕获标准输出
+ * 与 run_command_async 相同，但标准错误不进入 output，继承本进程的标准错误（与 popen 相同）
+ * @return 0 已启动（done 保证被调用一次）, -1 启动失败（不会调用 done）
+ */
+int run_command_async_stdout(int timeout_sec, size_t max_output, exec_done_func done, void *user_data,
+                             const char *cmd, ...);
+
+/**
+ * @brief 获取正在运行的异步命令数
+ */
+int exec_async_running(void);
+
 /**
  * @brief 设备重启
  */
@@ -0,0 +1,74 @@
+/**
+ * @file ofono_bus.h
+ * @brief 共享的系统 D-Bus 连接和 oFono 代理缓存
+ *
+ * ofono.c、sms.c、airplane.c、dbus_query.c 统一从这里获取系统总线连接和 oFono 代理，
+ * 代理按 (路径, 接口) 缓存，不再每次请求都创建代理或重新连接总线。
+ * org.ofono 的所有者变化（oFono 重启）、切换数据卡或连接断开时，
+ * 缓存的代理和数据卡路径全部失效，下次使用时重建。
+ */
+
+#ifndef OFONO_BUS_H
+#define OFONO_BUS_H
+
+#include <gio/gio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 代理缓存上限，超过时清空重建（context 路径随 APN 变化） */
+#define OFONO_BUS_MAX_PROXIES   32
+
+/**
+ * @brief 获取系统总线连接，连接断开时重新连接
+ * @param error 错误输出（可为 NULL）
+ * @return 连接（新引用，调用者需 g_object_unref），失败返回 NULL
+ */
+GDBusConnection *ofono_bus_get(GError **error);
+
+/**
+ * @brief 获取 oFono 对象的代理
+ * @param path 对象路径
+ * @param iface 接口名
+ * @param error 错误输出（可为 NULL）
+ * @return 代理（新引用，调用者需 g_object_unref），失败返回 NULL
+ */
+GDBusProxy *ofono_bus_proxy(const char *path, const char *iface, GError **error);
+
+/**
+ * @brief 当前缓存代次，每次失效加一
+ * 用于丢弃失效前发起、失效后才返回的查询结果
+ */
+unsigned int ofono_bus_generation(void);
+
+/**
+ * @brief 读取缓存的数据卡路径
+ * @param path 输出缓冲区
+ * @param size 缓冲区大小
+ * @return 0 命中, -1 未缓存
+ */
+int ofono_bus_get_datacard(char *path, size_t size);
+
+/**
+ * @brief 缓存数据卡路径
+ * @param path 数据卡路径
+ * @param generation 查询发起时的 ofono_bus_generation()，已失效则忽略
+ */
+void ofono_bus_set_datacard(const char *path, unsigned int generation);
+
+/**
+ * @brief 使缓存的代理和数据卡路径失效
+ */
+void ofono_bus_invalidate(void);
+
+/**
+ * @brief 释放连接和所有缓存（程序退出时调用）
+ */
+void ofono_bus_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OFONO_BUS_H */
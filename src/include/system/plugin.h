@@ -7,6 +7,7 @@
 #define PLUGIN_H
 
 #include <stddef.h>
+#include "exec_utils.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -21,14 +22,28 @@ extern "C" {
 /* 最大插件数量 */
 #define PLUGIN_MAX_COUNT 20
 
+/* Shell命令超时（秒）和输出上限：超时后结束整个进程组（先 SIGTERM，宽限期后 SIGKILL），
+ * 长期运行的命令需自行放到后台（nohup ... &） */
+#define SHELL_EXEC_TIMEOUT_SEC 60
+#define SHELL_OUTPUT_MAX (8 * 1024)
+
 /**
- * @brief 执行Shell命令
+ * @brief 检查命令是否在危险命令黑名单之外
  * @param cmd 要执行的命令
- * @param output 输出缓冲区
- * @param size 缓冲区大小
- * @return 0 成功, -1 失败
+ * @return 1 安全, 0 被拦截
+ */
+int is_command_safe(const char *cmd);
+
+/**
+ * @brief 异步执行Shell命令（sh -c），完成后在主循环回调
+ * 只返回标准输出（标准错误不混入结果）；运行超过 SHELL_EXEC_TIMEOUT_SEC 秒被结束，
+ * 回调收到 EXEC_TIMEOUT 和已产生的输出
+ * @param cmd 要执行的命令
+ * @param done 完成回调
+ * @param user_data 用户数据
+ * @return 0 已启动, -1 命令被拦截或启动失败（不会调用 done）
  */
-int execute_shell(const char *cmd, char *output, size_t size);
+int execute_shell_async(const char *cmd, exec_done_func done, void *user_data);
 
 /**
  * @brief 获取插件列表
@@ -0,0 +1,134 @@
+/**
+ * @file sampler.h
+ * @brief sysfs/procfs 采样器
+ *
+ * 常用的 /proc 和 /sys 文件只打开一次，之后用 pread() 从偏移0重新读取，
+ * 内核会重新生成内容；解析使用不分配内存的整数扫描，不再经过 shell/awk。
+ * 所有路径都拼接在根目录之后，测试时可指向伪造的 sysfs/procfs 目录树。
+ */
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 默认根目录（空字符串表示真实的 / ） */
+#define SAMPLER_DEFAULT_ROOT  ""
+
+/* 根目录路径最大长度 */
+#define SAMPLER_ROOT_MAX      128
+
+/* 最多采集的温度传感器数量 */
+#define SAMPLER_MAX_ZONES     16
+
+/* 内存信息 (kB) */
+typedef struct {
+    unsigned long long total;
+    unsigned long long free;
+    unsigned long long available;
+    unsigned long long buffers;
+    unsigned long long cached;
+} SamplerMeminfo;
+
+/* /proc/stat 中 cpu 行的累计时间 (jiffies) */
+typedef struct {
+    unsigned long long user;
+    unsigned long long nice;
+    unsigned long long system;
+    unsigned long long idle;
+    unsigned long long iowait;
+    unsigned long long irq;
+    unsigned long long softirq;
+    unsigned long long steal;
+} SamplerCpuTimes;
+
+/* /proc/[pid]/stat 中的进程信息 */
+typedef struct {
+    int pid;
+    char comm[16];                  /* 进程名（内核截断为15字节） */
+    unsigned long long utime;       /* 用户态时间 (jiffies) */
+    unsigned long long stime;       /* 内核态时间 (jiffies) */
+    unsigned long long starttime;   /* 启动时间，用于识别 pid 复用 */
+} SamplerProcStat;
+
+/* 单个温度传感器 */
+typedef struct {
+    int id;                 /* thermal_zoneN 中的 N */
+    char type[32];          /* 传感器类型，如 soc-thmzone */
+    int temp_milli;         /* 温度（千分之一摄氏度） */
+} SamplerThermalZone;
+
+/**
+ * @brief 初始化采样器（重复调用会先释放旧的文件描述符）
+ * 未调用时首次采样自动以默认根目录初始化
+ * @param root 根目录，NULL 或 "" 表示真实的 /
+ * @return 0 成功, -1 失败
+ */
+int sampler_init(const char *root);
+
+/**
+ * @brief 关闭所有文件描述符
+ */
+void sampler_deinit(void);
+
+/**
+ * @brief 读取 /proc/meminfo
+ * @param mem 输出
+ * @return 0 成功, -1 失败
+ */
+int sampler_read_meminfo(SamplerMeminfo *mem);
+
+/**
+ * @brief 读取 /proc/stat 的总 cpu 行
+ * @param times 输出
+ * @return 0 成功, -1 失败
+ */
+int sampler_read_cpu(SamplerCpuTimes *times);
+
+/**
+ * @brief 读取 /proc/stat 的总 cpu 行和各核 cpuN 行
+ * @param total 输出总计
+ * @param cores 输出各核（按 N 排列，可为 NULL）
+ * @param max_cores cores 容量
+ * @return 核数（不超过 max_cores）, -1 失败
+ */
+int sampler_read_cpu_cores(SamplerCpuTimes *total, SamplerCpuTimes *cores, int max_cores);
+
+/**
+ * @brief 列出 /proc 下的进程号
+ * @param pids 输出数组
+ * @param max 数组容量
+ * @return 进程数（不超过 max）, -1 失败
+ */
+int sampler_list_pids(int *pids, int max);
+
+/**
+ * @brief 读取 /proc/[pid]/stat（进程可能随时退出，不保持文件描述符）
+ * @param pid 进程号
+ * @param st 输出
+ * @return 0 成功, -1 失败
+ */
+int sampler_read_proc_stat(int pid, SamplerProcStat *st);
+
+/**
+ * @brief 读取 /proc/uptime
+ * @param uptime 输出运行时间(秒)
+ * @return 0 成功, -1 失败
+ */
+int sampler_read_uptime(double *uptime);
+
+/**
+ * @brief 读取各温度传感器（/sys/class/thermal/thermal_zone*）
+ * @param zones 输出数组
+ * @param max 数组容量
+ * @return 读取成功的传感器数量, -1 失败
+ */
+int sampler_read_thermal(SamplerThermalZone *zones, int max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLER_H */
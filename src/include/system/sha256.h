@@ -62,6 +62,17 @@ void sha256_hash_string(const char *str, char *hex_out);
  */
 void sha256_hash_data(const uint8_t *data, size_t len, char *hex_out);
 
+/**
+ * 计算HMAC-SHA256
+ * @param key 密钥
+ * @param key_len 密钥长度
+ * @param data 输入数据
+ * @param len 数据长度
+ * @param mac 输出缓冲区（至少32字节）
+ */
+void sha256_hmac(const uint8_t *key, size_t key_len,
+                 const uint8_t *data, size_t len, uint8_t *mac);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,48 @@
+/**
+ * @file singleflight.h
+ * @brief 相同查询的并发合并
+ *
+ * 多个线程（HTTP 请求、后台采集、流量控制线程等）同时发起同一个只读查询时，
+ * 只有第一个调用方真正执行，其余调用方等待并共享它的结果，modem 只应答一次。
+ * 查询结束后立即移除，不缓存结果（缓存见 at_cache.h）。
+ */
+
+#ifndef SINGLEFLIGHT_H
+#define SINGLEFLIGHT_H
+
+#include <glib.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief 实际执行查询的函数
+ * @param arg 调用方参数
+ * @param value 输出结果（可为 NULL），所有权交给合并层
+ * @return 返回码，原样返回给所有等待者
+ */
+typedef int (*SingleflightFunc)(void *arg, void **value);
+
+/* 复制结果的函数（如 g_strdup、g_variant_ref），每个调用方得到独立副本 */
+typedef gpointer (*SingleflightCopyFunc)(gconstpointer value);
+
+/**
+ * @brief 执行查询，若同一 key 的查询正在进行则等待并共享其结果
+ * 注意 fn 内不能再以相同 key 调用本函数（会自等待）
+ * @param key 查询标识（应包含所有影响结果的参数）
+ * @param fn 执行函数
+ * @param arg 传给 fn 的参数
+ * @param copy 复制结果的函数
+ * @param destroy 释放结果的函数
+ * @param value 输出结果（调用者用 destroy 释放），失败时可能为 NULL
+ * @return fn 的返回码
+ */
+int singleflight_do(const char *key, SingleflightFunc fn, void *arg,
+                    SingleflightCopyFunc copy, GDestroyNotify destroy, void **value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SINGLEFLIGHT_H */
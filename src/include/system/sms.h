@@ -21,6 +21,17 @@ typedef struct {
     int is_read;
 } SmsMessage;
 
+/* 单次分页查询的最大条数 */
+#define SMS_PAGE_MAX 100
+
+/* 收件箱统计 */
+typedef struct {
+    int total;          /* 短信总数 */
+    int unread;         /* 未读数量 */
+    int oldest_id;      /* 最早短信ID，无短信为0 */
+    int latest_id;      /* 最新短信ID，无短信为0 */
+} SmsStats;
+
 /* Webhook配置结构 */
 typedef struct {
     int enabled;
@@ -60,6 +71,67 @@ int sms_send(const char *recipient, const char *content, char *result_path, size
  */
 int sms_get_list(SmsMessage *messages, int max_count);
 
+/**
+ * 分页获取短信（按ID倒序，键集分页）
+ * @param before_id 只返回ID小于此值的短信，<=0 表示从最新一条开始
+ * @param messages 输出数组
+ * @param max_count 最大数量
+ * @return 实际获取的数量, -1失败
+ */
+int sms_get_page(int before_id, SmsMessage *messages, int max_count);
+
+/**
+ * 获取新短信（按ID倒序）
+ * @param since_id 只返回ID大于此值的短信
+ * @param messages 输出数组
+ * @param max_count 最大数量
+ * @return 实际获取的数量, -1失败
+ */
+int sms_get_since(int since_id, SmsMessage *messages, int max_count);
+
+/**
+ * 获取收件箱统计
+ * @param stats 输出统计
+ * @return 0成功, -1失败
+ */
+int sms_get_stats(SmsStats *stats);
+
+/* 搜索范围 */
+#define SMS_BOX_INBOX   1
+#define SMS_BOX_SENT    2
+#define SMS_BOX_ALL     (SMS_BOX_INBOX | SMS_BOX_SENT)
+
+/* 单次搜索的最大条数 */
+#define SMS_SEARCH_MAX  50
+
+/* 搜索结果 */
+typedef struct {
+    int id;
+    int box;            /* SMS_BOX_INBOX 或 SMS_BOX_SENT */
+    char peer[64];      /* 发件人或收件人 */
+    char content[1024];
+    time_t timestamp;
+} SmsSearchHit;
+
+/**
+ * 全文搜索短信，按相关度排序（无相关度时按时间倒序）
+ * @param query 搜索词
+ * @param box 搜索范围 SMS_BOX_*
+ * @param offset 跳过的条数
+ * @param hits 输出数组
+ * @param max_count 最大数量
+ * @param engine_used 输出本次实际使用的搜索方式（可为NULL）
+ * @return 实际获取的数量, -1失败
+ */
+int sms_search(const char *query, int box, int offset, SmsSearchHit *hits, int max_count,
+               const char **engine_used);
+
+/**
+ * 获取数据库的全文索引方式（fts5-trigram / fts5 / fts4 / like），
+ * 单次查询可能退回 LIKE，以 sms_search 的 engine_used 为准
+ */
+const char *sms_search_engine(void);
+
 /**
  * 获取短信总数
  * @return 短信数量, -1失败
@@ -10,6 +10,16 @@
 extern "C" {
 #endif
 
+/* 最多上报的温度传感器数量 */
+#define SYSINFO_MAX_THERMAL_ZONES 8
+
+/* 单个温度传感器 */
+typedef struct {
+    int id;                       /* thermal_zoneN 中的 N */
+    char name[32];                /* 传感器类型 */
+    double temp;                  /* Celsius */
+} ThermalZoneInfo;
+
 /* 系统信息结构 */
 typedef struct {
     char hostname[64];
@@ -25,7 +35,9 @@ typedef struct {
     char bridge_status[32];
     char sim_slot[16];
     char signal_strength[64];
-    double thermal_temp;          /* Celsius */
+    double thermal_temp;          /* Celsius, 各传感器平均值 */
+    ThermalZoneInfo thermal_zones[SYSINFO_MAX_THERMAL_ZONES];
+    int thermal_zone_count;
     char power_status[32];
     char battery_health[32];
     unsigned int battery_capacity;
@@ -47,13 +59,62 @@ typedef struct {
     int uplink_rate;
 } SystemInfo;
 
+/* 系统信息字段分组，每组由一次独立探测填充 */
+typedef enum {
+    SYSINFO_GROUP_UNAME = 0,      /* hostname/sysname/release/version/machine */
+    SYSINFO_GROUP_SERIAL,         /* serial */
+    SYSINFO_GROUP_MEMORY,         /* total_ram/free_ram/cached_ram */
+    SYSINFO_GROUP_UPTIME,         /* uptime */
+    SYSINFO_GROUP_CPU,            /* cpu_usage */
+    SYSINFO_GROUP_THERMAL,        /* thermal_temp/thermal_zones */
+    SYSINFO_GROUP_BATTERY,        /* power_status/battery_health/battery_capacity */
+    SYSINFO_GROUP_WIFI,           /* ssid */
+    SYSINFO_GROUP_SLOT,           /* sim_slot/network_mode (D-Bus) */
+    SYSINFO_GROUP_SIGNAL,         /* signal_strength (D-Bus) */
+    SYSINFO_GROUP_IDENTITY,       /* imei/iccid/imsi/carrier (D-Bus，缺失时 AT) */
+    SYSINFO_GROUP_AIRPLANE,       /* airplane_mode (D-Bus，缺失时 AT+CFUN?) */
+    SYSINFO_GROUP_NET_MODE,       /* select_network_mode (D-Bus) */
+    SYSINFO_GROUP_SERVING,        /* network_type/network_band (D-Bus) */
+    SYSINFO_GROUP_QOS,            /* qci/downlink_rate/uplink_rate (AT) */
+    SYSINFO_GROUP_COUNT
+} SysinfoGroup;
+
+#define SYSINFO_GROUP_BIT(g)  (1u << (g))
+#define SYSINFO_GROUP_ALL     (SYSINFO_GROUP_BIT(SYSINFO_GROUP_COUNT) - 1)
+
+/* oFono 并发查询共用的超时时间 (ms) */
+#define SYSINFO_QUERY_TIMEOUT_MS  8000
+
 /**
- * @brief 获取完整系统信息
+ * @brief 获取完整系统信息（同步执行所有分组探测）
  * @param info 输出系统信息结构
  * @return 0 成功, -1 失败
  */
 int get_system_info(SystemInfo *info);
 
+/**
+ * @brief 填充默认值（字符串字段为 "N/A"）
+ * @param info 输出系统信息结构
+ */
+void sysinfo_init_defaults(SystemInfo *info);
+
+/**
+ * @brief 探测一组分组，只写入这些分组的字段
+ * oFono 相关分组的 D-Bus 查询并发执行，其余分组依次执行
+ * @param mask 分组掩码 (SYSINFO_GROUP_BIT 的组合)
+ * @param info 系统信息结构
+ * @return 探测成功的分组掩码
+ */
+unsigned int sysinfo_probe_groups(unsigned int mask, SystemInfo *info);
+
+/**
+ * @brief 复制单个分组的字段
+ * @param group 分组
+ * @param dst 目标
+ * @param src 来源
+ */
+void sysinfo_copy_group(SysinfoGroup group, SystemInfo *dst, const SystemInfo *src);
+
 /**
  * @brief 获取系统运行时间
  * @return 运行时间(秒), -1 失败
@@ -86,10 +147,18 @@ int get_signal_strength(char *strength, size_t size);
 
 /**
  * @brief 获取温度
- * @return 温度(摄氏度), -1 失败
+ * @return 所有传感器的平均温度(摄氏度), -1 失败
  */
 double get_thermal_temp(void);
 
+/**
+ * @brief 获取各温度传感器的温度
+ * @param zones 输出数组
+ * @param max 数组容量
+ * @return 传感器数量, -1 失败
+ */
+int get_thermal_zones(ThermalZoneInfo *zones, int max);
+
 /**
  * @brief 获取 QoS 签约速率
  * @param qci QCI 值
@@ -110,7 +179,7 @@ int get_qos_info(int *qci, int *downlink, int *uplink);
 int get_network_type_and_band(char *net_type, size_t type_size, char *band, size_t band_size);
 
 /**
- * @brief 获取 CPU 使用率
+ * @brief 获取 CPU 使用率（cpu_monitor 最新一次采样）
  * @return CPU 使用率 (%)
  */
 double get_cpu_usage(void);
@@ -0,0 +1,65 @@
+/**
+ * @file sysinfo_collector.h
+ * @brief 系统信息后台采集器
+ *
+ * 后台线程按分组各自的周期刷新系统信息快照（静态身份信息只采集一次，
+ * 无线指标每隔几秒刷新），/api/info 直接从内存快照返回，不再在请求中
+ * 串行执行 D-Bus 调用和 AT 命令。长时间没有调用方读取的分组暂停采集。
+ */
+
+#ifndef SYSINFO_COLLECTOR_H
+#define SYSINFO_COLLECTOR_H
+
+#include "sysinfo.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 刷新周期 (ms)，0 表示成功采集一次后不再刷新 */
+#define SYSINFO_REFRESH_ONCE         0
+#define SYSINFO_REFRESH_FAST_MS      2000      /* 内存、运行时间、CPU */
+#define SYSINFO_REFRESH_SIGNAL_MS    3000      /* 信号强度 */
+#define SYSINFO_REFRESH_RADIO_MS     5000      /* 网络类型/频段、飞行模式、温度 */
+#define SYSINFO_REFRESH_SLOT_MS      10000     /* 数据卡槽、电池 */
+#define SYSINFO_REFRESH_SLOW_MS      30000     /* 网络模式、QoS、WiFi */
+#define SYSINFO_REFRESH_IDENTITY_MS  300000    /* ICCID/IMSI（换卡槽时立即刷新） */
+
+/* 只采集一次的分组失败后的重试间隔 (ms) */
+#define SYSINFO_RETRY_MS             10000
+
+/* 分组超过该时间 (ms) 没有被请求时暂停周期采集，再次被请求时立即恢复 */
+#define SYSINFO_IDLE_MS              120000
+
+/**
+ * @brief 启动采集线程（立即开始采集所有分组）
+ * @return 0 成功, -1 失败
+ */
+int sysinfo_collector_start(void);
+
+/**
+ * @brief 停止采集线程（等待正在执行的探测结束）
+ */
+void sysinfo_collector_stop(void);
+
+/**
+ * @brief 复制当前快照，并记录调用方需要的分组
+ * 已暂停的分组立即恢复采集，本次返回的仍是暂停前的数据（见 age_ms）
+ * @param info 输出系统信息结构
+ * @param age_ms 输出各分组距上次采集的毫秒数，尚未采集过为 -1，可为 NULL
+ * @param mask 调用方读取的分组掩码 (SYSINFO_GROUP_BIT 的组合)
+ * @return 0 成功, -1 采集器未运行
+ */
+int sysinfo_collector_snapshot(SystemInfo *info, long long age_ms[SYSINFO_GROUP_COUNT], unsigned int mask);
+
+/**
+ * @brief 请求尽快重新采集某个分组（设置类接口修改状态后调用）
+ * @param group 分组
+ */
+void sysinfo_collector_refresh(SysinfoGroup group);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSINFO_COLLECTOR_H */
@@ -0,0 +1,68 @@
+/**
+ * @file terminal.h
+ * @brief Web终端 - 基于PTY的WebSocket Shell会话
+ *
+ * 每个WebSocket连接对应一个常驻的PTY Shell，输出以二进制帧增量推送。
+ * 客户端消息首字节为类型:
+ *   '0' + 数据                      键盘输入，原样写入PTY
+ *   '1' + {"cols":80,"rows":24}     调整终端窗口大小
+ * Shell退出后服务端发送关闭帧。
+ */
+
+#ifndef TERMINAL_H
+#define TERMINAL_H
+
+#include "mongoose.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 同时打开的终端会话上限 */
+#define TERMINAL_MAX_SESSIONS     4
+
+/* 会话Shell及环境 */
+#define TERMINAL_SHELL            "/bin/sh"
+#define TERMINAL_TERM             "xterm-256color"
+
+/* 输出背压: 连接发送缓冲超过高水位暂停读取PTY，降到低水位后恢复 */
+#define TERMINAL_SEND_HIGH_WATER  (64 * 1024)
+#define TERMINAL_SEND_LOW_WATER   (16 * 1024)
+
+/* 尚未写入PTY的输入上限，超出部分丢弃 */
+#define TERMINAL_INPUT_MAX        (64 * 1024)
+
+/* 连接关闭后等待Shell退出的时间，超时 SIGKILL */
+#define TERMINAL_KILL_GRACE_MS    2000
+
+/**
+ * @brief 升级为WebSocket并创建终端会话
+ * GET /api/terminal/ws
+ */
+void handle_terminal_ws(struct mg_connection *c, struct mg_http_message *hm);
+
+/**
+ * @brief 处理终端连接上的WebSocket消息
+ */
+void terminal_ws_message(struct mg_connection *c, struct mg_ws_message *wm);
+
+/**
+ * @brief 连接可写/轮询时检查是否恢复读取PTY
+ */
+void terminal_ws_poll(struct mg_connection *c);
+
+/**
+ * @brief 连接关闭时结束对应的终端会话
+ */
+void terminal_ws_close(struct mg_connection *c);
+
+/**
+ * @brief 结束所有终端会话（服务器停止时调用）
+ */
+void terminal_shutdown(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TERMINAL_H */
@@ -49,25 +49,51 @@ const char* update_get_version(void);
 const char* update_get_embedded_url(void);
 
 /**
- * @brief 从URL下载更新包
+ * @brief 更新步骤完成回调（在GLib主循环执行）
+ * @param result 0成功, -1失败
+ * @param output 命令输出或错误描述，不为NULL
+ * @param user_data 用户数据
+ */
+typedef void (*update_done_func)(int result, const char *output, void *user_data);
+
+/**
+ * @brief 版本检查完成回调（在GLib主循环执行）
+ * @param result 0成功, -1失败
+ * @param info 版本信息（失败时内容为空）
+ * @param user_data 用户数据
+ */
+typedef void (*update_check_func)(int result, const update_info_t *info, void *user_data);
+
+/**
+ * @brief 是否有更新任务（下载/解压/安装）正在执行
+ * @return 1是, 0否
+ */
+int update_is_busy(void);
+
+/**
+ * @brief 异步从URL下载更新包（curl失败时改用wget）
  * @param url 下载链接
- * @return 0成功, -1失败
+ * @param done 完成回调
+ * @param user_data 用户数据
+ * @return 0已启动, -1参数错误、任务进行中或启动失败（不会调用 done）
  */
-int update_download(const char *url);
+int update_download_async(const char *url, update_done_func done, void *user_data);
 
 /**
- * @brief 解压更新包
- * @return 0成功, -1失败
+ * @brief 异步解压更新包（unzip失败时改用busybox unzip）
+ * @param done 完成回调
+ * @param user_data 用户数据
+ * @return 0已启动, -1更新包不存在、任务进行中或启动失败（不会调用 done）
  */
-int update_extract(void);
+int update_extract_async(update_done_func done, void *user_data);
 
 /**
- * @brief 执行安装脚本
- * @param output 输出缓冲区
- * @param size 缓冲区大小
- * @return 0成功, -1失败
+ * @brief 异步执行安装脚本，回调中 output 为脚本输出
+ * @param done 完成回调
+ * @param user_data 用户数据
+ * @return 0已启动, -1安装脚本不存在、任务进行中或启动失败（不会调用 done）
  */
-int update_install(char *output, size_t size);
+int update_install_async(update_done_func done, void *user_data);
 
 /**
  * @brief 清理更新临时文件
@@ -75,12 +101,13 @@ int update_install(char *output, size_t size);
 void update_cleanup(void);
 
 /**
- * @brief 检查远程版本
+ * @brief 异步检查远程版本（不占用更新任务）
  * @param check_url 版本检查URL
- * @param info 版本信息输出
- * @return 0成功, -1失败
+ * @param done 完成回调
+ * @param user_data 用户数据
+ * @return 0已启动, -1参数错误或启动失败（不会调用 done）
  */
-int update_check_version(const char *check_url, update_info_t *info);
+int update_check_version_async(const char *check_url, update_check_func done, void *user_data);
 
 #ifdef __cplusplus
 }
@@ -6,7 +6,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 #include <glib.h>
 #include "mongoose.h"
 #include "advanced.h"
@@ -15,6 +14,9 @@
 #include "http_utils.h"
 #include "ofono.h"
 #include "json_builder.h"
+#include "http_server.h"
+#include "dbus_query.h"
+#include "at_batch.h"
 
 /* 频段映射结构 */
 typedef struct {
@@ -89,30 +91,20 @@ static void parse_bands_info(const char *output4G, const char *output5G, int *ba
     }
 }
 
-/* GET /api/bands - 获取频段状态 */
-void handle_get_bands(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_GET(c, hm);
+/* 频段查询完成后回复 */
+static void get_bands_done(AtBatch *batch, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    if (!c) return;  /* 连接已关闭 */
 
-    char *result4G = NULL, *result5G = NULL;
+    const char *result4G = at_batch_result(batch, 0);
+    const char *result5G = at_batch_result(batch, 1);
     int bands[16] = {0};
 
-    printf("开始获取频段锁定状态...\n");
-
-    /* 查询4G频段 */
-    if (execute_at("AT+SPLBAND=0", &result4G) == 0) {
-        printf("4G频段查询结果: %s\n", result4G);
-    }
-
-    /* 查询5G频段 */
-    if (execute_at("AT+SPLBAND=3", &result5G) == 0) {
-        printf("5G频段查询结果: %s\n", result5G);
-    }
+    if (result4G) printf("4G频段查询结果: %s\n", result4G);
+    if (result5G) printf("5G频段查询结果: %s\n", result5G);
 
     parse_bands_info(result4G, result5G, bands);
 
-    if (result4G) g_free(result4G);
-    if (result5G) g_free(result5G);
-
     /* 使用JSON Builder构建响应 */
     JsonBuilder *j = json_new();
     json_obj_open(j);
@@ -149,6 +141,19 @@ void handle_get_bands(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_OK_FREE(c, json_finish(j));
 }
 
+/* GET /api/bands - 获取频段状态 */
+void handle_get_bands(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    printf("开始获取频段锁定状态...\n");
+
+    /* 查询4G、5G频段，完成后在 get_bands_done 中回复 */
+    AtBatch *batch = at_batch_new();
+    at_batch_add(batch, "AT+SPLBAND=0", 0, 0);
+    at_batch_add(batch, "AT+SPLBAND=3", 0, 0);
+    at_batch_run_async(batch, c->id, get_bands_done, GSIZE_TO_POINTER(c->id));
+}
+
 
 /* 查找频段映射 */
 static const BandMapping *find_band(const char *name) {
@@ -186,6 +191,44 @@ static int parse_bands_array(const char *json_str, char bands[][32], int max_ban
     return count;
 }
 
+/* AT 命令间隔 (ms)，给 modem 切换射频状态的时间 */
+#define RADIO_STEP_DELAY_MS  300
+
+/**
+ * 锁频/解锁命令序列完成后回复
+ * 第一步关闭设备失败时序列已停止，返回 500
+ */
+static void reply_bands_batch(AtBatch *batch, unsigned long conn_id, const char *message) {
+    if (at_batch_failed_step(batch) == 0) {
+        printf("关闭设备失败，未修改频段\n");
+    } else {
+        printf("%s\n", message);
+    }
+
+    struct mg_connection *c = http_server_find_conn(conn_id);
+    if (!c) return;  /* 连接已关闭，命令已执行完 */
+
+    if (at_batch_failed_step(batch) == 0) {
+        HTTP_ERROR(c, 500, "关闭设备失败");
+        return;
+    }
+
+    JsonBuilder *j = json_new();
+    json_obj_open(j);
+    json_add_bool(j, "success", 1);
+    json_add_str(j, "message", message);
+    json_obj_close(j);
+    HTTP_OK_FREE(c, json_finish(j));
+}
+
+static void lock_bands_done(AtBatch *batch, void *user_data) {
+    reply_bands_batch(batch, GPOINTER_TO_SIZE(user_data), "频段锁定成功");
+}
+
+static void unlock_bands_done(AtBatch *batch, void *user_data) {
+    reply_bands_batch(batch, GPOINTER_TO_SIZE(user_data), "频段解锁成功");
+}
+
 /* POST /api/lock_bands - 锁定频段 */
 void handle_lock_bands(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
@@ -215,56 +258,35 @@ void handle_lock_bands(struct mg_connection *c, struct mg_http_message *hm) {
 
     printf("计算结果: 4G TDD=%d, 4G FDD=%d, 5G FDD=%d, 5G TDD=%d\n", tdd4G, fdd4G, fdd5G, tdd5G);
 
-    char *result = NULL;
     char cmd[128];
+    AtBatch *batch = at_batch_new();
 
-    /* 执行命令序列 */
-    /* 1. 关闭设备 */
-    if (execute_at("AT+SFUN=5", &result) != 0) {
-        HTTP_ERROR(c, 500, "关闭设备失败");
-        if (result) g_free(result);
-        return;
-    }
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    /* 执行命令序列，完成后在 lock_bands_done 中回复 */
+    /* 1. 关闭设备（失败则不继续） */
+    at_batch_add(batch, "AT+SFUN=5", AT_BATCH_REQUIRED, RADIO_STEP_DELAY_MS);
 
     /* 2. 解锁5G频段 */
-    execute_at("AT+SPLBAND=2,0,0,0,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPLBAND=2,0,0,0,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 3. 锁定4G频段 */
     if (tdd4G != 0 || fdd4G != 0) {
         snprintf(cmd, sizeof(cmd), "AT+SPLBAND=1,0,%d,0,%d,0", tdd4G, fdd4G);
-        execute_at(cmd, &result);
-        if (result) { g_free(result); result = NULL; }
-        usleep(300000);
+        at_batch_add(batch, cmd, 0, RADIO_STEP_DELAY_MS);
     }
 
     /* 4. 锁定5G频段 */
     if (fdd5G != 0 || tdd5G != 0) {
         snprintf(cmd, sizeof(cmd), "AT+SPLBAND=2,%d,0,%d,0", fdd5G, tdd5G);
-        execute_at(cmd, &result);
-        if (result) { g_free(result); result = NULL; }
-        usleep(300000);
+        at_batch_add(batch, cmd, 0, RADIO_STEP_DELAY_MS);
     }
 
     /* 5. 开启设备 */
-    execute_at("AT+SFUN=4", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SFUN=4", 0, RADIO_STEP_DELAY_MS);
 
     /* 6. 激活网络 */
-    execute_at("AT+CGACT=0,1", &result);
-    if (result) g_free(result);
+    at_batch_add(batch, "AT+CGACT=0,1", 0, 0);
 
-    printf("频段锁定成功\n");
-    JsonBuilder *j = json_new();
-    json_obj_open(j);
-    json_add_bool(j, "success", 1);
-    json_add_str(j, "message", "频段锁定成功");
-    json_obj_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
+    at_batch_run_async(batch, c->id, lock_bands_done, GSIZE_TO_POINTER(c->id));
 }
 
 
@@ -273,43 +295,25 @@ void handle_unlock_bands(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
 
     printf("开始解锁所有频段...\n");
-    char *result = NULL;
 
-    /* 1. 关闭设备 */
-    if (execute_at("AT+SFUN=5", &result) != 0) {
-        HTTP_ERROR(c, 500, "关闭设备失败");
-        if (result) g_free(result);
-        return;
-    }
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    AtBatch *batch = at_batch_new();
+
+    /* 1. 关闭设备（失败则不继续） */
+    at_batch_add(batch, "AT+SFUN=5", AT_BATCH_REQUIRED, RADIO_STEP_DELAY_MS);
 
     /* 2. 解锁4G频段 */
-    execute_at("AT+SPLBAND=1,0,0,0,0,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPLBAND=1,0,0,0,0,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 3. 解锁5G频段 */
-    execute_at("AT+SPLBAND=2,0,0,0,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPLBAND=2,0,0,0,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 4. 开启设备 */
-    execute_at("AT+SFUN=4", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SFUN=4", 0, RADIO_STEP_DELAY_MS);
 
     /* 5. 激活网络 */
-    execute_at("AT+CGACT=0,1", &result);
-    if (result) g_free(result);
+    at_batch_add(batch, "AT+CGACT=0,1", 0, 0);
 
-    printf("频段解锁成功\n");
-    JsonBuilder *j = json_new();
-    json_obj_open(j);
-    json_add_bool(j, "success", 1);
-    json_add_str(j, "message", "频段解锁成功");
-    json_obj_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
+    at_batch_run_async(batch, c->id, unlock_bands_done, GSIZE_TO_POINTER(c->id));
 }
 
 /* 解析小区数据 (复用 handlers.c 中的函数) */
@@ -394,17 +398,13 @@ static void add_cell_to_json(JsonBuilder *j, const char *rat, const char *band_p
     json_obj_close(j);
 }
 
-/* GET /api/cells - 获取小区信息 */
-void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_GET(c, hm);
-
-    printf("开始获取小区信息...\n");
-    char *result = NULL;
-    
-    /* 通过 D-Bus 判断网络类型 (与 Go 版本一致) */
-    int is_5g = is_5g_network();
-    printf("检测到%s网络\n", is_5g ? "5G" : "4G");
-
+/**
+ * 由主小区和邻小区的 AT+SPENGMD 应答生成 /api/cells 响应
+ * @param is_5g 1=5G (0,14,1 / 0,14,2), 0=4G (0,6,0 / 0,6,6)
+ * @param primary 主小区应答，失败时为 NULL
+ * @param neighbours 邻小区应答，失败时为 NULL
+ */
+static char *build_cells_json(int is_5g, const char *primary, const char *neighbours) {
     JsonBuilder *j = json_new();
     json_obj_open(j);
     json_add_int(j, "Code", 0);
@@ -415,9 +415,9 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
 
     if (is_5g) {
         /* 5G 主小区 */
-        if (execute_at("AT+SPENGMD=0,14,1", &result) == 0 && result) {
+        if (primary) {
             char data[64][16][32] = {{{0}}};
-            int rows = parse_cell_to_vec(result, data);
+            int rows = parse_cell_to_vec(primary, data);
             if (rows > 15) {
                 add_cell_to_json(j, "5G", "N", data[0][0],
                     atoi(data[1][0]), atoi(data[2][0]),
@@ -425,14 +425,12 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
                     atof(data[15][0]) / 100.0, 1);
                 cell_count++;
             }
-            g_free(result);
-            result = NULL;
         }
 
         /* 5G 邻小区 */
-        if (execute_at("AT+SPENGMD=0,14,2", &result) == 0 && result) {
+        if (neighbours) {
             char data[64][16][32] = {{{0}}};
-            int rows = parse_cell_to_vec(result, data);
+            int rows = parse_cell_to_vec(neighbours, data);
             if (rows > 5) {
                 int col_count = 0;
                 for (int i = 0; i < 16 && data[0][i][0]; i++) col_count++;
@@ -454,13 +452,12 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
                     cell_count++;
                 }
             }
-            g_free(result);
         }
     } else {
         /* 4G 主小区 */
-        if (execute_at("AT+SPENGMD=0,6,0", &result) == 0 && result) {
+        if (primary) {
             char data[64][16][32] = {{{0}}};
-            int rows = parse_cell_to_vec(result, data);
+            int rows = parse_cell_to_vec(primary, data);
             if (rows > 33) {
                 add_cell_to_json(j, "4G", "B", data[0][0],
                     atoi(data[1][0]), atoi(data[2][0]),
@@ -468,14 +465,12 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
                     atof(data[33][0]) / 100.0, 1);
                 cell_count++;
             }
-            g_free(result);
-            result = NULL;
         }
 
         /* 4G 邻小区 */
-        if (execute_at("AT+SPENGMD=0,6,6", &result) == 0 && result) {
+        if (neighbours) {
             char data[64][16][32] = {{{0}}};
-            int rows = parse_cell_to_vec(result, data);
+            int rows = parse_cell_to_vec(neighbours, data);
             for (int i = 0; i < rows; i++) {
                 int arfcn = atoi(data[i][0]);
                 int pci = atoi(data[i][1]);
@@ -494,7 +489,6 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
                     atof(data[i][6]) / 100.0, 0);
                 cell_count++;
             }
-            g_free(result);
         }
     }
 
@@ -502,9 +496,108 @@ void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
     json_obj_close(j);
     printf("小区信息获取完成，共 %d 个小区\n", cell_count);
 
+    return json_finish(j);
+}
+
+/* 小区查询的连接和网络类型 */
+typedef struct {
+    unsigned long conn_id;
+    int is_5g;
+} CellsQuery;
+
+/* 小区 AT 查询完成后回复 */
+static void cells_done(AtBatch *batch, void *user_data) {
+    CellsQuery *q = user_data;
+    struct mg_connection *c = http_server_find_conn(q->conn_id);
+    if (c) {
+        HTTP_OK_FREE(c, build_cells_json(q->is_5g, at_batch_result(batch, 0), at_batch_result(batch, 1)));
+    }
+    g_free(q);
+}
+
+/* 依次查询主小区和邻小区（AT 通道不支持并发） */
+static void start_cells_query(unsigned long conn_id, int is_5g) {
+    CellsQuery *q = g_new0(CellsQuery, 1);
+    q->conn_id = conn_id;
+    q->is_5g = is_5g;
+
+    AtBatch *batch = at_batch_new();
+    at_batch_add(batch, is_5g ? "AT+SPENGMD=0,14,1" : "AT+SPENGMD=0,6,0", 0, 0);
+    at_batch_add(batch, is_5g ? "AT+SPENGMD=0,14,2" : "AT+SPENGMD=0,6,6", 0, 0);
+    at_batch_run_async(batch, conn_id, cells_done, q);
+}
+
+/* 网络类型查询完成后查询小区 */
+static void cells_tech_done(DbusQueryGroup *group, void *user_data) {
+    unsigned long conn_id = GPOINTER_TO_SIZE(user_data);
+    if (!http_server_find_conn(conn_id)) return;  /* 连接已关闭 */
+
+    char tech[32] = {0};
+    GVariant *tech_val = dbus_query_lookup_property(dbus_query_group_result(group, 0), "Technology");
+    if (tech_val && g_variant_is_of_type(tech_val, G_VARIANT_TYPE_STRING)) {
+        snprintf(tech, sizeof(tech), "%s", g_variant_get_string(tech_val, NULL));
+    } else {
+        printf("D-Bus 查询网络类型失败，默认使用 4G\n");
+    }
+    if (tech_val) g_variant_unref(tech_val);
+
+    int is_5g = strcmp(tech, "nr") == 0;
+    printf("检测到%s网络\n", is_5g ? "5G" : "4G");
+
+    start_cells_query(conn_id, is_5g);
+}
+
+/* GET /api/cells - 获取小区信息 */
+void handle_get_cells(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    printf("开始获取小区信息...\n");
+
+    /* 通过 D-Bus 判断网络类型 (与 Go 版本一致)，异步查询不阻塞主循环 */
+    DbusQueryGroup *q = dbus_query_group_new(OFONO_TIMEOUT_MS);
+    if (q) {
+        dbus_query_group_add(q, "/ril_0", "org.ofono.NetworkMonitor",
+                             "GetServingCellInformation", NULL, "(a{sv})");
+        if (dbus_query_group_run_async(q, cells_tech_done, GSIZE_TO_POINTER(c->id)) == 0) {
+            return;
+        }
+        dbus_query_group_free(q);
+    }
+
+    int is_5g = is_5g_network();
+    printf("检测到%s网络\n", is_5g ? "5G" : "4G");
+    start_cells_query(c->id, is_5g);
+}
+
+
+/* 锁小区/解锁命令序列完成后回复 */
+static void reply_cell_batch(unsigned long conn_id, const char *message) {
+    printf("%s\n", message);
+
+    struct mg_connection *c = http_server_find_conn(conn_id);
+    if (!c) return;  /* 连接已关闭，命令已执行完 */
+
+    JsonBuilder *j = json_new();
+    json_obj_open(j);
+    json_add_int(j, "Code", 0);
+    json_add_str(j, "Error", "");
+    json_key_obj_open(j, "Data");
+    json_add_bool(j, "success", 1);
+    json_add_str(j, "message", message);
+    json_obj_close(j);
+    json_obj_close(j);
     HTTP_OK_FREE(c, json_finish(j));
 }
 
+static void lock_cell_done(AtBatch *batch, void *user_data) {
+    (void)batch;
+    reply_cell_batch(GPOINTER_TO_SIZE(user_data), "小区锁定成功");
+}
+
+static void unlock_cell_done(AtBatch *batch, void *user_data) {
+    (void)batch;
+    reply_cell_batch(GPOINTER_TO_SIZE(user_data), "小区解锁成功");
+}
 
 /* POST /api/lock_cell - 锁定小区 */
 void handle_lock_cell(struct mg_connection *c, struct mg_http_message *hm) {
@@ -530,50 +623,29 @@ void handle_lock_cell(struct mg_connection *c, struct mg_http_message *hm) {
         band = "16"; /* 5G */
     }
 
-    char *result = NULL;
     char cmd[128];
+    AtBatch *batch = at_batch_new();
 
     /* 1. 关闭射频 */
-    execute_at("AT+SFUN=5", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SFUN=5", 0, RADIO_STEP_DELAY_MS);
 
     /* 2. 解锁4G */
-    execute_at("AT+SPFORCEFRQ=12,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPFORCEFRQ=12,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 3. 解锁5G */
-    execute_at("AT+SPFORCEFRQ=16,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPFORCEFRQ=16,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 4. 锁定小区 */
     snprintf(cmd, sizeof(cmd), "AT+SPFORCEFRQ=%s,2,%s,%s", band, arfcn, pci);
-    execute_at(cmd, &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, cmd, 0, RADIO_STEP_DELAY_MS);
 
     /* 5. 打开射频 */
-    execute_at("AT+SFUN=4", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SFUN=4", 0, RADIO_STEP_DELAY_MS);
 
     /* 6. 激活网络 */
-    execute_at("AT+CGACT=0,1", &result);
-    if (result) g_free(result);
+    at_batch_add(batch, "AT+CGACT=0,1", 0, 0);
 
-    printf("小区锁定成功\n");
-    JsonBuilder *j = json_new();
-    json_obj_open(j);
-    json_add_int(j, "Code", 0);
-    json_add_str(j, "Error", "");
-    json_key_obj_open(j, "Data");
-    json_add_bool(j, "success", 1);
-    json_add_str(j, "message", "小区锁定成功");
-    json_obj_close(j);
-    json_obj_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
+    at_batch_run_async(batch, c->id, lock_cell_done, GSIZE_TO_POINTER(c->id));
 }
 
 /* POST /api/unlock_cell - 解锁小区 */
@@ -581,41 +653,23 @@ void handle_unlock_cell(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_POST(c, hm);
 
     printf("开始解锁小区...\n");
-    char *result = NULL;
+
+    AtBatch *batch = at_batch_new();
 
     /* 1. 关闭射频 */
-    execute_at("AT+SFUN=5", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SFUN=5", 0, RADIO_STEP_DELAY_MS);
 
     /* 2. 解锁4G */
-    execute_at("AT+SPFORCEFRQ=12,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPFORCEFRQ=12,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 3. 解锁5G */
-    execute_at("AT+SPFORCEFRQ=16,0", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SPFORCEFRQ=16,0", 0, RADIO_STEP_DELAY_MS);
 
     /* 4. 打开射频 */
-    execute_at("AT+SFUN=4", &result);
-    if (result) { g_free(result); result = NULL; }
-    usleep(300000);
+    at_batch_add(batch, "AT+SFUN=4", 0, RADIO_STEP_DELAY_MS);
 
     /* 5. 激活网络 */
-    execute_at("AT+CGACT=0,1", &result);
-    if (result) g_free(result);
+    at_batch_add(batch, "AT+CGACT=0,1", 0, 0);
 
-    printf("小区解锁成功\n");
-    JsonBuilder *j = json_new();
-    json_obj_open(j);
-    json_add_int(j, "Code", 0);
-    json_add_str(j, "Error", "");
-    json_key_obj_open(j, "Data");
-    json_add_bool(j, "success", 1);
-    json_add_str(j, "message", "小区解锁成功");
-    json_obj_close(j);
-    json_obj_close(j);
-    HTTP_OK_FREE(c, json_finish(j));
+    at_batch_run_async(batch, c->id, unlock_cell_done, GSIZE_TO_POINTER(c->id));
 }
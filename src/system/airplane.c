@@ -11,57 +11,19 @@
 #include "airplane.h"
 #include "sysinfo.h"
 #include "ofono.h"
+#include "at_cache.h"
+#include "dbus_core.h"
 
 int send_at(const char *cmd, char **result) {
-    GDBusConnection *conn = NULL;
-    GVariant *ret = NULL;
-    GError *error = NULL;
-    int rc = -1;
-    char slot[16], ril_path[32];
-
     if (!cmd || !result) return -1;
     *result = NULL;
 
-    /* 获取当前 RIL 路径 */
-    if (get_current_slot(slot, ril_path) != 0 || strcmp(ril_path, "unknown") == 0) {
-        strcpy(ril_path, "/ril_0");  /* 默认使用 ril_0 */
-    }
-
-    /* 连接系统 D-Bus */
-    conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
-    if (!conn) {
-        if (error) g_error_free(error);
-        return -1;
+    /* 与 execute_at 共用 AT 调度器，不与调度线程争用 SendAtcmd；
+     * 调用者是后台采集线程，查询按后台优先级排队（同样经过缓存和合并） */
+    if (at_cache_is_query(cmd)) {
+        return execute_at_background(cmd, result);
     }
-
-    /* 调用 SendAtcmd */
-    ret = g_dbus_connection_call_sync(
-        conn,
-        "org.ofono",
-        ril_path,
-        "org.ofono.Modem",
-        "SendAtcmd",
-        g_variant_new("(s)", cmd),
-        G_VARIANT_TYPE("(s)"),
-        G_DBUS_CALL_FLAGS_NONE,
-        8000,  /* 8秒超时 */
-        NULL,
-        &error
-    );
-
-    if (ret) {
-        const gchar *res_str = NULL;
-        g_variant_get(ret, "(s)", &res_str);
-        if (res_str) {
-            *result = g_strdup(res_str);
-            rc = 0;
-        }
-        g_variant_unref(ret);
-    }
-
-    if (error) g_error_free(error);
-    g_object_unref(conn);
-    return rc;
+    return execute_at(cmd, result);
 }
 
 
@@ -20,59 +20,27 @@ static int g_apn_initialized = 0;
 static ApnConfig g_current_config = {0};
 
 /* 前向声明 */
-static int create_apn_tables(void);
 static int load_apn_config(void);
 static int apply_apn_to_ofono(const ApnTemplate *tpl);
 
-/**
- * 创建APN数据库表
- */
-static int create_apn_tables(void) {
-    const char *sql = 
-        "CREATE TABLE IF NOT EXISTS apn_templates ("
-        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
-        "name TEXT NOT NULL,"
-        "apn TEXT NOT NULL,"
-        "protocol TEXT DEFAULT 'dual',"
-        "username TEXT,"
-        "password TEXT,"
-        "auth_method TEXT DEFAULT 'chap',"
-        "created_at INTEGER NOT NULL"
-        ");"
-        "CREATE TABLE IF NOT EXISTS apn_config ("
-        "id INTEGER PRIMARY KEY DEFAULT 1,"
-        "mode INTEGER DEFAULT 0,"
-        "template_id INTEGER,"
-        "auto_start INTEGER DEFAULT 0"
-        ");";
-    
-    return db_execute(sql);
-}
-
 /**
  * 加载APN配置
  */
 static int load_apn_config(void) {
-    char output[256];
-    const char *sql = "SELECT mode || '|' || COALESCE(template_id, 0) || '|' || auto_start FROM apn_config WHERE id = 1;";
+    int found = 0;
     
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_string(sql, output, sizeof(output));
+    db_stmt *st = db_prepare("SELECT mode, COALESCE(template_id, 0), auto_start FROM apn_config WHERE id = 1;");
+    if (st && db_step(st) == DB_ROW) {
+        g_current_config.mode = db_column_int(st, 0);
+        g_current_config.template_id = db_column_int(st, 1);
+        g_current_config.auto_start = db_column_int(st, 2);
+        found = 1;
+    }
+    db_finalize(st);
     pthread_mutex_unlock(&g_apn_mutex);
     
-    if (ret == 0 && strlen(output) > 0) {
-        char *p1 = strchr(output, '|');
-        if (p1) {
-            *p1 = '\0';
-            char *p2 = strchr(p1 + 1, '|');
-            if (p2) {
-                *p2 = '\0';
-                g_current_config.mode = atoi(output);
-                g_current_config.template_id = atoi(p1 + 1);
-                g_current_config.auto_start = atoi(p2 + 1);
-            }
-        }
-    } else {
+    if (!found) {
         /* 默认配置：自动模式 */
         g_current_config.mode = APN_MODE_AUTO;
         g_current_config.template_id = 0;
@@ -84,6 +52,21 @@ static int load_apn_config(void) {
     return 0;
 }
 
+/**
+ * 从结果行读取模板 - 列: id, name, apn, protocol, username, password, auth_method, created_at
+ */
+static void read_template_row(db_stmt *row, ApnTemplate *tpl) {
+    memset(tpl, 0, sizeof(ApnTemplate));
+    tpl->id = db_column_int(row, 0);
+    db_column_copy(row, 1, tpl->name, sizeof(tpl->name));
+    db_column_copy(row, 2, tpl->apn, sizeof(tpl->apn));
+    db_column_copy(row, 3, tpl->protocol, sizeof(tpl->protocol));
+    db_column_copy(row, 4, tpl->username, sizeof(tpl->username));
+    db_column_copy(row, 5, tpl->password, sizeof(tpl->password));
+    db_column_copy(row, 6, tpl->auth_method, sizeof(tpl->auth_method));
+    tpl->created_at = (time_t)db_column_int64(row, 7);
+}
+
 /**
  * 应用APN模板到oFono
  */
@@ -164,14 +147,9 @@ int apn_init(const char *db_path) {
     
     printf("[APN] 初始化APN模块\n");
     
-    /* 初始化数据库模块（如果还未初始化） */
-    if (db_path && strlen(db_path) > 0) {
-        db_init(db_path);
-    }
-    
-    /* 创建数据库表 */
-    if (create_apn_tables() != 0) {
-        printf("[APN] 创建数据库表失败\n");
+    /* 初始化数据库模块（如果还未初始化），APN表由数据库结构迁移创建 */
+    if (db_init(db_path) != 0) {
+        printf("[APN] 数据库初始化失败\n");
         return -1;
     }
     
@@ -185,50 +163,10 @@ int apn_init(const char *db_path) {
         
         printf("[APN] 检测到自启动配置，应用模板ID: %d\n", g_current_config.template_id);
         
-        /* 获取模板 */
+        /* 获取模板并应用 */
         ApnTemplate tpl;
-        char sql[256];
-        snprintf(sql, sizeof(sql),
-            "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
-            "FROM apn_templates WHERE id = %d;", g_current_config.template_id);
-        
-        char output[1024];
-        pthread_mutex_lock(&g_apn_mutex);
-        int ret = db_query_rows(sql, "|", output, sizeof(output));
-        pthread_mutex_unlock(&g_apn_mutex);
-        
-        if (ret == 0 && strlen(output) > 0) {
-            /* 解析模板数据 */
-            char *fields[8] = {NULL};
-            int field_count = 0;
-            char *p = output;
-            char *start = p;
-            
-            while (*p && field_count < 8) {
-                if (*p == '|') {
-                    *p = '\0';
-                    fields[field_count++] = start;
-                    start = p + 1;
-                }
-                p++;
-            }
-            if (field_count < 8 && start) {
-                fields[field_count++] = start;
-            }
-            
-            if (field_count >= 8) {
-                tpl.id = atoi(fields[0]);
-                strncpy(tpl.name, fields[1], sizeof(tpl.name) - 1);
-                strncpy(tpl.apn, fields[2], sizeof(tpl.apn) - 1);
-                strncpy(tpl.protocol, fields[3], sizeof(tpl.protocol) - 1);
-                strncpy(tpl.username, fields[4], sizeof(tpl.username) - 1);
-                strncpy(tpl.password, fields[5], sizeof(tpl.password) - 1);
-                strncpy(tpl.auth_method, fields[6], sizeof(tpl.auth_method) - 1);
-                tpl.created_at = (time_t)atol(fields[7]);
-                
-                /* 应用模板 */
-                apply_apn_to_ofono(&tpl);
-            }
+        if (apn_template_get(g_current_config.template_id, &tpl) == 0) {
+            apply_apn_to_ofono(&tpl);
         }
     }
     
@@ -295,95 +233,41 @@ int apn_set_mode(int mode, int template_id, int auto_start) {
     return 0;
 }
 
+/* 模板列表填充上下文 */
+typedef struct {
+    ApnTemplate *templates;
+    int max_count;
+    int count;
+} TemplateListCtx;
+
+static int template_row_cb(db_stmt *row, void *user_data) {
+    TemplateListCtx *ctx = (TemplateListCtx *)user_data;
+    read_template_row(row, &ctx->templates[ctx->count++]);
+    return ctx->count >= ctx->max_count;
+}
+
 /**
  * 获取模板列表
  */
 int apn_template_list(ApnTemplate *templates, int max_count) {
-    char *output = NULL;
+    TemplateListCtx ctx = { templates, max_count, 0 };
     
     if (!templates || max_count <= 0) {
         return -1;
     }
     
-    /* 分配大缓冲区 */
-    output = (char *)malloc(64 * 1024);
-    if (!output) {
-        return -1;
-    }
-    
-    const char *sql = 
-        "SELECT id || '|' || name || '|' || apn || '|' || protocol || '|' || "
-        "COALESCE(username, '') || '|' || COALESCE(password, '') || '|' || "
-        "auth_method || '|' || created_at FROM apn_templates ORDER BY id DESC;";
-    
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_string(sql, output, 64 * 1024);
-    pthread_mutex_unlock(&g_apn_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
-        free(output);
-        return 0;
-    }
-    
-    /* 解析输出 */
-    int count = 0;
-    char *line = output;
-    char *next_line;
-    
-    while (line && *line && count < max_count) {
-        next_line = strchr(line, '\n');
-        if (next_line) {
-            *next_line = '\0';
-            next_line++;
-        }
-        
-        if (strlen(line) == 0) {
-            line = next_line;
-            continue;
-        }
-        
-        /* 解析字段 */
-        char *fields[8] = {NULL};
-        int field_count = 0;
-        char *p = line;
-        char *start = p;
-        
-        while (*p && field_count < 8) {
-            if (*p == '|') {
-                *p = '\0';
-                fields[field_count++] = start;
-                start = p + 1;
-            }
-            p++;
-        }
-        if (field_count < 8 && start) {
-            fields[field_count++] = start;
-        }
-        
-        if (field_count >= 8) {
-            templates[count].id = atoi(fields[0]);
-            strncpy(templates[count].name, fields[1], sizeof(templates[count].name) - 1);
-            templates[count].name[sizeof(templates[count].name) - 1] = '\0';
-            strncpy(templates[count].apn, fields[2], sizeof(templates[count].apn) - 1);
-            templates[count].apn[sizeof(templates[count].apn) - 1] = '\0';
-            strncpy(templates[count].protocol, fields[3], sizeof(templates[count].protocol) - 1);
-            templates[count].protocol[sizeof(templates[count].protocol) - 1] = '\0';
-            strncpy(templates[count].username, fields[4], sizeof(templates[count].username) - 1);
-            templates[count].username[sizeof(templates[count].username) - 1] = '\0';
-            strncpy(templates[count].password, fields[5], sizeof(templates[count].password) - 1);
-            templates[count].password[sizeof(templates[count].password) - 1] = '\0';
-            strncpy(templates[count].auth_method, fields[6], sizeof(templates[count].auth_method) - 1);
-            templates[count].auth_method[sizeof(templates[count].auth_method) - 1] = '\0';
-            templates[count].created_at = (time_t)atol(fields[7]);
-            count++;
-        }
-        
-        line = next_line;
+    db_stmt *st = db_prepare(
+        "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
+        "FROM apn_templates ORDER BY id DESC;");
+    if (st) {
+        db_foreach(st, template_row_cb, &ctx);
+        db_finalize(st);
     }
+    pthread_mutex_unlock(&g_apn_mutex);
     
-    free(output);
-    printf("[APN] 获取到 %d 个模板\n", count);
-    return count;
+    printf("[APN] 获取到 %d 个模板\n", ctx.count);
+    return ctx.count;
 }
 
 /**
@@ -391,11 +275,7 @@ int apn_template_list(ApnTemplate *templates, int max_count) {
  */
 int apn_template_create(const char *name, const char *apn, const char *protocol,
                        const char *username, const char *password, const char *auth_method) {
-    char sql[2048];
-    char escaped_name[256];
-    char escaped_apn[256];
-    char escaped_username[256];
-    char escaped_password[256];
+    int ret = -1;
     
     /* 参数校验 */
     if (!name || !apn || strlen(name) == 0 || strlen(apn) == 0) {
@@ -403,22 +283,21 @@ int apn_template_create(const char *name, const char *apn, const char *protocol,
         return -1;
     }
     
-    /* 转义特殊字符 */
-    db_escape_string(name, escaped_name, sizeof(escaped_name));
-    db_escape_string(apn, escaped_apn, sizeof(escaped_apn));
-    db_escape_string(username ? username : "", escaped_username, sizeof(escaped_username));
-    db_escape_string(password ? password : "", escaped_password, sizeof(escaped_password));
-    
-    time_t now = time(NULL);
-    
-    snprintf(sql, sizeof(sql),
-        "INSERT INTO apn_templates (name, apn, protocol, username, password, auth_method, created_at) "
-        "VALUES ('%s', '%s', '%s', '%s', '%s', '%s', %ld);",
-        escaped_name, escaped_apn, protocol ? protocol : "dual", 
-        escaped_username, escaped_password, auth_method ? auth_method : "chap", (long)now);
-    
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_execute(sql);
+    db_stmt *st = db_prepare(
+        "INSERT INTO apn_templates (name, apn, protocol, username, password, auth_method, created_at) "
+        "VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7);");
+    if (st) {
+        db_bind_text(st, 1, name);
+        db_bind_text(st, 2, apn);
+        db_bind_text(st, 3, protocol ? protocol : "dual");
+        db_bind_text(st, 4, username ? username : "");
+        db_bind_text(st, 5, password ? password : "");
+        db_bind_text(st, 6, auth_method ? auth_method : "chap");
+        db_bind_int64(st, 7, (long long)time(NULL));
+        ret = db_step(st) == DB_DONE ? 0 : -1;
+        db_finalize(st);
+    }
     pthread_mutex_unlock(&g_apn_mutex);
     
     if (ret == 0) {
@@ -435,11 +314,7 @@ int apn_template_create(const char *name, const char *apn, const char *protocol,
  */
 int apn_template_update(int id, const char *name, const char *apn, const char *protocol,
                        const char *username, const char *password, const char *auth_method) {
-    char sql[2048];
-    char escaped_name[256];
-    char escaped_apn[256];
-    char escaped_username[256];
-    char escaped_password[256];
+    int ret = -1;
     
     if (id <= 0) {
         return -1;
@@ -451,20 +326,21 @@ int apn_template_update(int id, const char *name, const char *apn, const char *p
         return -1;
     }
     
-    /* 转义特殊字符 */
-    db_escape_string(name, escaped_name, sizeof(escaped_name));
-    db_escape_string(apn, escaped_apn, sizeof(escaped_apn));
-    db_escape_string(username ? username : "", escaped_username, sizeof(escaped_username));
-    db_escape_string(password ? password : "", escaped_password, sizeof(escaped_password));
-    
-    snprintf(sql, sizeof(sql),
-        "UPDATE apn_templates SET name='%s', apn='%s', protocol='%s', "
-        "username='%s', password='%s', auth_method='%s' WHERE id=%d;",
-        escaped_name, escaped_apn, protocol ? protocol : "dual",
-        escaped_username, escaped_password, auth_method ? auth_method : "chap", id);
-    
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_execute(sql);
+    db_stmt *st = db_prepare(
+        "UPDATE apn_templates SET name = ?1, apn = ?2, protocol = ?3, "
+        "username = ?4, password = ?5, auth_method = ?6 WHERE id = ?7;");
+    if (st) {
+        db_bind_text(st, 1, name);
+        db_bind_text(st, 2, apn);
+        db_bind_text(st, 3, protocol ? protocol : "dual");
+        db_bind_text(st, 4, username ? username : "");
+        db_bind_text(st, 5, password ? password : "");
+        db_bind_text(st, 6, auth_method ? auth_method : "chap");
+        db_bind_int(st, 7, id);
+        ret = db_step(st) == DB_DONE ? 0 : -1;
+        db_finalize(st);
+    }
     pthread_mutex_unlock(&g_apn_mutex);
     
     if (ret == 0) {
@@ -511,8 +387,6 @@ int apn_template_delete(int id) {
  * 应用模板
  */
 int apn_apply_template(int template_id) {
-    char sql[256];
-    char output[1024];
     ApnTemplate tpl;
     
     if (template_id <= 0) {
@@ -521,57 +395,11 @@ int apn_apply_template(int template_id) {
     }
     
     /* 查询模板 */
-    snprintf(sql, sizeof(sql),
-        "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
-        "FROM apn_templates WHERE id = %d;", template_id);
-    
-    pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_rows(sql, "|", output, sizeof(output));
-    pthread_mutex_unlock(&g_apn_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
+    if (apn_template_get(template_id, &tpl) != 0) {
         printf("[APN] 模板不存在: %d\n", template_id);
         return -1;
     }
     
-    /* 解析模板数据 */
-    char *fields[8] = {NULL};
-    int field_count = 0;
-    char *p = output;
-    char *start = p;
-    
-    while (*p && field_count < 8) {
-        if (*p == '|') {
-            *p = '\0';
-            fields[field_count++] = start;
-            start = p + 1;
-        }
-        p++;
-    }
-    if (field_count < 8 && start) {
-        fields[field_count++] = start;
-    }
-    
-    if (field_count < 8) {
-        printf("[APN] 模板数据解析失败\n");
-        return -1;
-    }
-    
-    tpl.id = atoi(fields[0]);
-    strncpy(tpl.name, fields[1], sizeof(tpl.name) - 1);
-    tpl.name[sizeof(tpl.name) - 1] = '\0';
-    strncpy(tpl.apn, fields[2], sizeof(tpl.apn) - 1);
-    tpl.apn[sizeof(tpl.apn) - 1] = '\0';
-    strncpy(tpl.protocol, fields[3], sizeof(tpl.protocol) - 1);
-    tpl.protocol[sizeof(tpl.protocol) - 1] = '\0';
-    strncpy(tpl.username, fields[4], sizeof(tpl.username) - 1);
-    tpl.username[sizeof(tpl.username) - 1] = '\0';
-    strncpy(tpl.password, fields[5], sizeof(tpl.password) - 1);
-    tpl.password[sizeof(tpl.password) - 1] = '\0';
-    strncpy(tpl.auth_method, fields[6], sizeof(tpl.auth_method) - 1);
-    tpl.auth_method[sizeof(tpl.auth_method) - 1] = '\0';
-    tpl.created_at = (time_t)atol(fields[7]);
-    
     /* 应用到oFono */
     return apply_apn_to_ofono(&tpl);
 }
@@ -629,8 +457,7 @@ int apn_clear_all(void) {
  * 获取模板详情
  */
 int apn_template_get(int id, ApnTemplate *tpl) {
-    char sql[256];
-    char output[1024];
+    int ret = -1;
     
     if (id <= 0 || !tpl) {
         return -1;
@@ -638,50 +465,21 @@ int apn_template_get(int id, ApnTemplate *tpl) {
     
     memset(tpl, 0, sizeof(ApnTemplate));
     
-    snprintf(sql, sizeof(sql),
-        "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
-        "FROM apn_templates WHERE id = %d;", id);
-    
     pthread_mutex_lock(&g_apn_mutex);
-    int ret = db_query_rows(sql, "|", output, sizeof(output));
-    pthread_mutex_unlock(&g_apn_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
-        return -1;
-    }
-    
-    /* 解析模板数据 */
-    char *fields[8] = {NULL};
-    int field_count = 0;
-    char *p = output;
-    char *start = p;
-    
-    while (*p && field_count < 8) {
-        if (*p == '|') {
-            *p = '\0';
-            fields[field_count++] = start;
-            start = p + 1;
+    db_stmt *st = db_prepare_cached("apn_template_get",
+        "SELECT id, name, apn, protocol, username, password, auth_method, created_at "
+        "FROM apn_templates WHERE id = ?1;");
+    if (st) {
+        db_bind_int(st, 1, id);
+        if (db_step(st) == DB_ROW) {
+            read_template_row(st, tpl);
+            ret = 0;
         }
-        p++;
+        db_finalize(st);
     }
-    if (field_count < 8 && start) {
-        fields[field_count++] = start;
-    }
-    
-    if (field_count < 8) {
-        return -1;
-    }
-    
-    tpl->id = atoi(fields[0]);
-    strncpy(tpl->name, fields[1], sizeof(tpl->name) - 1);
-    strncpy(tpl->apn, fields[2], sizeof(tpl->apn) - 1);
-    strncpy(tpl->protocol, fields[3], sizeof(tpl->protocol) - 1);
-    strncpy(tpl->username, fields[4], sizeof(tpl->username) - 1);
-    strncpy(tpl->password, fields[5], sizeof(tpl->password) - 1);
-    strncpy(tpl->auth_method, fields[6], sizeof(tpl->auth_method) - 1);
-    tpl->created_at = (time_t)atol(fields[7]);
+    pthread_mutex_unlock(&g_apn_mutex);
     
-    return 0;
+    return ret;
 }
 
 /**
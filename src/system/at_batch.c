@@ -0,0 +1,163 @@
+/**
+ * @file at_batch.c
+ * @brief 异步 AT 命令序列实现
+ */
+
+#include <stdio.h>
+#include <glib.h>
+#include "at_batch.h"
+#include "at_cache.h"
+#include "dbus_core.h"
+
+struct AtBatch {
+    int count;
+    int current;                            /* 正在执行的步骤 */
+    char *commands[AT_BATCH_MAX_STEPS];
+    int flags[AT_BATCH_MAX_STEPS];
+    int delay_ms[AT_BATCH_MAX_STEPS];
+    int rc[AT_BATCH_MAX_STEPS];
+    char *results[AT_BATCH_MAX_STEPS];
+    char *errors[AT_BATCH_MAX_STEPS];
+    int failed_step;
+    int has_write;                          /* 含写命令，不可中止 */
+    int aborted;
+    unsigned int pending_id;                /* 排队中的 execute_at_async 请求 */
+    guint timer_id;                         /* 步骤间隔定时器 */
+    unsigned long owner;
+    AtBatchDoneFunc done;
+    void *user_data;
+};
+
+/* 正在执行的序列（仅在主循环中访问） */
+static GList *g_batches = NULL;
+
+static void start_step(AtBatch *b);
+
+AtBatch *at_batch_new(void) {
+    AtBatch *b = g_new0(AtBatch, 1);
+    b->failed_step = -1;
+    for (int i = 0; i < AT_BATCH_MAX_STEPS; i++) {
+        b->rc[i] = -1;
+    }
+    return b;
+}
+
+int at_batch_add(AtBatch *b, const char *command, int flags, int delay_ms) {
+    if (!b || !command || b->count >= AT_BATCH_MAX_STEPS) {
+        return -1;
+    }
+    int i = b->count++;
+    b->commands[i] = g_strdup(command);
+    b->flags[i] = flags;
+    b->delay_ms[i] = delay_ms;
+    if (!at_cache_is_query(command)) {
+        b->has_write = 1;
+    }
+    return i;
+}
+
+void at_batch_free(AtBatch *b) {
+    if (!b) return;
+    for (int i = 0; i < b->count; i++) {
+        g_free(b->commands[i]);
+        g_free(b->results[i]);
+        g_free(b->errors[i]);
+    }
+    g_free(b);
+}
+
+static void finish(AtBatch *b) {
+    g_batches = g_list_remove(g_batches, b);
+    b->done(b, b->user_data);
+    at_batch_free(b);
+}
+
+static gboolean step_timer_cb(gpointer data) {
+    AtBatch *b = data;
+    b->timer_id = 0;
+    start_step(b);
+    return G_SOURCE_REMOVE;
+}
+
+static void on_step_done(int rc, const char *result, const char *error, void *user_data) {
+    AtBatch *b = user_data;
+    int i = b->current;
+
+    b->pending_id = 0;
+    b->rc[i] = rc;
+    b->results[i] = g_strdup(result);
+    b->errors[i] = g_strdup(error);
+
+    if (rc != 0 && (b->flags[i] & AT_BATCH_REQUIRED)) {
+        printf("[AT_BATCH] %s 失败，跳过后续命令: %s\n", b->commands[i], error ? error : "unknown");
+        b->failed_step = i;
+        finish(b);
+        return;
+    }
+
+    b->current++;
+    if (b->current < b->count && b->delay_ms[i] > 0 && !b->aborted) {
+        b->timer_id = g_timeout_add(b->delay_ms[i], step_timer_cb, b);
+        return;
+    }
+    start_step(b);
+}
+
+static void start_step(AtBatch *b) {
+    if (b->aborted || b->current >= b->count) {
+        finish(b);
+        return;
+    }
+    b->pending_id = execute_at_async(b->commands[b->current], on_step_done, b);
+}
+
+void at_batch_run_async(AtBatch *b, unsigned long owner, AtBatchDoneFunc done, void *user_data) {
+    b->owner = owner;
+    b->done = done;
+    b->user_data = user_data;
+    g_batches = g_list_prepend(g_batches, b);
+
+    if (b->count == 0) {
+        /* 与其他情况一致，不在调用者栈上回调 */
+        b->timer_id = g_idle_add(step_timer_cb, b);
+        return;
+    }
+    start_step(b);
+}
+
+void at_batch_abort_owner(unsigned long owner) {
+    for (GList *l = g_batches; l; l = l->next) {
+        AtBatch *b = l->data;
+        if (b->owner != owner || b->has_write || b->aborted) {
+            continue;
+        }
+        b->aborted = 1;
+        if (b->pending_id) {
+            /* 命令完成回调仍会到达，届时结束序列 */
+            execute_at_cancel(b->pending_id);
+        } else if (b->timer_id) {
+            g_source_remove(b->timer_id);
+            b->timer_id = g_idle_add(step_timer_cb, b);
+        }
+    }
+}
+
+int at_batch_rc(AtBatch *b, int index) {
+    return (index >= 0 && index < b->count) ? b->rc[index] : -1;
+}
+
+const char *at_batch_result(AtBatch *b, int index) {
+    return (index >= 0 && index < b->count) ? b->results[index] : NULL;
+}
+
+const char *at_batch_error(AtBatch *b, int index) {
+    return (index >= 0 && index < b->count) ? b->errors[index] : NULL;
+}
+
+int at_batch_failed_step(AtBatch *b) {
+    return b->failed_step;
+}
+
+int at_batch_aborted(AtBatch *b) {
+    return b->aborted;
+}
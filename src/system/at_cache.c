@@ -0,0 +1,203 @@
+/**
+ * @file at_cache.c
+ * @brief AT 命令结果缓存实现
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <glib.h>
+#include "at_cache.h"
+
+/* 只读查询命令（按大写前缀匹配），ttl_ms 为 0 的只做并发合并不缓存 */
+typedef struct {
+    const char *prefix;
+    int ttl_ms;
+} AtCacheRule;
+
+static const AtCacheRule g_cache_rules[] = {
+    { "AT+SPENGMD=0,", AT_CACHE_TTL_ENGMODE_MS },
+    { "AT+SPLBAND=0",  AT_CACHE_TTL_BAND_MS },
+    { "AT+SPLBAND=3",  AT_CACHE_TTL_BAND_MS },
+    { "AT+CGEQOSRDP",  AT_CACHE_TTL_QOS_MS },
+    { "AT+CSQ",        0 },
+    { "AT+CCID",       0 },
+    { "AT+CIMI",       0 },
+    { "AT+CGSN",       0 },
+};
+
+/* 写命令影响的缓存前缀，affects 为 NULL 表示不影响任何缓存，"" 表示全部 */
+typedef struct {
+    const char *prefix;
+    const char *affects;
+} AtInvalidateRule;
+
+static const AtInvalidateRule g_invalidate_rules[] = {
+    { "AT+SPLBAND=",    "AT+SPLBAND=" },     /* 频段锁定 */
+    { "AT+SPFORCEFRQ=", "AT+SPENGMD=" },     /* 频点/小区锁定 */
+    { "AT+CGACT=",      "AT+CGEQOSRDP" },    /* 数据连接激活/去激活 */
+    { "AT+CNMI=",       NULL },              /* 短信上报方式 */
+    { "AT+SFUN=",       "" },                /* 射频开关，所有状态都会变化 */
+};
+
+typedef struct {
+    char *result;
+    gint64 expires_ms;
+} AtCacheEntry;
+
+static pthread_mutex_t g_at_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable *g_at_cache = NULL;   /* 大写命令 -> AtCacheEntry */
+
+static gint64 now_ms(void) {
+    return g_get_monotonic_time() / 1000;
+}
+
+static void entry_free(gpointer p) {
+    AtCacheEntry *e = p;
+    g_free(e->result);
+    g_free(e);
+}
+
+/* 生成缓存键：去除首尾空白并转为大写，返回值需 g_free */
+static char *make_key(const char *command) {
+    char *key = g_ascii_strup(command, -1);
+    return g_strstrip(key);
+}
+
+/* 查找只读查询规则，不是已知查询返回 NULL */
+static const AtCacheRule *find_rule(const char *key) {
+    size_t i;
+    for (i = 0; i < G_N_ELEMENTS(g_cache_rules); i++) {
+        if (g_str_has_prefix(key, g_cache_rules[i].prefix)) {
+            return &g_cache_rules[i];
+        }
+    }
+    return NULL;
+}
+
+/* "AT+XXX?" / "AT+XXX=?" 是查询，不改变状态 */
+static int is_query_form(const char *key) {
+    size_t len = strlen(key);
+    return len > 0 && key[len - 1] == '?';
+}
+
+static gboolean match_prefix(gpointer key, gpointer value, gpointer prefix) {
+    (void)value;
+    return g_str_has_prefix(key, prefix);
+}
+
+static gboolean match_expired(gpointer key, gpointer value, gpointer now) {
+    (void)key;
+    return ((AtCacheEntry *)value)->expires_ms <= *(gint64 *)now;
+}
+
+/* 使写命令影响的缓存失效（调用时已持有锁） */
+static void invalidate_for_write(const char *key) {
+    const char *affects = "";
+    size_t i;
+
+    if (!g_at_cache || g_hash_table_size(g_at_cache) == 0) {
+        return;
+    }
+
+    /* 未知命令（如网页终端输入的任意命令）保守处理为全部失效 */
+    for (i = 0; i < G_N_ELEMENTS(g_invalidate_rules); i++) {
+        if (g_str_has_prefix(key, g_invalidate_rules[i].prefix)) {
+            affects = g_invalidate_rules[i].affects;
+            break;
+        }
+    }
+
+    if (!affects) {
+        return;
+    }
+    if (affects[0] == '\0') {
+        g_hash_table_remove_all(g_at_cache);
+    } else {
+        g_hash_table_foreach_remove(g_at_cache, match_prefix, (gpointer)affects);
+    }
+}
+
+int at_cache_lookup(const char *command, char **result) {
+    int rc = -1;
+
+    if (!command || !result) {
+        return -1;
+    }
+
+    char *key = make_key(command);
+    const AtCacheRule *rule = find_rule(key);
+    if (rule && rule->ttl_ms > 0) {
+        pthread_mutex_lock(&g_at_cache_mutex);
+        AtCacheEntry *e = g_at_cache ? g_hash_table_lookup(g_at_cache, key) : NULL;
+        if (e && e->expires_ms > now_ms()) {
+            *result = g_strdup(e->result);
+            rc = 0;
+        }
+        pthread_mutex_unlock(&g_at_cache_mutex);
+    }
+
+    if (rc == 0) {
+        printf("[AT_CACHE] 命中缓存: %s\n", key);
+    }
+    g_free(key);
+    return rc;
+}
+
+void at_cache_update(const char *command, const char *result) {
+    if (!command || !command[0]) {
+        return;
+    }
+
+    char *key = make_key(command);
+    const AtCacheRule *rule = find_rule(key);
+
+    pthread_mutex_lock(&g_at_cache_mutex);
+    if (!rule && !is_query_form(key)) {
+        invalidate_for_write(key);
+        g_free(key);
+    } else if (rule && rule->ttl_ms > 0 && result) {
+        if (!g_at_cache) {
+            g_at_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, entry_free);
+        }
+
+        gint64 now = now_ms();
+        if (g_hash_table_size(g_at_cache) >= AT_CACHE_MAX_ENTRIES &&
+            !g_hash_table_contains(g_at_cache, key)) {
+            g_hash_table_foreach_remove(g_at_cache, match_expired, &now);
+            if (g_hash_table_size(g_at_cache) >= AT_CACHE_MAX_ENTRIES) {
+                g_hash_table_remove_all(g_at_cache);
+            }
+        }
+
+        AtCacheEntry *e = g_new0(AtCacheEntry, 1);
+        e->result = g_strdup(result);
+        e->expires_ms = now + rule->ttl_ms;
+        g_hash_table_replace(g_at_cache, key, e);
+    } else {
+        g_free(key);
+    }
+    pthread_mutex_unlock(&g_at_cache_mutex);
+}
+
+int at_cache_is_query(const char *command) {
+    if (!command) {
+        return 0;
+    }
+    char *key = make_key(command);
+    int query = find_rule(key) != NULL || is_query_form(key);
+    g_free(key);
+    return query;
+}
+
+char *at_cache_key(const char *command) {
+    return make_key(command);
+}
+
+void at_cache_invalidate_all(void) {
+    pthread_mutex_lock(&g_at_cache_mutex);
+    if (g_at_cache) {
+        g_hash_table_remove_all(g_at_cache);
+    }
+    pthread_mutex_unlock(&g_at_cache_mutex);
+}
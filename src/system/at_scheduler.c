@@ -0,0 +1,609 @@
+/**
+ * @file at_scheduler.c
+ * @brief AT 命令调度器实现
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <glib.h>
+#include "at_scheduler.h"
+#include "at_cache.h"
+
+typedef struct {
+    unsigned int id;
+    char *command;
+    AtPriority prio;
+    long long submit_ms;
+    long long deadline_ms;
+    long long not_before_ms;            /* 退避中，此前不发送 */
+    int attempts;                       /* 已发送次数 */
+    int backoff_ms;
+    int cancelled;
+    char *error;                        /* 最近一次发送的错误信息 */
+    char *key;                          /* 可合并的查询的规范化命令，否则为 NULL */
+    GQueue followers;                   /* 合并到本请求、共用其结果的相同查询 */
+    AtDoneFunc done;
+    void *user_data;
+} AtRequest;
+
+/* 统计累加值 */
+typedef struct {
+    int max_depth;
+    unsigned long submitted, completed, failed, expired, cancelled, retries, coalesced;
+    long long wait_sum_ms, wait_max_ms;
+    unsigned long wait_count;
+    long long exec_sum_ms;
+    unsigned long exec_count;
+} PrioCounters;
+
+static pthread_mutex_t g_sched_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_sched_cond;
+static pthread_t g_sched_thread;
+static int g_sched_running = 0;
+static AtTransportFunc g_send = NULL;
+
+/* 以下均受 g_sched_mutex 保护 */
+static GQueue g_queues[AT_PRIO_COUNT];
+static AtRequest *g_current = NULL;     /* 正在发送的请求 */
+static PrioCounters g_counters[AT_PRIO_COUNT];
+static unsigned int g_next_id = 1;
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void request_free(AtRequest *req) {
+    g_free(req->command);
+    g_free(req->error);
+    g_free(req->key);
+    g_free(req);
+}
+
+/* 记录结束状态（调用时已持有锁） */
+static void count_finish(AtRequest *req, int rc) {
+    PrioCounters *pc = &g_counters[req->prio];
+    switch (rc) {
+    case AT_SCHED_OK:        pc->completed++; break;
+    case AT_SCHED_CANCELLED: pc->cancelled++; break;
+    case AT_SCHED_EXPIRED:   pc->expired++;   break;
+    default:                 pc->failed++;    break;
+    }
+}
+
+/* 请求自身的结束状态：发送中被取消的请求以 AT_SCHED_CANCELLED 结束，跟随请求不受影响 */
+static int own_rc(const AtRequest *req, int rc) {
+    return req->cancelled ? AT_SCHED_CANCELLED : rc;
+}
+
+/* 记录请求及其跟随请求的结束状态（调用时已持有锁） */
+static void count_finish_all(AtRequest *req, int rc) {
+    count_finish(req, own_rc(req, rc));
+    for (GList *l = req->followers.head; l; l = l->next) {
+        count_finish(l->data, rc);
+    }
+}
+
+static void deliver(AtRequest *req, int rc, const char *result, const char *send_error) {
+    const char *error = NULL;
+
+    switch (rc) {
+    case AT_SCHED_OK:        break;
+    case AT_SCHED_CANCELLED: error = "AT 命令已取消"; break;
+    case AT_SCHED_EXPIRED:   error = "AT 命令排队超时"; break;
+    default:                 error = send_error ? send_error : "AT 命令执行失败"; break;
+    }
+    req->done(rc, rc == AT_SCHED_OK ? result : NULL, error, req->user_data);
+}
+
+/* 调用请求及其跟随请求的完成回调并释放（调用时不持有锁） */
+static void finish(AtRequest *req, int rc, const char *result) {
+    AtRequest *f;
+
+    while ((f = g_queue_pop_head(&req->followers))) {
+        deliver(f, rc, result, req->error);
+        request_free(f);
+    }
+    deliver(req, own_rc(req, rc), result, req->error);
+    request_free(req);
+}
+
+/**
+ * 查找可合并的相同查询：正在发送的，或同等及更高优先级排队中的（调用时已持有锁）
+ * 不合并到更低优先级的请求，避免用户查询跟着后台轮询排队
+ */
+static AtRequest *find_leader(const char *key, AtPriority prio) {
+    if (g_current && g_current->key && !g_current->cancelled && strcmp(g_current->key, key) == 0) {
+        return g_current;
+    }
+    for (int p = 0; p <= (int)prio; p++) {
+        for (GList *l = g_queues[p].head; l; l = l->next) {
+            AtRequest *req = l->data;
+            if (req->key && strcmp(req->key, key) == 0) {
+                return req;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 请求不再发送（取消或超时）时，其余跟随请求改为独立排队（调用时已持有锁）
+ * 优先级最高的跟随请求成为新的发送请求，其余合并到它；已过截止时间的留在原请求上一起结束
+ * @return 1 有请求重新排队, 0 没有
+ */
+static int promote_followers(AtRequest *req, long long now) {
+    AtRequest *leader = NULL;
+
+    for (GList *l = req->followers.head; l; l = l->next) {
+        AtRequest *f = l->data;
+        if (f->deadline_ms > now && (!leader || f->prio < leader->prio)) {
+            leader = f;
+        }
+    }
+    if (!leader) {
+        return 0;
+    }
+
+    g_queue_remove(&req->followers, leader);
+    GList *l = req->followers.head;
+    while (l) {
+        GList *next = l->next;
+        AtRequest *f = l->data;
+        if (f->deadline_ms > now) {
+            g_queue_delete_link(&req->followers, l);
+            g_queue_push_tail(&leader->followers, f);
+        }
+        l = next;
+    }
+    g_queue_push_head(&g_queues[leader->prio], leader);
+    return 1;
+}
+
+/* 从排队中请求的跟随请求里查找并移除（调用时已持有锁） */
+static AtRequest *remove_follower(AtRequest *leader, unsigned int id) {
+    for (GList *l = leader->followers.head; l; l = l->next) {
+        AtRequest *f = l->data;
+        if (f->id == id) {
+            g_queue_delete_link(&leader->followers, l);
+            return f;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 选出下一个可发送的请求（调用时已持有锁）
+ * 已过截止时间的请求移入 expired；没有可发送的请求时 wake_ms 为下次需要检查的时间
+ */
+static AtRequest *pick_request(long long now, GQueue *expired, long long *wake_ms) {
+    AtRequest *picked = NULL;
+    *wake_ms = -1;
+
+    for (int p = 0; p < AT_PRIO_COUNT; p++) {
+        GList *l = g_queues[p].head;
+        while (l) {
+            GList *next = l->next;
+            AtRequest *req = l->data;
+
+            /* 跟随请求按各自的截止时间超时 */
+            GList *fl = req->followers.head;
+            while (fl) {
+                GList *fnext = fl->next;
+                AtRequest *f = fl->data;
+                if (f->deadline_ms <= now) {
+                    g_queue_delete_link(&req->followers, fl);
+                    g_queue_push_tail(expired, f);
+                } else if (*wake_ms < 0 || f->deadline_ms < *wake_ms) {
+                    *wake_ms = f->deadline_ms;
+                }
+                fl = fnext;
+            }
+
+            if (req->deadline_ms <= now) {
+                g_queue_delete_link(&g_queues[p], l);
+                g_queue_push_tail(expired, req);
+            } else if (!picked && req->not_before_ms <= now) {
+                g_queue_delete_link(&g_queues[p], l);
+                picked = req;
+            } else {
+                long long t = req->not_before_ms > now ? req->not_before_ms : req->deadline_ms;
+                if (req->deadline_ms < t) t = req->deadline_ms;
+                if (*wake_ms < 0 || t < *wake_ms) *wake_ms = t;
+            }
+            l = next;
+        }
+    }
+    return picked;
+}
+
+/**
+ * 发送失败后决定是否重试（调用时已持有锁）
+ * @return 1 已重新排队, 0 不再重试
+ */
+static int schedule_retry(AtRequest *req, AtSendStatus status, long long now) {
+    int delay;
+
+    if (req->cancelled || req->attempts >= AT_SCHED_MAX_ATTEMPTS) {
+        return 0;
+    }
+
+    switch (status) {
+    case AT_SEND_BUSY:
+        req->backoff_ms = req->backoff_ms ? req->backoff_ms * 2 : AT_SCHED_BUSY_BACKOFF_MS;
+        if (req->backoff_ms > AT_SCHED_BUSY_BACKOFF_MAX_MS) {
+            req->backoff_ms = AT_SCHED_BUSY_BACKOFF_MAX_MS;
+        }
+        delay = req->backoff_ms;
+        break;
+    case AT_SEND_DISCONNECTED:
+        delay = AT_SCHED_RECONNECT_BACKOFF_MS;
+        break;
+    case AT_SEND_TIMEOUT:
+        /* 写命令可能已经生效，重发有副作用 */
+        if (req->prio == AT_PRIO_WRITE) {
+            return 0;
+        }
+        delay = 0;
+        break;
+    default:
+        return 0;
+    }
+
+    if (now + delay >= req->deadline_ms) {
+        return 0;
+    }
+
+    req->not_before_ms = now + delay;
+    g_counters[req->prio].retries++;
+    g_queue_push_head(&g_queues[req->prio], req);
+    printf("[AT_SCHED] %s 第 %d 次发送失败 (状态 %d)，%d ms 后重试\n",
+           req->command, req->attempts, status, delay);
+    return 1;
+}
+
+static void *scheduler_thread_func(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_sched_mutex);
+    while (g_sched_running) {
+        GQueue expired = G_QUEUE_INIT;
+        long long wake_ms;
+        long long now = now_ms();
+        AtRequest *req = pick_request(now, &expired, &wake_ms);
+        int promoted = 0;
+
+        if (!g_queue_is_empty(&expired)) {
+            AtRequest *e;
+            for (GList *l = expired.head; l; l = l->next) {
+                promoted |= promote_followers(l->data, now);
+                count_finish_all(l->data, AT_SCHED_EXPIRED);
+            }
+            pthread_mutex_unlock(&g_sched_mutex);
+            while ((e = g_queue_pop_head(&expired))) {
+                printf("[AT_SCHED] %s 等待超时，未发送\n", e->command);
+                finish(e, AT_SCHED_EXPIRED, NULL);
+            }
+            pthread_mutex_lock(&g_sched_mutex);
+        }
+
+        if (!req) {
+            if (promoted) {
+                continue;
+            }
+            if (wake_ms < 0) {
+                pthread_cond_wait(&g_sched_cond, &g_sched_mutex);
+            } else {
+                struct timespec ts;
+                ts.tv_sec = wake_ms / 1000;
+                ts.tv_nsec = (wake_ms % 1000) * 1000000;
+                pthread_cond_timedwait(&g_sched_cond, &g_sched_mutex, &ts);
+            }
+            continue;
+        }
+
+        PrioCounters *pc = &g_counters[req->prio];
+        if (req->attempts == 0) {
+            long long wait = now - req->submit_ms;
+            pc->wait_sum_ms += wait;
+            pc->wait_count++;
+            if (wait > pc->wait_max_ms) pc->wait_max_ms = wait;
+        }
+        g_current = req;
+        pthread_mutex_unlock(&g_sched_mutex);
+
+        /* 排队期间同一查询可能已被执行并缓存 */
+        char *result = NULL;
+        AtSendStatus status;
+        int sent = 0;
+        if (req->attempts == 0 && at_cache_lookup(req->command, &result) == 0) {
+            status = AT_SEND_OK;
+        } else {
+            long long remain = req->deadline_ms - now;
+            int timeout = remain < AT_SCHED_SEND_TIMEOUT_MS ? (int)remain : AT_SCHED_SEND_TIMEOUT_MS;
+            char *error = NULL;
+            status = g_send(req->command, timeout, &result, &error);
+            if (status != AT_SEND_OK) {
+                /* 只有调度线程访问，保留最近一次的错误 */
+                g_free(req->error);
+                req->error = error ? error : g_strdup("AT 命令执行失败");
+            } else {
+                g_free(error);
+            }
+            req->attempts++;
+            sent = 1;
+        }
+        long long end = now_ms();
+
+        pthread_mutex_lock(&g_sched_mutex);
+        g_current = NULL;
+        if (sent) {
+            pc->exec_sum_ms += end - now;
+            pc->exec_count++;
+        }
+        if (status != AT_SEND_OK && schedule_retry(req, status, end)) {
+            continue;
+        }
+
+        /* 发送中被取消只影响请求自身，合并的跟随请求照常拿到结果 */
+        int rc = status == AT_SEND_OK ? AT_SCHED_OK : AT_SCHED_ERROR;
+        count_finish_all(req, rc);
+        pthread_mutex_unlock(&g_sched_mutex);
+
+        /* 在调度线程中按执行顺序更新缓存，写命令使其后的查询看到新状态 */
+        if (sent) {
+            at_cache_update(req->command, status == AT_SEND_OK ? result : NULL);
+        }
+        finish(req, rc, result);
+        g_free(result);
+
+        pthread_mutex_lock(&g_sched_mutex);
+    }
+
+    /* 停止: 排队中的请求全部取消 */
+    GQueue pending = G_QUEUE_INIT;
+    for (int p = 0; p < AT_PRIO_COUNT; p++) {
+        AtRequest *r;
+        while ((r = g_queue_pop_head(&g_queues[p]))) {
+            count_finish_all(r, AT_SCHED_CANCELLED);
+            g_queue_push_tail(&pending, r);
+        }
+    }
+    pthread_mutex_unlock(&g_sched_mutex);
+
+    AtRequest *r;
+    while ((r = g_queue_pop_head(&pending))) {
+        finish(r, AT_SCHED_CANCELLED, NULL);
+    }
+    return NULL;
+}
+
+int at_scheduler_start(AtTransportFunc send) {
+    pthread_condattr_t attr;
+
+    if (!send) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_sched_mutex);
+    if (g_sched_running) {
+        pthread_mutex_unlock(&g_sched_mutex);
+        return 0;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_sched_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    for (int p = 0; p < AT_PRIO_COUNT; p++) {
+        g_queue_init(&g_queues[p]);
+    }
+    g_send = send;
+    g_sched_running = 1;
+    if (pthread_create(&g_sched_thread, NULL, scheduler_thread_func, NULL) != 0) {
+        printf("[AT_SCHED] 启动 AT 调度线程失败\n");
+        g_sched_running = 0;
+        pthread_cond_destroy(&g_sched_cond);
+        pthread_mutex_unlock(&g_sched_mutex);
+        return -1;
+    }
+    pthread_mutex_unlock(&g_sched_mutex);
+
+    printf("[AT_SCHED] AT 调度线程已启动\n");
+    return 0;
+}
+
+void at_scheduler_stop(void) {
+    pthread_mutex_lock(&g_sched_mutex);
+    if (!g_sched_running) {
+        pthread_mutex_unlock(&g_sched_mutex);
+        return;
+    }
+    g_sched_running = 0;
+    pthread_cond_signal(&g_sched_cond);
+    pthread_mutex_unlock(&g_sched_mutex);
+
+    pthread_join(g_sched_thread, NULL);
+    pthread_cond_destroy(&g_sched_cond);
+    printf("[AT_SCHED] AT 调度线程已停止\n");
+}
+
+unsigned int at_scheduler_submit(const char *command, AtPriority prio, int deadline_ms,
+                                 AtDoneFunc done, void *user_data) {
+    if (!command || !done || prio < 0 || prio >= AT_PRIO_COUNT) {
+        return 0;
+    }
+    if (deadline_ms <= 0) {
+        deadline_ms = prio == AT_PRIO_BACKGROUND ? AT_SCHED_DEADLINE_BACKGROUND_MS
+                                                 : AT_SCHED_DEADLINE_MS;
+    }
+
+    AtRequest *req = g_new0(AtRequest, 1);
+    req->command = g_strdup(command);
+    req->prio = prio;
+    req->submit_ms = now_ms();
+    req->deadline_ms = req->submit_ms + deadline_ms;
+    req->not_before_ms = req->submit_ms;
+    req->done = done;
+    req->user_data = user_data;
+    if (prio != AT_PRIO_WRITE && at_cache_is_query(command)) {
+        req->key = at_cache_key(command);
+    }
+
+    pthread_mutex_lock(&g_sched_mutex);
+    if (!g_sched_running) {
+        pthread_mutex_unlock(&g_sched_mutex);
+        request_free(req);
+        return 0;
+    }
+    req->id = g_next_id++;
+    if (g_next_id == 0) g_next_id = 1;
+
+    PrioCounters *pc = &g_counters[prio];
+    pc->submitted++;
+
+    /* 相同的查询正在发送或排队：合并进去，共用一次 modem 往返的结果 */
+    AtRequest *leader = req->key ? find_leader(req->key, prio) : NULL;
+    if (leader) {
+        g_queue_push_tail(&leader->followers, req);
+        pc->coalesced++;
+        unsigned int id = req->id;
+        pthread_cond_signal(&g_sched_cond);
+        pthread_mutex_unlock(&g_sched_mutex);
+        return id;
+    }
+
+    g_queue_push_tail(&g_queues[prio], req);
+    if ((int)g_queues[prio].length > pc->max_depth) {
+        pc->max_depth = g_queues[prio].length;
+    }
+    unsigned int id = req->id;
+    pthread_cond_signal(&g_sched_cond);
+    pthread_mutex_unlock(&g_sched_mutex);
+    return id;
+}
+
+int at_scheduler_cancel(unsigned int id) {
+    AtRequest *found = NULL;
+
+    if (id == 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_sched_mutex);
+    if (g_current && g_current->id == id) {
+        g_current->cancelled = 1;
+        pthread_mutex_unlock(&g_sched_mutex);
+        return 0;
+    }
+    if (g_current) {
+        found = remove_follower(g_current, id);
+    }
+    for (int p = 0; p < AT_PRIO_COUNT && !found; p++) {
+        for (GList *l = g_queues[p].head; l; l = l->next) {
+            AtRequest *req = l->data;
+            if (req->id == id) {
+                g_queue_delete_link(&g_queues[p], l);
+                /* 跟随请求不随之取消，改为独立排队 */
+                if (promote_followers(req, now_ms())) {
+                    pthread_cond_signal(&g_sched_cond);
+                }
+                found = req;
+                break;
+            }
+            if ((found = remove_follower(req, id))) {
+                break;
+            }
+        }
+    }
+    if (found) {
+        count_finish_all(found, AT_SCHED_CANCELLED);
+    }
+    pthread_mutex_unlock(&g_sched_mutex);
+
+    if (!found) {
+        return -1;
+    }
+    finish(found, AT_SCHED_CANCELLED, NULL);
+    return 0;
+}
+
+/* 同步等待 */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int done;
+    int rc;
+    char *result;
+    char *error;
+} SyncWait;
+
+static void sync_done(int rc, const char *result, const char *error, void *user_data) {
+    SyncWait *w = user_data;
+    pthread_mutex_lock(&w->mutex);
+    w->rc = rc;
+    w->result = result ? g_strdup(result) : NULL;
+    w->error = error ? g_strdup(error) : NULL;
+    w->done = 1;
+    pthread_cond_signal(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+}
+
+int at_scheduler_run(const char *command, AtPriority prio, int deadline_ms, char **result, char **error) {
+    SyncWait w;
+
+    *result = NULL;
+    if (error) *error = NULL;
+    memset(&w, 0, sizeof(w));
+    pthread_mutex_init(&w.mutex, NULL);
+    pthread_cond_init(&w.cond, NULL);
+
+    if (at_scheduler_submit(command, prio, deadline_ms, sync_done, &w) == 0) {
+        w.rc = AT_SCHED_ERROR;
+        if (error) *error = g_strdup("AT 调度器未运行");
+    } else {
+        pthread_mutex_lock(&w.mutex);
+        while (!w.done) {
+            pthread_cond_wait(&w.cond, &w.mutex);
+        }
+        pthread_mutex_unlock(&w.mutex);
+        *result = w.result;
+        if (error) {
+            *error = w.error;
+        } else {
+            g_free(w.error);
+        }
+    }
+
+    pthread_cond_destroy(&w.cond);
+    pthread_mutex_destroy(&w.mutex);
+    return w.rc;
+}
+
+void at_scheduler_get_stats(AtSchedulerStats *stats) {
+    memset(stats, 0, sizeof(*stats));
+
+    pthread_mutex_lock(&g_sched_mutex);
+    stats->running = g_sched_running;
+    for (int p = 0; p < AT_PRIO_COUNT; p++) {
+        PrioCounters *pc = &g_counters[p];
+        AtSchedulerPrioStats *ps = &stats->prio[p];
+        ps->depth = (int)g_queues[p].length;
+        ps->max_depth = pc->max_depth;
+        ps->submitted = pc->submitted;
+        ps->completed = pc->completed;
+        ps->failed = pc->failed;
+        ps->expired = pc->expired;
+        ps->cancelled = pc->cancelled;
+        ps->retries = pc->retries;
+        ps->coalesced = pc->coalesced;
+        ps->avg_wait_ms = pc->wait_count ? (double)pc->wait_sum_ms / pc->wait_count : 0;
+        ps->max_wait_ms = pc->wait_max_ms;
+        ps->avg_exec_ms = pc->exec_count ? (double)pc->exec_sum_ms / pc->exec_count : 0;
+    }
+    pthread_mutex_unlock(&g_sched_mutex);
+}
@@ -1,6 +1,12 @@
 /**
  * @file auth.c
  * @brief 后台认证模块实现 - 支持多Token
+ *
+ * 两种Token模式：
+ *   - 随机Token表（默认）：登录生成随机Token，保存在内存表中并异步写回数据库
+ *   - 无状态签名Token：Token自带过期时间和随机数，用HMAC-SHA256签名，
+ *     验证只做签名计算不查任何存储；吊销依靠内存黑名单和配置中的密钥轮换纪元
+ * 模式只决定登录时签发哪种Token，验证时两种都接受，切换模式不会踢掉已登录设备
  */
 
 #include <stdio.h>
@@ -9,44 +15,103 @@
 #include <time.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #include "auth.h"
 #include "sha256.h"
 #include "database.h"
 
-/* 外部函数 - 执行命令 */
-extern int run_command(char *output, size_t output_size, const char *cmd, ...);
-
 /* 配置键名 */
 #define KEY_PASSWORD_HASH   "auth_password_hash"
+#define KEY_TOKEN_MODE      "auth_token_mode"
+#define KEY_SIGN_SECRET     "auth_sign_secret"
+#define KEY_KEY_EPOCH       "auth_key_epoch"
+
+/* 无状态Token格式: s1.<纪元>.<过期时间>.<随机数>.<签名> */
+#define STATELESS_PREFIX        "s1."
+#define STATELESS_NONCE_BYTES   8
+#define STATELESS_NONCE_HEX     (STATELESS_NONCE_BYTES * 2)
+
+/* 黑名单容量，满时轮换密钥纪元使全部无状态Token失效 */
+#define AUTH_DENY_LIST_SIZE     32
+
+/*
+ * 内存Token表 - 验证请求只查内存，不访问数据库
+ * 最多 AUTH_MAX_TOKENS 个槽位，验证时逐个做定长常量时间比较（不提前退出），
+ * 比较耗时与Token内容和所在槽位无关；变更后由后台线程异步写回 auth_tokens 表
+ */
+typedef struct {
+    int used;
+    char token[AUTH_TOKEN_SIZE];
+    long long expire_time;
+    long long created_at;
+} AuthTokenSlot;
+
+static AuthTokenSlot g_tokens[AUTH_MAX_TOKENS];
+static pthread_mutex_t g_auth_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* 异步持久化 */
+static pthread_cond_t g_persist_cond = PTHREAD_COND_INITIALIZER;
+static int g_persist_dirty = 0;
+static int g_persist_started = 0;
+
+/* 无状态Token - 签名密钥由主密钥和纪元派生，纪元递增即吊销全部已签发Token */
+typedef struct {
+    char nonce[STATELESS_NONCE_HEX + 1];
+    long long expire_time;
+} AuthDenyEntry;
+
+static int g_token_mode = AUTH_MODE_TABLE;
+static unsigned int g_key_epoch = 1;
+static uint8_t g_sign_key[SHA256_BLOCK_SIZE];
+static AuthDenyEntry g_deny_list[AUTH_DENY_LIST_SIZE];
 
 /**
- * 生成随机Token
+ * 读取随机字节
  */
-static int generate_token(char *token, size_t size)
+static int read_random(uint8_t *buf, size_t len)
 {
-    if (size < AUTH_TOKEN_SIZE) return -1;
-    
-    uint8_t random_bytes[32];
     int fd = open("/dev/urandom", O_RDONLY);
     if (fd < 0) {
         /* 备用方案：使用时间和进程ID */
         srand((unsigned int)(time(NULL) ^ getpid()));
-        for (int i = 0; i < 32; i++) {
-            random_bytes[i] = (uint8_t)(rand() & 0xFF);
-        }
-    } else {
-        ssize_t n = read(fd, random_bytes, 32);
-        close(fd);
-        if (n != 32) {
-            return -1;
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = (uint8_t)(rand() & 0xFF);
         }
+        return 0;
     }
     
-    /* 转换为hex字符串 */
-    for (int i = 0; i < 32; i++) {
-        sprintf(token + (i * 2), "%02x", random_bytes[i]);
+    ssize_t n = read(fd, buf, len);
+    close(fd);
+    return (n == (ssize_t)len) ? 0 : -1;
+}
+
+/**
+ * 字节数组转hex字符串
+ */
+static void hex_encode(const uint8_t *data, size_t len, char *out)
+{
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < len; i++) {
+        out[i * 2] = hex[data[i] >> 4];
+        out[i * 2 + 1] = hex[data[i] & 0x0f];
+    }
+    out[len * 2] = '\0';
+}
+
+/**
+ * 生成随机Token
+ */
+static int generate_token(char *token, size_t size)
+{
+    if (size < AUTH_TOKEN_SIZE) return -1;
+    
+    uint8_t random_bytes[32];
+    if (read_random(random_bytes, sizeof(random_bytes)) != 0) {
+        return -1;
     }
-    token[64] = '\0';
+    
+    /* 转换为hex字符串 */
+    hex_encode(random_bytes, sizeof(random_bytes), token);
     
     return 0;
 }
@@ -72,37 +137,396 @@ static int verify_password(const char *password)
 }
 
 /**
- * 清理过期Token
+ * 常量时间比较两个定长Token缓冲区
  */
-static int cleanup_expired_tokens(void)
+static int token_equal(const char *a, const char *b)
 {
-    char sql[256];
-    long long now = (long long)time(NULL);
+    unsigned char diff = 0;
+    for (size_t i = 0; i < AUTH_TOKEN_SIZE; i++) {
+        diff |= (unsigned char)(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+/**
+ * 标记Token表已变更，唤醒持久化线程（调用者须持有 g_auth_mutex）
+ */
+static void mark_tokens_dirty(void)
+{
+    g_persist_dirty = 1;
+    pthread_cond_signal(&g_persist_cond);
+}
+
+/**
+ * 清理过期Token（调用者须持有 g_auth_mutex）
+ * @return 清理的数量
+ */
+static int cleanup_expired_tokens(long long now)
+{
+    int removed = 0;
+    for (int i = 0; i < AUTH_MAX_TOKENS; i++) {
+        if (g_tokens[i].used && g_tokens[i].expire_time <= now) {
+            memset(&g_tokens[i], 0, sizeof(AuthTokenSlot));
+            removed++;
+        }
+    }
+    if (removed > 0) {
+        mark_tokens_dirty();
+    }
+    return removed;
+}
+
+/**
+ * 获取空闲槽位，已满时淘汰最早创建的Token（调用者须持有 g_auth_mutex）
+ */
+static AuthTokenSlot *acquire_token_slot(void)
+{
+    AuthTokenSlot *oldest = NULL;
+    for (int i = 0; i < AUTH_MAX_TOKENS; i++) {
+        if (!g_tokens[i].used) {
+            return &g_tokens[i];
+        }
+        if (!oldest || g_tokens[i].created_at < oldest->created_at) {
+            oldest = &g_tokens[i];
+        }
+    }
+    printf("[AUTH] Token数量已达上限(%d)，删除最早的Token\n", AUTH_MAX_TOKENS);
+    memset(oldest, 0, sizeof(AuthTokenSlot));
+    return oldest;
+}
+
+/**
+ * 将Token表写回数据库
+ */
+static int persist_tokens(const AuthTokenSlot *snapshot)
+{
+    if (db_begin() != 0) {
+        return -1;
+    }
+    
+    int ok = db_execute("DELETE FROM auth_tokens;") == 0;
+    for (int i = 0; ok && i < AUTH_MAX_TOKENS; i++) {
+        if (!snapshot[i].used) {
+            continue;
+        }
+        db_stmt *st = db_prepare_cached("auth_insert",
+            "INSERT INTO auth_tokens (token, expire_time, created_at) VALUES (?1, ?2, ?3);");
+        if (!st) {
+            ok = 0;
+            break;
+        }
+        db_bind_text(st, 1, snapshot[i].token);
+        db_bind_int64(st, 2, snapshot[i].expire_time);
+        db_bind_int64(st, 3, snapshot[i].created_at);
+        ok = db_step(st) == DB_DONE;
+        db_finalize(st);
+    }
+    
+    if (!ok) {
+        db_rollback();
+        return -1;
+    }
+    return db_commit();
+}
+
+/**
+ * 持久化线程 - Token表变更后写回数据库，保证重启后登录状态不丢失
+ */
+static void *persist_thread_func(void *arg)
+{
+    AuthTokenSlot snapshot[AUTH_MAX_TOKENS];
+    (void)arg;
+    
+    while (1) {
+        pthread_mutex_lock(&g_auth_mutex);
+        while (!g_persist_dirty) {
+            pthread_cond_wait(&g_persist_cond, &g_auth_mutex);
+        }
+        g_persist_dirty = 0;
+        memcpy(snapshot, g_tokens, sizeof(snapshot));
+        pthread_mutex_unlock(&g_auth_mutex);
+        
+        if (persist_tokens(snapshot) != 0) {
+            printf("[AUTH] Token持久化失败\n");
+        }
+    }
+    return NULL;
+}
+
+/**
+ * 从数据库加载未过期的Token
+ */
+static void load_tokens(void)
+{
+    int count = 0;
+    
+    db_stmt *st = db_prepare(
+        "SELECT token, expire_time, created_at FROM auth_tokens "
+        "WHERE expire_time > ?1 ORDER BY created_at DESC LIMIT ?2;");
+    if (!st) {
+        return;
+    }
+    
+    db_bind_int64(st, 1, (long long)time(NULL));
+    db_bind_int(st, 2, AUTH_MAX_TOKENS);
+    
+    pthread_mutex_lock(&g_auth_mutex);
+    memset(g_tokens, 0, sizeof(g_tokens));
+    while (count < AUTH_MAX_TOKENS && db_step(st) == DB_ROW) {
+        if (db_column_bytes(st, 0) != AUTH_TOKEN_SIZE - 1) {
+            continue;
+        }
+        db_column_copy(st, 0, g_tokens[count].token, sizeof(g_tokens[count].token));
+        g_tokens[count].expire_time = db_column_int64(st, 1);
+        g_tokens[count].created_at = db_column_int64(st, 2);
+        g_tokens[count].used = 1;
+        count++;
+    }
+    pthread_mutex_unlock(&g_auth_mutex);
+    db_finalize(st);
+    
+    printf("[AUTH] 已加载 %d 个有效Token\n", count);
+}
+
+
+/*============================================================================
+ * 无状态签名Token
+ *============================================================================*/
+
+/**
+ * 加载签名密钥和纪元，主密钥不存在时生成
+ */
+static int load_signing_key(void)
+{
+    char secret_hex[SHA256_HEX_SIZE] = {0};
+    char value[32] = {0};
+    char label[32];
+    unsigned int epoch = 1;
+    uint8_t key[SHA256_BLOCK_SIZE];
+    
+    if (config_get(KEY_SIGN_SECRET, secret_hex, sizeof(secret_hex)) != 0 ||
+        strlen(secret_hex) != SHA256_HEX_SIZE - 1) {
+        uint8_t secret[SHA256_BLOCK_SIZE];
+        if (read_random(secret, sizeof(secret)) != 0) {
+            printf("[AUTH] 生成签名主密钥失败\n");
+            return -1;
+        }
+        hex_encode(secret, sizeof(secret), secret_hex);
+        if (config_set(KEY_SIGN_SECRET, secret_hex) != 0) {
+            printf("[AUTH] 保存签名主密钥失败\n");
+            return -1;
+        }
+    }
+    
+    if (config_get(KEY_KEY_EPOCH, value, sizeof(value)) == 0 && strlen(value) > 0) {
+        epoch = (unsigned int)strtoul(value, NULL, 10);
+    }
+    
+    /* 派生密钥 = HMAC(主密钥, "epoch:<纪元>") */
+    int label_len = snprintf(label, sizeof(label), "epoch:%u", epoch);
+    sha256_hmac((const uint8_t *)secret_hex, strlen(secret_hex),
+                (const uint8_t *)label, (size_t)label_len, key);
+    
+    int mode = AUTH_MODE_TABLE;
+    if (config_get(KEY_TOKEN_MODE, value, sizeof(value)) == 0 &&
+        strcmp(value, "stateless") == 0) {
+        mode = AUTH_MODE_STATELESS;
+    }
+    
+    pthread_mutex_lock(&g_auth_mutex);
+    if (epoch != g_key_epoch) {
+        /* 纪元变化后旧Token全部失效，黑名单随之清空 */
+        memset(g_deny_list, 0, sizeof(g_deny_list));
+    }
+    memcpy(g_sign_key, key, sizeof(g_sign_key));
+    g_key_epoch = epoch;
+    g_token_mode = mode;
+    pthread_mutex_unlock(&g_auth_mutex);
+    
+    return 0;
+}
+
+/**
+ * 配置变更回调 - 其他模块或手工修改认证配置后重新加载
+ */
+static void on_auth_config_changed(const char *key, const char *value, void *user_data)
+{
+    (void)value;
+    (void)user_data;
+    
+    if (strcmp(key, KEY_TOKEN_MODE) == 0 || strcmp(key, KEY_SIGN_SECRET) == 0 ||
+        strcmp(key, KEY_KEY_EPOCH) == 0) {
+        load_signing_key();
+    }
+}
+
+/**
+ * 轮换密钥纪元，使全部已签发的无状态Token失效
+ */
+static int rotate_key_epoch(void)
+{
+    char value[32];
+    
+    pthread_mutex_lock(&g_auth_mutex);
+    unsigned int epoch = g_key_epoch + 1;
+    pthread_mutex_unlock(&g_auth_mutex);
+    
+    snprintf(value, sizeof(value), "%u", epoch);
+    if (config_set(KEY_KEY_EPOCH, value) != 0) {
+        return -1;
+    }
+    
+    printf("[AUTH] 签名密钥已轮换，纪元: %u\n", epoch);
+    return load_signing_key();
+}
+
+/**
+ * 计算签名hex
+ */
+static void stateless_sign(const uint8_t *key, const char *payload, size_t len, char *sig_hex)
+{
+    uint8_t mac[SHA256_BLOCK_SIZE];
+    sha256_hmac(key, SHA256_BLOCK_SIZE, (const uint8_t *)payload, len, mac);
+    hex_encode(mac, sizeof(mac), sig_hex);
+}
+
+/**
+ * 签发无状态Token
+ */
+static int stateless_issue(char *token, size_t size, long long now)
+{
+    uint8_t nonce[STATELESS_NONCE_BYTES];
+    char nonce_hex[STATELESS_NONCE_HEX + 1];
+    char sig_hex[SHA256_HEX_SIZE];
+    uint8_t key[SHA256_BLOCK_SIZE];
+    unsigned int epoch;
+    long long expire_time = now + AUTH_TOKEN_EXPIRE_SECONDS;
+    
+    if (size < AUTH_TOKEN_MAX_LEN || read_random(nonce, sizeof(nonce)) != 0) {
+        return -1;
+    }
+    hex_encode(nonce, sizeof(nonce), nonce_hex);
+    
+    pthread_mutex_lock(&g_auth_mutex);
+    memcpy(key, g_sign_key, sizeof(key));
+    epoch = g_key_epoch;
+    pthread_mutex_unlock(&g_auth_mutex);
     
-    snprintf(sql, sizeof(sql),
-        "DELETE FROM auth_tokens WHERE expire_time <= %lld;", now);
+    int len = snprintf(token, size, STATELESS_PREFIX "%u.%lld.%s", epoch, expire_time, nonce_hex);
+    if (len < 0 || (size_t)len + 1 + SHA256_HEX_SIZE > size) {
+        return -1;
+    }
     
-    return db_execute_safe(sql);
+    stateless_sign(key, token, (size_t)len, sig_hex);
+    token[len] = '.';
+    memcpy(token + len + 1, sig_hex, SHA256_HEX_SIZE);
+    
+    return 0;
 }
 
 /**
- * 获取当前Token数量
+ * 验证无状态Token，成功时输出随机数和过期时间
+ * @return 0有效，-1无效、过期或已吊销
  */
-static int get_token_count(void)
+static int stateless_verify(const char *token, char *nonce_out, long long *expire_out)
 {
-    return db_query_int("SELECT COUNT(*) FROM auth_tokens;", 0);
+    char nonce[STATELESS_NONCE_HEX + 1] = {0};
+    char sig_hex[SHA256_HEX_SIZE];
+    uint8_t key[SHA256_BLOCK_SIZE];
+    unsigned int epoch, current_epoch;
+    long long expire_time;
+    int payload_len = 0;
+    
+    const char *sig = strrchr(token, '.');
+    if (!sig || strlen(sig + 1) != SHA256_HEX_SIZE - 1) {
+        return -1;
+    }
+    
+    if (sscanf(token, STATELESS_PREFIX "%u.%lld.%16[0-9a-f]%n",
+               &epoch, &expire_time, nonce, &payload_len) != 3 ||
+        token + payload_len != sig || strlen(nonce) != STATELESS_NONCE_HEX) {
+        return -1;
+    }
+    
+    long long now = (long long)time(NULL);
+    if (expire_time <= now || expire_time > now + AUTH_TOKEN_EXPIRE_SECONDS) {
+        return -1;
+    }
+    
+    pthread_mutex_lock(&g_auth_mutex);
+    memcpy(key, g_sign_key, sizeof(key));
+    current_epoch = g_key_epoch;
+    pthread_mutex_unlock(&g_auth_mutex);
+    
+    if (epoch != current_epoch) {
+        return -1;
+    }
+    
+    /* 签名比较用常量时间 */
+    stateless_sign(key, token, (size_t)payload_len, sig_hex);
+    if (!token_equal(sig_hex, sig + 1)) {
+        return -1;
+    }
+    
+    /* 黑名单 */
+    int denied = 0;
+    pthread_mutex_lock(&g_auth_mutex);
+    for (int i = 0; i < AUTH_DENY_LIST_SIZE; i++) {
+        if (g_deny_list[i].expire_time > now && strcmp(g_deny_list[i].nonce, nonce) == 0) {
+            denied = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_auth_mutex);
+    if (denied) {
+        return -1;
+    }
+    
+    if (nonce_out) {
+        memcpy(nonce_out, nonce, sizeof(nonce));
+    }
+    if (expire_out) {
+        *expire_out = expire_time;
+    }
+    return 0;
 }
 
 /**
- * 删除最早的Token
+ * 吊销单个无状态Token - 加入黑名单直到其自然过期，黑名单满时轮换纪元
  */
-static int delete_oldest_token(void)
+static int stateless_revoke(const char *token)
 {
-    return db_execute_safe(
-        "DELETE FROM auth_tokens WHERE id = "
-        "(SELECT id FROM auth_tokens ORDER BY created_at ASC LIMIT 1);");
+    char nonce[STATELESS_NONCE_HEX + 1];
+    long long expire_time;
+    int added = 0;
+    
+    /* 只接受有效Token，避免黑名单被伪造Token填满 */
+    if (stateless_verify(token, nonce, &expire_time) != 0) {
+        return 0;
+    }
+    
+    long long now = (long long)time(NULL);
+    pthread_mutex_lock(&g_auth_mutex);
+    for (int i = 0; i < AUTH_DENY_LIST_SIZE; i++) {
+        if (g_deny_list[i].expire_time <= now) {
+            memcpy(g_deny_list[i].nonce, nonce, sizeof(nonce));
+            g_deny_list[i].expire_time = expire_time;
+            added = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_auth_mutex);
+    
+    if (!added) {
+        printf("[AUTH] 黑名单已满，轮换签名密钥\n");
+        return rotate_key_epoch();
+    }
+    return 0;
 }
 
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
 
 int auth_init(void)
 {
@@ -121,8 +545,32 @@ int auth_init(void)
         }
     }
     
-    /* 启动时清理过期Token */
-    cleanup_expired_tokens();
+    /* 加载Token到内存（过期Token在下次持久化时从库中移除） */
+    load_tokens();
+    
+    /* 无状态Token签名密钥 */
+    if (load_signing_key() != 0) {
+        return -1;
+    }
+    
+    static int listener_id = 0;
+    if (listener_id <= 0) {
+        listener_id = config_add_listener("auth_", on_auth_config_changed, NULL);
+    }
+    
+    if (!g_persist_started) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, persist_thread_func, NULL) == 0) {
+            pthread_detach(tid);
+            g_persist_started = 1;
+        } else {
+            printf("[AUTH] 启动Token持久化线程失败\n");
+        }
+    }
+    
+    pthread_mutex_lock(&g_auth_mutex);
+    mark_tokens_dirty();
+    pthread_mutex_unlock(&g_auth_mutex);
     
     printf("[AUTH] 认证模块初始化完成\n");
     return 0;
@@ -130,14 +578,16 @@ int auth_init(void)
 
 int auth_login(const char *password, char *token, size_t token_size)
 {
-    char sql[512];
-    long long now, expire_time;
-    int count;
+    long long now;
     
     if (!password || !token || token_size < AUTH_TOKEN_SIZE) {
         return -2;
     }
     
+    pthread_mutex_lock(&g_auth_mutex);
+    int mode = g_token_mode;
+    pthread_mutex_unlock(&g_auth_mutex);
+    
     printf("[AUTH] 尝试登录\n");
     
     /* 验证密码 */
@@ -146,15 +596,16 @@ int auth_login(const char *password, char *token, size_t token_size)
         return -1;
     }
     
-    /* 先清理过期Token */
-    cleanup_expired_tokens();
+    now = (long long)time(NULL);
     
-    /* 检查Token数量，超过限制则删除最早的 */
-    count = get_token_count();
-    while (count >= AUTH_MAX_TOKENS && count > 0) {
-        printf("[AUTH] Token数量已达上限(%d)，删除最早的Token\n", AUTH_MAX_TOKENS);
-        delete_oldest_token();
-        count--;
+    /* 无状态模式：签发签名Token，不保存任何状态 */
+    if (mode == AUTH_MODE_STATELESS) {
+        if (stateless_issue(token, token_size, now) != 0) {
+            printf("[AUTH] 签发Token失败\n");
+            return -2;
+        }
+        printf("[AUTH] 登录成功(无状态Token)，有效期: %d秒\n", AUTH_TOKEN_EXPIRE_SECONDS);
+        return 0;
     }
     
     /* 生成新Token */
@@ -163,52 +614,50 @@ int auth_login(const char *password, char *token, size_t token_size)
         return -2;
     }
     
-    /* 计算过期时间 */
-    now = (long long)time(NULL);
-    expire_time = now + AUTH_TOKEN_EXPIRE_SECONDS;
-    
-    /* 插入新Token */
-    snprintf(sql, sizeof(sql),
-        "INSERT INTO auth_tokens (token, expire_time, created_at) VALUES ('%s', %lld, %lld);",
-        token, expire_time, now);
+    pthread_mutex_lock(&g_auth_mutex);
+    cleanup_expired_tokens(now);
     
-    if (db_execute_safe(sql) != 0) {
-        printf("[AUTH] 保存Token失败\n");
-        return -2;
-    }
+    /* 超过数量限制时淘汰最早的Token */
+    AuthTokenSlot *slot = acquire_token_slot();
+    memcpy(slot->token, token, AUTH_TOKEN_SIZE);
+    slot->expire_time = now + AUTH_TOKEN_EXPIRE_SECONDS;
+    slot->created_at = now;
+    slot->used = 1;
+    mark_tokens_dirty();
+    pthread_mutex_unlock(&g_auth_mutex);
     
-    printf("[AUTH] 登录成功，Token有效期: %d秒，当前Token数: %d\n", 
-           AUTH_TOKEN_EXPIRE_SECONDS, get_token_count());
+    printf("[AUTH] 登录成功，Token有效期: %d秒\n", AUTH_TOKEN_EXPIRE_SECONDS);
     return 0;
 }
 
 
 int auth_verify_token(const char *token)
 {
-    char sql[512];
-    long long now;
-    int count;
+    char input[AUTH_TOKEN_SIZE] = {0};
+    int found = 0;
     
-    if (!token || strlen(token) == 0) {
+    if (!token) {
         return -1;
     }
+    if (strncmp(token, STATELESS_PREFIX, strlen(STATELESS_PREFIX)) == 0) {
+        return stateless_verify(token, NULL, NULL);
+    }
+    if (strlen(token) != AUTH_TOKEN_SIZE - 1) {
+        return -1;
+    }
+    memcpy(input, token, AUTH_TOKEN_SIZE - 1);
     
-    now = (long long)time(NULL);
-    
-    /* 查询Token是否存在且未过期 */
-    snprintf(sql, sizeof(sql),
-        "SELECT COUNT(*) FROM auth_tokens WHERE token='%s' AND expire_time > %lld;",
-        token, now);
-    
-    count = db_query_int(sql, 0);
+    long long now = (long long)time(NULL);
     
-    if (count > 0) {
-        return 0;  /* Token有效 */
+    /* 比较所有槽位，不因匹配而提前退出 */
+    pthread_mutex_lock(&g_auth_mutex);
+    for (int i = 0; i < AUTH_MAX_TOKENS; i++) {
+        found |= g_tokens[i].used & token_equal(g_tokens[i].token, input) &
+                 (g_tokens[i].expire_time > now);
     }
+    pthread_mutex_unlock(&g_auth_mutex);
     
-    /* Token无效或已过期，尝试清理 */
-    cleanup_expired_tokens();
-    return -1;
+    return found ? 0 : -1;
 }
 
 int auth_change_password(const char *old_password, const char *new_password)
@@ -242,7 +691,11 @@ int auth_change_password(const char *old_password, const char *new_password)
     }
     
     /* 清除所有Token，强制所有设备重新登录 */
-    db_execute_safe("DELETE FROM auth_tokens;");
+    pthread_mutex_lock(&g_auth_mutex);
+    memset(g_tokens, 0, sizeof(g_tokens));
+    mark_tokens_dirty();
+    pthread_mutex_unlock(&g_auth_mutex);
+    rotate_key_epoch();
     
     printf("[AUTH] 密码修改成功，所有设备需重新登录\n");
     return 0;
@@ -250,42 +703,43 @@ int auth_change_password(const char *old_password, const char *new_password)
 
 int auth_logout(const char *token)
 {
-    char sql[256];
+    char input[AUTH_TOKEN_SIZE] = {0};
     
     if (!token || strlen(token) == 0) {
         return -1;
     }
     
-    /* 只删除指定Token，不影响其他设备 */
-    snprintf(sql, sizeof(sql),
-        "DELETE FROM auth_tokens WHERE token='%s';", token);
+    if (strncmp(token, STATELESS_PREFIX, strlen(STATELESS_PREFIX)) == 0) {
+        if (stateless_revoke(token) != 0) {
+            return -1;
+        }
+        printf("[AUTH] 登出成功\n");
+        return 0;
+    }
+    strncpy(input, token, AUTH_TOKEN_SIZE - 1);
     
-    if (db_execute_safe(sql) != 0) {
-        return -1;
+    /* 只删除指定Token，不影响其他设备 */
+    pthread_mutex_lock(&g_auth_mutex);
+    for (int i = 0; i < AUTH_MAX_TOKENS; i++) {
+        if (g_tokens[i].used && token_equal(g_tokens[i].token, input)) {
+            memset(&g_tokens[i], 0, sizeof(AuthTokenSlot));
+            mark_tokens_dirty();
+        }
     }
+    pthread_mutex_unlock(&g_auth_mutex);
     
     printf("[AUTH] 登出成功\n");
     return 0;
 }
 
-int auth_get_status(int *logged_in)
+int auth_get_status(const char *token, int *logged_in)
 {
-    int count;
-    
     if (!logged_in) {
         return -1;
     }
     
-    *logged_in = 0;
-    
-    /* 先清理过期Token */
-    cleanup_expired_tokens();
-    
-    /* 检查是否有有效Token */
-    count = get_token_count();
-    if (count > 0) {
-        *logged_in = 1;
-    }
+    /* 只看调用者自己的Token：已登出（黑名单）或过期的Token均视为未登录 */
+    *logged_in = (token && auth_verify_token(token) == 0) ? 1 : 0;
     
     return 0;
 }
@@ -301,3 +755,26 @@ int auth_is_required(void)
     
     return 0;
 }
+
+int auth_get_token_mode(void)
+{
+    pthread_mutex_lock(&g_auth_mutex);
+    int mode = g_token_mode;
+    pthread_mutex_unlock(&g_auth_mutex);
+    return mode;
+}
+
+int auth_set_token_mode(int mode)
+{
+    if (mode != AUTH_MODE_TABLE && mode != AUTH_MODE_STATELESS) {
+        return -1;
+    }
+    
+    /* 写入配置后由监听回调重新加载 */
+    if (config_set(KEY_TOKEN_MODE, mode == AUTH_MODE_STATELESS ? "stateless" : "table") != 0) {
+        return -1;
+    }
+    
+    printf("[AUTH] Token模式: %s\n", mode == AUTH_MODE_STATELESS ? "stateless" : "table");
+    return load_signing_key();
+}
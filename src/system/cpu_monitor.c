@@ -0,0 +1,288 @@
+/**
+ * @file cpu_monitor.c
+ * @brief CPU 使用率监控实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <glib.h>
+#include "cpu_monitor.h"
+#include "sampler.h"
+
+/* 单次采样 */
+typedef struct {
+    double total;
+    int core_count;
+    double cores[CPU_MONITOR_MAX_CORES];
+    int proc_count;
+    struct {
+        int pid;
+        char name[16];
+        double usage;
+    } procs[CPU_MONITOR_TOP_N];
+} CpuSample;
+
+/* 进程上一次的累计时间 */
+typedef struct {
+    unsigned long long jiffies;
+    unsigned long long starttime;
+    unsigned int generation;
+} ProcPrev;
+
+static pthread_mutex_t g_cpu_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CpuSample g_ring[CPU_MONITOR_HISTORY];  /* 受 g_cpu_mutex 保护 */
+static int g_ring_head = 0;                     /* 下一个写入位置 */
+static int g_ring_count = 0;
+
+/* 以下只在主循环中访问 */
+static guint g_timer_id = 0;
+static int g_have_prev = 0;
+static SamplerCpuTimes g_prev_total;
+static SamplerCpuTimes g_prev_cores[CPU_MONITOR_MAX_CORES];
+static int g_prev_core_count = 0;
+static GHashTable *g_prev_procs = NULL;         /* pid -> ProcPrev */
+static unsigned int g_generation = 0;
+
+/*============================================================================
+ * 计算
+ *============================================================================*/
+
+static unsigned long long cpu_busy(const SamplerCpuTimes *t) {
+    return t->user + t->nice + t->system + t->irq + t->softirq + t->steal;
+}
+
+static unsigned long long cpu_all(const SamplerCpuTimes *t) {
+    return cpu_busy(t) + t->idle + t->iowait;
+}
+
+/* 两次采样之间的使用率 (%) */
+static double cpu_percent(const SamplerCpuTimes *prev, const SamplerCpuTimes *cur) {
+    unsigned long long all_prev = cpu_all(prev), all_cur = cpu_all(cur);
+    unsigned long long busy_prev = cpu_busy(prev), busy_cur = cpu_busy(cur);
+    if (all_cur <= all_prev || busy_cur < busy_prev) return 0;
+    return (double)(busy_cur - busy_prev) * 100.0 / (double)(all_cur - all_prev);
+}
+
+/* 把进程插入按使用率降序的前 N 名 */
+static void insert_top(CpuSample *s, int pid, const char *name, double usage) {
+    int pos = s->proc_count;
+    if (pos == CPU_MONITOR_TOP_N) {
+        if (usage <= s->procs[pos - 1].usage) return;
+        pos--;
+    } else {
+        s->proc_count++;
+    }
+    while (pos > 0 && s->procs[pos - 1].usage < usage) {
+        s->procs[pos] = s->procs[pos - 1];
+        pos--;
+    }
+    s->procs[pos].pid = pid;
+    snprintf(s->procs[pos].name, sizeof(s->procs[pos].name), "%s", name);
+    s->procs[pos].usage = usage;
+}
+
+static gboolean remove_stale_proc(gpointer key, gpointer value, gpointer user_data) {
+    (void)key;
+    (void)user_data;
+    return ((ProcPrev *)value)->generation != g_generation;
+}
+
+/**
+ * 采样所有进程，delta_all 为本周期所有核的总 jiffies
+ */
+static void sample_procs(CpuSample *sample, unsigned long long delta_all) {
+    static int pids[CPU_MONITOR_MAX_PROCS];
+    int count = sampler_list_pids(pids, CPU_MONITOR_MAX_PROCS);
+    if (count < 0) return;
+
+    g_generation++;
+    for (int i = 0; i < count; i++) {
+        SamplerProcStat st;
+        if (sampler_read_proc_stat(pids[i], &st) != 0) continue;  /* 已退出 */
+
+        unsigned long long jiffies = st.utime + st.stime;
+        ProcPrev *prev = g_hash_table_lookup(g_prev_procs, GINT_TO_POINTER(st.pid));
+        if (!prev) {
+            prev = g_new0(ProcPrev, 1);
+            g_hash_table_insert(g_prev_procs, GINT_TO_POINTER(st.pid), prev);
+        } else if (prev->starttime == st.starttime && jiffies >= prev->jiffies && delta_all > 0) {
+            double usage = (double)(jiffies - prev->jiffies) * 100.0 / (double)delta_all;
+            if (usage > 0) insert_top(sample, st.pid, st.comm, usage);
+        }
+        prev->jiffies = jiffies;
+        prev->starttime = st.starttime;
+        prev->generation = g_generation;
+    }
+
+    /* 清理已退出的进程 */
+    g_hash_table_foreach_remove(g_prev_procs, remove_stale_proc, NULL);
+}
+
+static gboolean sample_tick(gpointer user_data) {
+    (void)user_data;
+    SamplerCpuTimes total, cores[CPU_MONITOR_MAX_CORES];
+
+    int core_count = sampler_read_cpu_cores(&total, cores, CPU_MONITOR_MAX_CORES);
+    if (core_count < 0) return G_SOURCE_CONTINUE;
+
+    if (g_have_prev) {
+        CpuSample sample;
+        memset(&sample, 0, sizeof(sample));
+        sample.total = cpu_percent(&g_prev_total, &total);
+
+        /* 核数变化（热插拔）时只统计两次都存在的核 */
+        sample.core_count = core_count < g_prev_core_count ? core_count : g_prev_core_count;
+        for (int i = 0; i < sample.core_count; i++) {
+            sample.cores[i] = cpu_percent(&g_prev_cores[i], &cores[i]);
+        }
+
+        unsigned long long all_prev = cpu_all(&g_prev_total), all_cur = cpu_all(&total);
+        sample_procs(&sample, all_cur > all_prev ? all_cur - all_prev : 0);
+
+        pthread_mutex_lock(&g_cpu_mutex);
+        g_ring[g_ring_head] = sample;
+        g_ring_head = (g_ring_head + 1) % CPU_MONITOR_HISTORY;
+        if (g_ring_count < CPU_MONITOR_HISTORY) g_ring_count++;
+        pthread_mutex_unlock(&g_cpu_mutex);
+    } else {
+        /* 第一次只建立基线 */
+        CpuSample dummy;
+        memset(&dummy, 0, sizeof(dummy));
+        sample_procs(&dummy, 0);
+    }
+
+    g_prev_total = total;
+    memcpy(g_prev_cores, cores, sizeof(SamplerCpuTimes) * (size_t)core_count);
+    g_prev_core_count = core_count;
+    g_have_prev = 1;
+    return G_SOURCE_CONTINUE;
+}
+
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
+
+int cpu_monitor_start(void) {
+    if (g_timer_id) return 0;
+
+    g_prev_procs = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    g_have_prev = 0;
+    sample_tick(NULL);  /* 立即建立基线，一个间隔后即有数据 */
+
+    g_timer_id = g_timeout_add(CPU_MONITOR_INTERVAL_MS, sample_tick, NULL);
+    if (!g_timer_id) {
+        g_hash_table_destroy(g_prev_procs);
+        g_prev_procs = NULL;
+        return -1;
+    }
+    printf("[CPU] CPU 使用率监控已启动，间隔 %d ms\n", CPU_MONITOR_INTERVAL_MS);
+    return 0;
+}
+
+void cpu_monitor_stop(void) {
+    if (!g_timer_id) return;
+
+    g_source_remove(g_timer_id);
+    g_timer_id = 0;
+    g_hash_table_destroy(g_prev_procs);
+    g_prev_procs = NULL;
+    g_have_prev = 0;
+
+    pthread_mutex_lock(&g_cpu_mutex);
+    g_ring_head = 0;
+    g_ring_count = 0;
+    pthread_mutex_unlock(&g_cpu_mutex);
+    printf("[CPU] CPU 使用率监控已停止\n");
+}
+
+int cpu_monitor_get_stats(int window_sec, CpuMonitorStats *stats) {
+    int window = window_sec > 0 ? (window_sec * 1000 + CPU_MONITOR_INTERVAL_MS - 1) / CPU_MONITOR_INTERVAL_MS : 1;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->interval_ms = CPU_MONITOR_INTERVAL_MS;
+
+    pthread_mutex_lock(&g_cpu_mutex);
+    if (g_ring_count == 0) {
+        pthread_mutex_unlock(&g_cpu_mutex);
+        return -1;
+    }
+    if (window > g_ring_count) window = g_ring_count;
+
+    const CpuSample *latest = &g_ring[(g_ring_head + CPU_MONITOR_HISTORY - 1) % CPU_MONITOR_HISTORY];
+    stats->samples = window;
+    stats->total_now = latest->total;
+    stats->core_count = latest->core_count;
+    for (int c = 0; c < latest->core_count; c++) {
+        stats->core_now[c] = latest->cores[c];
+    }
+
+    /* 窗口内的进程按 pid 累加（未进入某次前 N 名的样本记为0） */
+    struct {
+        int pid;
+        char name[16];
+        double sum;
+        double now;
+    } acc[CPU_MONITOR_HISTORY * CPU_MONITOR_TOP_N];
+    int acc_count = 0;
+
+    for (int k = 0; k < window; k++) {
+        const CpuSample *s = &g_ring[(g_ring_head + CPU_MONITOR_HISTORY - 1 - k) % CPU_MONITOR_HISTORY];
+        stats->total_avg += s->total;
+        for (int c = 0; c < stats->core_count && c < s->core_count; c++) {
+            stats->core_avg[c] += s->cores[c];
+        }
+        for (int p = 0; p < s->proc_count; p++) {
+            int i = 0;
+            while (i < acc_count && acc[i].pid != s->procs[p].pid) i++;
+            if (i == acc_count) {
+                acc[i].pid = s->procs[p].pid;
+                memcpy(acc[i].name, s->procs[p].name, sizeof(acc[i].name));
+                acc[i].sum = 0;
+                acc[i].now = 0;
+                acc_count++;
+            }
+            acc[i].sum += s->procs[p].usage;
+            if (k == 0) acc[i].now = s->procs[p].usage;
+        }
+    }
+    pthread_mutex_unlock(&g_cpu_mutex);
+
+    stats->total_avg /= window;
+    for (int c = 0; c < stats->core_count; c++) {
+        stats->core_avg[c] /= window;
+    }
+
+    /* 按窗口平均取前 N 名 */
+    for (int i = 0; i < acc_count; i++) {
+        double avg = acc[i].sum / window;
+        int pos = stats->proc_count;
+        if (pos == CPU_MONITOR_TOP_N) {
+            if (avg <= stats->procs[pos - 1].avg) continue;
+            pos--;
+        } else {
+            stats->proc_count++;
+        }
+        while (pos > 0 && stats->procs[pos - 1].avg < avg) {
+            stats->procs[pos] = stats->procs[pos - 1];
+            pos--;
+        }
+        stats->procs[pos].pid = acc[i].pid;
+        memcpy(stats->procs[pos].name, acc[i].name, sizeof(stats->procs[pos].name));
+        stats->procs[pos].now = acc[i].now;
+        stats->procs[pos].avg = avg;
+    }
+    return 0;
+}
+
+double cpu_monitor_total_now(void) {
+    double total = -1;
+
+    pthread_mutex_lock(&g_cpu_mutex);
+    if (g_ring_count > 0) {
+        total = g_ring[(g_ring_head + CPU_MONITOR_HISTORY - 1) % CPU_MONITOR_HISTORY].total;
+    }
+    pthread_mutex_unlock(&g_cpu_mutex);
+    return total;
+}
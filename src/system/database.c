@@ -1,33 +1,436 @@
 /**
  * @file database.c
- * @brief 数据库操作模块实现 - SQLite3 统一接口
+ * @brief 数据库操作模块实现 - SQLite3 统一接口（进程内连接）
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
-#include <unistd.h>
+#include <dlfcn.h>
+#include <glib.h>
 #include "database.h"
-#include "exec_utils.h"
+
+/*============================================================================
+ * SQLite 运行时绑定
+ *
+ * 通过 dlopen 加载系统自带的 libsqlite3（即 sqlite3 命令行工具所用的库），
+ * 在进程内保持一个持久连接，交叉编译时无需额外的头文件和链接库。
+ *============================================================================*/
+
+typedef struct sqlite3 sqlite3;
+typedef struct sqlite3_stmt sqlite3_stmt;
+
+#define SQLITE_OK               0
+#define SQLITE_ROW              100
+#define SQLITE_DONE             101
+#define SQLITE_NULL             5
+#define SQLITE_OPEN_READWRITE   0x00000002
+#define SQLITE_OPEN_CREATE      0x00000004
+#define SQLITE_OPEN_FULLMUTEX   0x00010000
+#define SQLITE_TRANSIENT        ((void (*)(void *))-1)
+
+/* 其他进程（插件脚本、sqlite3 CLI）占用数据库时的等待时间 */
+#define DB_BUSY_TIMEOUT_MS      3000
+
+static struct {
+    void *lib;
+    int (*open_v2)(const char *, sqlite3 **, int, const char *);
+    int (*close)(sqlite3 *);
+    int (*exec)(sqlite3 *, const char *, int (*)(void *, int, char **, char **), void *, char **);
+    void (*free)(void *);
+    const char *(*errmsg)(sqlite3 *);
+    int (*busy_timeout)(sqlite3 *, int);
+    int (*prepare_v2)(sqlite3 *, const char *, int, sqlite3_stmt **, const char **);
+    int (*step)(sqlite3_stmt *);
+    int (*finalize)(sqlite3_stmt *);
+    int (*reset)(sqlite3_stmt *);
+    int (*clear_bindings)(sqlite3_stmt *);
+    int (*bind_int)(sqlite3_stmt *, int, int);
+    int (*bind_int64)(sqlite3_stmt *, int, long long);
+    int (*bind_text)(sqlite3_stmt *, int, const char *, int, void (*)(void *));
+    int (*bind_blob)(sqlite3_stmt *, int, const void *, int, void (*)(void *));
+    int (*bind_null)(sqlite3_stmt *, int);
+    int (*column_count)(sqlite3_stmt *);
+    int (*column_type)(sqlite3_stmt *, int);
+    int (*column_int)(sqlite3_stmt *, int);
+    long long (*column_int64)(sqlite3_stmt *, int);
+    const unsigned char *(*column_text)(sqlite3_stmt *, int);
+    const void *(*column_blob)(sqlite3_stmt *, int);
+    int (*column_bytes)(sqlite3_stmt *, int);
+    int (*changes)(sqlite3 *);
+    long long (*last_insert_rowid)(sqlite3 *);
+} g_sql;
+
+static const struct {
+    const char *name;
+    void **ptr;
+} g_sql_symbols[] = {
+    { "sqlite3_open_v2",      (void **)&g_sql.open_v2 },
+    { "sqlite3_close",        (void **)&g_sql.close },
+    { "sqlite3_exec",         (void **)&g_sql.exec },
+    { "sqlite3_free",         (void **)&g_sql.free },
+    { "sqlite3_errmsg",       (void **)&g_sql.errmsg },
+    { "sqlite3_busy_timeout", (void **)&g_sql.busy_timeout },
+    { "sqlite3_prepare_v2",   (void **)&g_sql.prepare_v2 },
+    { "sqlite3_step",         (void **)&g_sql.step },
+    { "sqlite3_finalize",     (void **)&g_sql.finalize },
+    { "sqlite3_reset",        (void **)&g_sql.reset },
+    { "sqlite3_clear_bindings", (void **)&g_sql.clear_bindings },
+    { "sqlite3_bind_int",     (void **)&g_sql.bind_int },
+    { "sqlite3_bind_int64",   (void **)&g_sql.bind_int64 },
+    { "sqlite3_bind_text",    (void **)&g_sql.bind_text },
+    { "sqlite3_bind_blob",    (void **)&g_sql.bind_blob },
+    { "sqlite3_bind_null",    (void **)&g_sql.bind_null },
+    { "sqlite3_column_count", (void **)&g_sql.column_count },
+    { "sqlite3_column_type",  (void **)&g_sql.column_type },
+    { "sqlite3_column_int",   (void **)&g_sql.column_int },
+    { "sqlite3_column_int64", (void **)&g_sql.column_int64 },
+    { "sqlite3_column_text",  (void **)&g_sql.column_text },
+    { "sqlite3_column_blob",  (void **)&g_sql.column_blob },
+    { "sqlite3_column_bytes", (void **)&g_sql.column_bytes },
+    { "sqlite3_changes",      (void **)&g_sql.changes },
+    { "sqlite3_last_insert_rowid", (void **)&g_sql.last_insert_rowid },
+};
+
+/* 预编译语句 */
+struct db_stmt {
+    sqlite3_stmt *stmt;
+    const char *key;        /* 缓存键，NULL表示非缓存语句 */
+    int in_use;
+};
+
+/* 语句缓存容量（热点查询数量有限，线性查找即可） */
+#define DB_STMT_CACHE_SIZE      32
 
 /*============================================================================
  * 全局变量
  *============================================================================*/
 
 static char g_db_path[256] = "6677.db";
-static pthread_mutex_t g_db_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t g_db_mutex;
+static pthread_once_t g_db_mutex_once = PTHREAD_ONCE_INIT;
 static int g_db_initialized = 0;
+static sqlite3 *g_db = NULL;
+static db_stmt g_stmt_cache[DB_STMT_CACHE_SIZE];
+
+/* 配置缓存（key -> value），首次读取时整表加载，config_set 时同步更新 */
+static GHashTable *g_config_cache = NULL;
+
+/* 配置变更监听 */
+#define CONFIG_MAX_LISTENERS    16
+static struct {
+    int id;
+    char prefix[64];
+    config_change_cb cb;
+    void *user_data;
+} g_config_listeners[CONFIG_MAX_LISTENERS];
+static int g_config_listener_next_id = 1;
 
 /*============================================================================
  * 内部函数
  *============================================================================*/
 
 /**
- * 创建数据库表结构
+ * 初始化数据库锁 - 使用递归锁，持有语句期间仍可调用其他数据库接口
+ */
+static void db_mutex_init(void) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&g_db_mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+}
+
+static void db_lock(void) {
+    pthread_once(&g_db_mutex_once, db_mutex_init);
+    pthread_mutex_lock(&g_db_mutex);
+}
+
+static void db_unlock(void) {
+    pthread_mutex_unlock(&g_db_mutex);
+}
+
+/**
+ * 加载 libsqlite3 并解析所需符号
+ */
+static int sql_load_library(void) {
+    static const char *lib_names[] = {
+        "libsqlite3.so.0", "libsqlite3.so", "/usr/lib/libsqlite3.so.0", NULL
+    };
+    
+    if (g_sql.lib) {
+        return 0;
+    }
+    
+    void *lib = NULL;
+    for (int i = 0; lib_names[i] && !lib; i++) {
+        lib = dlopen(lib_names[i], RTLD_NOW | RTLD_LOCAL);
+    }
+    if (!lib) {
+        printf("[DB] 加载libsqlite3失败: %s\n", dlerror());
+        return -1;
+    }
+    
+    for (size_t i = 0; i < sizeof(g_sql_symbols) / sizeof(g_sql_symbols[0]); i++) {
+        *g_sql_symbols[i].ptr = dlsym(lib, g_sql_symbols[i].name);
+        if (!*g_sql_symbols[i].ptr) {
+            printf("[DB] libsqlite3缺少符号: %s\n", g_sql_symbols[i].name);
+            dlclose(lib);
+            return -1;
+        }
+    }
+    
+    g_sql.lib = lib;
+    return 0;
+}
+
+/**
+ * 确保数据库连接已打开（调用者须持有数据库锁）
+ * 部分模块（流量、充电）在 db_init 之前读取配置，因此按需打开默认路径
+ */
+static int db_open_locked(void) {
+    if (g_db) {
+        return 0;
+    }
+    
+    if (sql_load_library() != 0) {
+        return -1;
+    }
+    
+    int flags = SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_FULLMUTEX;
+    if (g_sql.open_v2(g_db_path, &g_db, flags, NULL) != SQLITE_OK) {
+        printf("[DB] 打开数据库失败: %s\n", g_db ? g_sql.errmsg(g_db) : "内存不足");
+        if (g_db) {
+            g_sql.close(g_db);
+            g_db = NULL;
+        }
+        return -1;
+    }
+    
+    g_sql.busy_timeout(g_db, DB_BUSY_TIMEOUT_MS);
+    return 0;
+}
+
+/**
+ * 关闭数据库连接（调用者须持有数据库锁）
+ */
+static void db_close_locked(void) {
+    if (g_config_cache) {
+        g_hash_table_destroy(g_config_cache);
+        g_config_cache = NULL;
+    }
+    for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+        if (g_stmt_cache[i].stmt) {
+            g_sql.finalize(g_stmt_cache[i].stmt);
+        }
+        memset(&g_stmt_cache[i], 0, sizeof(db_stmt));
+    }
+    if (g_db) {
+        g_sql.close(g_db);
+        g_db = NULL;
+    }
+}
+
+/**
+ * 执行SQL（可包含多条语句，调用者须持有 g_db_mutex）
+ */
+static int db_exec_locked(const char *sql) {
+    char *errmsg = NULL;
+    
+    if (db_open_locked() != 0) {
+        return -1;
+    }
+    
+    if (g_sql.exec(g_db, sql, NULL, NULL, &errmsg) != SQLITE_OK) {
+        printf("[DB] SQL执行失败: %s, SQL: %.200s...\n", errmsg ? errmsg : "未知错误", sql);
+        if (errmsg) g_sql.free(errmsg);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 查询并按 sqlite3 CLI 的格式输出文本：列间用 separator 分隔，行间用换行分隔，
+ * NULL 输出为空串，超出缓冲区的部分截断（调用者须持有数据库锁）
+ */
+static int db_query_text_locked(const char *sql, const char *separator, char *buf, size_t size) {
+    const char *tail = sql;
+    size_t len = 0;
+    size_t sep_len = strlen(separator);
+    int rows = 0;
+    
+    buf[0] = '\0';
+    
+    if (db_open_locked() != 0) {
+        return -1;
+    }
+    
+    while (tail && *tail) {
+        sqlite3_stmt *stmt = NULL;
+        if (g_sql.prepare_v2(g_db, tail, -1, &stmt, &tail) != SQLITE_OK) {
+            printf("[DB] SQL查询失败: %s, SQL: %.200s...\n", g_sql.errmsg(g_db), sql);
+            return -1;
+        }
+        if (!stmt) {
+            break;  /* 仅剩空白或注释 */
+        }
+        
+        int rc;
+        int ncol = g_sql.column_count(stmt);
+        while ((rc = g_sql.step(stmt)) == SQLITE_ROW) {
+            if (rows++ > 0 && len < size - 1) {
+                buf[len++] = '\n';
+            }
+            for (int i = 0; i < ncol; i++) {
+                if (i > 0) {
+                    size_t n = sep_len < size - 1 - len ? sep_len : size - 1 - len;
+                    memcpy(buf + len, separator, n);
+                    len += n;
+                }
+                const char *text = (const char *)g_sql.column_text(stmt, i);
+                if (text) {
+                    size_t tlen = strlen(text);
+                    size_t n = tlen < size - 1 - len ? tlen : size - 1 - len;
+                    memcpy(buf + len, text, n);
+                    len += n;
+                }
+            }
+        }
+        g_sql.finalize(stmt);
+        
+        if (rc != SQLITE_DONE) {
+            printf("[DB] SQL查询失败: %s, SQL: %.200s...\n", g_sql.errmsg(g_db), sql);
+            buf[len] = '\0';
+            return -1;
+        }
+    }
+    
+    buf[len] = '\0';
+    return 0;
+}
+
+/*============================================================================
+ * 数据库结构迁移
+ *
+ * 每个迁移有一个递增的版本号，已执行到的版本记录在 schema_version 表中。
+ * 启动时只查一次版本号，有未执行的迁移时在同一个事务中按顺序执行。
+ * 新增表、字段或索引时在 g_migrations 末尾追加一项，不要修改已发布的迁移。
+ *============================================================================*/
+
+typedef struct {
+    int version;
+    const char *desc;
+    const char *sql;            /* 迁移SQL，可包含多条语句 */
+    int (*apply)(void);         /* 需要判断旧库状态的迁移，sql 为 NULL 时使用 */
+} DbMigration;
+
+/**
+ * 检查字段是否存在（调用者须持有数据库锁）
+ */
+static int db_column_exists_locked(const char *table, const char *column) {
+    char sql[128];
+    sqlite3_stmt *stmt = NULL;
+    
+    snprintf(sql, sizeof(sql), "SELECT %s FROM %s LIMIT 0;", column, table);
+    if (g_sql.prepare_v2(g_db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        return 0;
+    }
+    g_sql.finalize(stmt);
+    return 1;
+}
+
+/**
+ * v2: 早期版本的 sms_config 没有 sms_fix_enabled 字段
+ */
+static int migrate_sms_fix_column(void) {
+    if (db_column_exists_locked("sms_config", "sms_fix_enabled")) {
+        return 0;
+    }
+    return db_exec_locked("ALTER TABLE sms_config ADD COLUMN sms_fix_enabled INTEGER DEFAULT 0;");
+}
+
+/**
+ * v6: 短信全文索引
+ * 按 trigram(fts5) > fts5 > fts4 的顺序尝试，系统 libsqlite3 都不支持时跳过，
+ * 搜索接口退化为 LIKE 扫描，之后每次启动由 db_ensure_sms_fts_locked 重试。索引表的 rowid 与原表 id 一致，由触发器同步
  */
-static int db_create_tables(void) {
-    const char *sql = 
+static int migrate_sms_fts(void) {
+    static const char *engines[] = {
+        "fts5(content, peer, tokenize='trigram')",
+        "fts5(content, peer)",
+        "fts4(content, peer)",
+    };
+    char sql[256];
+    
+    for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+        snprintf(sql, sizeof(sql),
+            "CREATE VIRTUAL TABLE IF NOT EXISTS sms_fts USING %s;"
+            "CREATE VIRTUAL TABLE IF NOT EXISTS sent_sms_fts USING %s;",
+            engines[i], engines[i]);
+        if (g_sql.exec(g_db, sql, NULL, NULL, NULL) != SQLITE_OK) {
+            /* 可能只建成了第一张表 */
+            g_sql.exec(g_db, "DROP TABLE IF EXISTS sms_fts;", NULL, NULL, NULL);
+            continue;
+        }
+        
+        printf("[DB] 短信全文索引: %s\n", engines[i]);
+        return db_exec_locked(
+            "CREATE TRIGGER IF NOT EXISTS trg_sms_fts_insert AFTER INSERT ON sms BEGIN "
+            "INSERT INTO sms_fts (rowid, content, peer) VALUES (NEW.id, NEW.content, NEW.sender); "
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS trg_sms_fts_delete AFTER DELETE ON sms BEGIN "
+            "DELETE FROM sms_fts WHERE rowid = OLD.id; "
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS trg_sent_sms_fts_insert AFTER INSERT ON sent_sms BEGIN "
+            "INSERT INTO sent_sms_fts (rowid, content, peer) VALUES (NEW.id, NEW.content, NEW.recipient); "
+            "END;"
+            "CREATE TRIGGER IF NOT EXISTS trg_sent_sms_fts_delete AFTER DELETE ON sent_sms BEGIN "
+            "DELETE FROM sent_sms_fts WHERE rowid = OLD.id; "
+            "END;"
+            "INSERT INTO sms_fts (rowid, content, peer) SELECT id, content, sender FROM sms;"
+            "INSERT INTO sent_sms_fts (rowid, content, peer) SELECT id, content, recipient FROM sent_sms;");
+    }
+    
+    printf("[DB] libsqlite3 不支持全文索引，短信搜索使用全表扫描\n");
+    return 0;
+}
+
+/**
+ * 检查表是否存在（调用者须持有数据库锁）
+ */
+static int db_table_exists_locked(const char *table) {
+    sqlite3_stmt *stmt = NULL;
+    int exists = 0;
+    
+    if (g_sql.prepare_v2(g_db, "SELECT 1 FROM sqlite_master WHERE name = ?1;", -1, &stmt, NULL) != SQLITE_OK) {
+        return 0;
+    }
+    g_sql.bind_text(stmt, 1, table, -1, SQLITE_TRANSIENT);
+    exists = g_sql.step(stmt) == SQLITE_ROW;
+    g_sql.finalize(stmt);
+    return exists;
+}
+
+/**
+ * v6 在 libsqlite3 不支持全文索引时跳过建表但仍记录为已完成；
+ * 之后换成支持全文索引的 libsqlite3 时在启动时补建（调用者须持有数据库锁）
+ */
+static void db_ensure_sms_fts_locked(void) {
+    if (db_table_exists_locked("sms_fts")) {
+        return;
+    }
+    if (db_exec_locked("BEGIN IMMEDIATE;") != 0) {
+        return;
+    }
+    if (migrate_sms_fts() != 0 || db_exec_locked("COMMIT;") != 0) {
+        printf("[DB] 补建短信全文索引失败\n");
+        db_exec_locked("ROLLBACK;");
+    }
+}
+
+static const DbMigration g_migrations[] = {
+    { 1, "基础表结构",
         "CREATE TABLE IF NOT EXISTS sms ("
         "id INTEGER PRIMARY KEY AUTOINCREMENT,"
         "sender TEXT NOT NULL,"
@@ -65,9 +468,124 @@ static int db_create_tables(void) {
         "token TEXT UNIQUE NOT NULL,"
         "expire_time INTEGER NOT NULL,"
         "created_at INTEGER NOT NULL"
-        ");";
+        ");",
+        NULL },
+    { 2, "sms_config.sms_fix_enabled", NULL, migrate_sms_fix_column },
+    { 3, "APN表结构",
+        "CREATE TABLE IF NOT EXISTS apn_templates ("
+        "id INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "name TEXT NOT NULL,"
+        "apn TEXT NOT NULL,"
+        "protocol TEXT DEFAULT 'dual',"
+        "username TEXT,"
+        "password TEXT,"
+        "auth_method TEXT DEFAULT 'chap',"
+        "created_at INTEGER NOT NULL"
+        ");"
+        "CREATE TABLE IF NOT EXISTS apn_config ("
+        "id INTEGER PRIMARY KEY DEFAULT 1,"
+        "mode INTEGER DEFAULT 0,"
+        "template_id INTEGER,"
+        "auto_start INTEGER DEFAULT 0"
+        ");",
+        NULL },
+    { 4, "热点查询索引",
+        /* 短信按 id 排序走主键，按时间排序和清理需要 timestamp 索引 */
+        "CREATE INDEX IF NOT EXISTS idx_sms_timestamp ON sms(timestamp);"
+        "CREATE INDEX IF NOT EXISTS idx_sent_sms_timestamp ON sent_sms(timestamp);"
+        "CREATE INDEX IF NOT EXISTS idx_auth_tokens_token_expire ON auth_tokens(token, expire_time);",
+        NULL },
+    { 5, "短信保留数量触发器",
+        /*
+         * 插入后只删除第 max_count 新那条及更早的记录：边界 id 沿主键倒序取
+         * max_count+1 行，删除走主键范围，开销与表大小无关。
+         * 上限取 sms_config，未配置时与 sms.c 的默认值一致（收件箱50，发件箱10）
+         */
+        "CREATE TRIGGER IF NOT EXISTS trg_sms_retention AFTER INSERT ON sms BEGIN "
+        "DELETE FROM sms WHERE id <= (SELECT id FROM sms ORDER BY id DESC LIMIT 1 OFFSET "
+        "COALESCE((SELECT max_count FROM sms_config WHERE id = 1 AND max_count > 0), 50)); "
+        "END;"
+        "CREATE TRIGGER IF NOT EXISTS trg_sent_sms_retention AFTER INSERT ON sent_sms BEGIN "
+        "DELETE FROM sent_sms WHERE id <= (SELECT id FROM sent_sms ORDER BY id DESC LIMIT 1 OFFSET "
+        "COALESCE((SELECT max_sent_count FROM sms_config WHERE id = 1 AND max_sent_count > 0), 10)); "
+        "END;",
+        NULL },
+    { 6, "短信全文索引", NULL, migrate_sms_fts },
+};
+
+#define DB_SCHEMA_VERSION ((int)(sizeof(g_migrations) / sizeof(g_migrations[0])))
+
+/**
+ * 读取当前结构版本，没有 schema_version 表时为0（调用者须持有数据库锁）
+ */
+static int db_schema_version_locked(void) {
+    sqlite3_stmt *stmt = NULL;
+    int version = 0;
     
-    return db_execute(sql);
+    if (g_sql.prepare_v2(g_db, "SELECT MAX(version) FROM schema_version;", -1, &stmt, NULL) != SQLITE_OK) {
+        return 0;
+    }
+    if (g_sql.step(stmt) == SQLITE_ROW) {
+        version = g_sql.column_int(stmt, 0);
+    }
+    g_sql.finalize(stmt);
+    return version;
+}
+
+/**
+ * 执行未完成的迁移（调用者须持有数据库锁）
+ */
+static int db_migrate_locked(void) {
+    char sql[128];
+    
+    if (db_open_locked() != 0) {
+        return -1;
+    }
+    
+    int current = db_schema_version_locked();
+    if (current >= DB_SCHEMA_VERSION) {
+        db_ensure_sms_fts_locked();
+        return 0;
+    }
+    
+    printf("[DB] 数据库结构版本 %d -> %d\n", current, DB_SCHEMA_VERSION);
+    
+    if (db_exec_locked("BEGIN IMMEDIATE;") != 0) {
+        return -1;
+    }
+    
+    if (db_exec_locked("CREATE TABLE IF NOT EXISTS schema_version (version INTEGER NOT NULL);") != 0) {
+        goto fail;
+    }
+    
+    for (int i = 0; i < DB_SCHEMA_VERSION; i++) {
+        const DbMigration *m = &g_migrations[i];
+        if (m->version <= current) {
+            continue;
+        }
+        int ret = m->sql ? db_exec_locked(m->sql) : m->apply();
+        if (ret != 0) {
+            printf("[DB] 迁移 v%d (%s) 失败\n", m->version, m->desc);
+            goto fail;
+        }
+        printf("[DB] 迁移 v%d (%s) 完成\n", m->version, m->desc);
+    }
+    
+    snprintf(sql, sizeof(sql),
+        "DELETE FROM schema_version; INSERT INTO schema_version (version) VALUES (%d);",
+        DB_SCHEMA_VERSION);
+    if (db_exec_locked(sql) != 0 || db_exec_locked("COMMIT;") != 0) {
+        goto fail;
+    }
+    /* v6 这次没有执行 */
+    if (current >= 6) {
+        db_ensure_sms_fts_locked();
+    }
+    return 0;
+    
+fail:
+    db_exec_locked("ROLLBACK;");
+    return -1;
 }
 
 /*============================================================================
@@ -79,28 +597,34 @@ int db_init(const char *path) {
         return 0;
     }
     
-    if (path && strlen(path) > 0) {
+    db_lock();
+    
+    if (path && strlen(path) > 0 && strcmp(path, g_db_path) != 0) {
+        /* 之前按需打开的是默认路径，切换到指定路径 */
+        db_close_locked();
         strncpy(g_db_path, path, sizeof(g_db_path) - 1);
         g_db_path[sizeof(g_db_path) - 1] = '\0';
     }
     
     printf("[DB] 初始化数据库: %s\n", g_db_path);
     
-    if (db_create_tables() != 0) {
-        printf("[DB] 创建表失败\n");
+    if (db_migrate_locked() != 0) {
+        printf("[DB] 数据库结构迁移失败\n");
+        db_unlock();
         return -1;
     }
     
-    /* 为旧数据库添加新字段（忽略错误，字段可能已存在） */
-    db_execute("ALTER TABLE sms_config ADD COLUMN sms_fix_enabled INTEGER DEFAULT 0;");
-    
     g_db_initialized = 1;
+    db_unlock();
     printf("[DB] 数据库初始化完成\n");
     return 0;
 }
 
 void db_deinit(void) {
+    db_lock();
+    db_close_locked();
     g_db_initialized = 0;
+    db_unlock();
     printf("[DB] 数据库模块已关闭\n");
 }
 
@@ -109,137 +633,312 @@ const char *db_get_path(void) {
 }
 
 int db_execute(const char *sql) {
-    char output[1024];
-    int ret = -1;
-    
     if (!sql || strlen(sql) == 0) {
         return -1;
     }
     
-    /* 对于长SQL或包含特殊字符的SQL，使用临时文件 */
-    size_t sql_len = strlen(sql);
-    if (sql_len > 1000 || strchr(sql, '"') || strchr(sql, '\n')) {
-        const char *tmp_sql = "/tmp/db_sql.tmp";
-        FILE *fp = fopen(tmp_sql, "w");
-        if (!fp) {
-            printf("[DB] SQL执行失败: 无法创建临时文件\n");
-            return -1;
-        }
-        fputs(sql, fp);
-        fclose(fp);
-        
-        char cmd[512];
-        snprintf(cmd, sizeof(cmd), "sqlite3 '%s' < %s", g_db_path, tmp_sql);
-        ret = run_command(output, sizeof(output), "sh", "-c", cmd, NULL);
-        
-        unlink(tmp_sql);
-    } else {
-        char cmd[4096];
-        snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
-        ret = run_command(output, sizeof(output), "sh", "-c", cmd, NULL);
-    }
-    
-    if (ret != 0) {
-        printf("[DB] SQL执行失败: %.200s...\n", sql);
-        return -1;
-    }
-    return 0;
+    db_lock();
+    int ret = db_exec_locked(sql);
+    db_unlock();
+    return ret;
 }
 
 int db_execute_safe(const char *sql) {
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = db_execute(sql);
-    pthread_mutex_unlock(&g_db_mutex);
-    return ret;
+    return db_execute(sql);
 }
 
 int db_query_int(const char *sql, int default_val) {
-    char cmd[1024];
-    char output[256] = {0};
+    sqlite3_stmt *stmt = NULL;
+    int value = default_val;
     
     if (!sql || strlen(sql) == 0) {
         return default_val;
     }
     
-    snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
-    
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(output, sizeof(output), "sh", "-c", cmd, NULL);
-    pthread_mutex_unlock(&g_db_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
-        return default_val;
-    }
-    
-    /* 去除换行符 */
-    size_t len = strlen(output);
-    if (len > 0 && output[len-1] == '\n') {
-        output[len-1] = '\0';
+    db_lock();
+    if (db_open_locked() == 0 &&
+        g_sql.prepare_v2(g_db, sql, -1, &stmt, NULL) == SQLITE_OK && stmt) {
+        if (g_sql.step(stmt) == SQLITE_ROW && g_sql.column_type(stmt, 0) != SQLITE_NULL) {
+            value = g_sql.column_int(stmt, 0);
+        }
+    } else if (g_db) {
+        printf("[DB] SQL查询失败: %s, SQL: %.200s...\n", g_sql.errmsg(g_db), sql);
     }
+    if (stmt) g_sql.finalize(stmt);
+    db_unlock();
     
-    return atoi(output);
+    return value;
 }
 
 int db_query_string(const char *sql, char *buf, size_t size) {
-    char cmd[1024];
+    if (!sql || !buf || size == 0) {
+        return -1;
+    }
+    
+    db_lock();
+    int ret = db_query_text_locked(sql, "|", buf, size);
+    db_unlock();
     
+    if (ret != 0) {
+        buf[0] = '\0';
+    }
+    return ret;
+}
+
+int db_query_rows(const char *sql, const char *separator, char *buf, size_t size) {
     if (!sql || !buf || size == 0) {
         return -1;
     }
     
-    buf[0] = '\0';
-    snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
+    if (!separator || strlen(separator) == 0) {
+        separator = "|";
+    }
     
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(buf, size, "sh", "-c", cmd, NULL);
-    pthread_mutex_unlock(&g_db_mutex);
+    db_lock();
+    int ret = db_query_text_locked(sql, separator, buf, size);
+    db_unlock();
     
     if (ret != 0) {
         buf[0] = '\0';
-        return -1;
+    }
+    return ret;
+}
+
+
+/*============================================================================
+ * 预编译语句
+ *============================================================================*/
+
+db_stmt *db_prepare(const char *sql) {
+    sqlite3_stmt *stmt = NULL;
+    
+    if (!sql || strlen(sql) == 0) {
+        return NULL;
     }
     
-    /* 去除换行符 */
-    size_t len = strlen(buf);
-    if (len > 0 && buf[len-1] == '\n') {
-        buf[len-1] = '\0';
+    db_lock();
+    if (db_open_locked() != 0) {
+        db_unlock();
+        return NULL;
     }
     
-    return 0;
+    if (g_sql.prepare_v2(g_db, sql, -1, &stmt, NULL) != SQLITE_OK || !stmt) {
+        printf("[DB] SQL编译失败: %s, SQL: %.200s...\n", g_sql.errmsg(g_db), sql);
+        if (stmt) g_sql.finalize(stmt);
+        db_unlock();
+        return NULL;
+    }
+    
+    db_stmt *st = (db_stmt *)calloc(1, sizeof(db_stmt));
+    if (!st) {
+        g_sql.finalize(stmt);
+        db_unlock();
+        return NULL;
+    }
+    st->stmt = stmt;
+    st->in_use = 1;
+    return st;  /* 锁在 db_finalize 中释放 */
 }
 
-int db_query_rows(const char *sql, const char *separator, char *buf, size_t size) {
-    char cmd[2048];
+db_stmt *db_prepare_cached(const char *key, const char *sql) {
+    db_stmt *slot = NULL;
     
-    if (!sql || !buf || size == 0) {
-        return -1;
+    if (!key || !sql) {
+        return NULL;
     }
     
-    buf[0] = '\0';
+    db_lock();
+    if (db_open_locked() != 0) {
+        db_unlock();
+        return NULL;
+    }
     
-    if (separator && strlen(separator) > 0) {
-        snprintf(cmd, sizeof(cmd), "sqlite3 -separator '%s' '%s' \"%s\"", 
-                 separator, g_db_path, sql);
+    for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+        if (g_stmt_cache[i].key && strcmp(g_stmt_cache[i].key, key) == 0) {
+            if (g_stmt_cache[i].in_use) {
+                /* 同一线程嵌套使用同一语句，退回到非缓存语句 */
+                db_stmt *st = db_prepare(sql);
+                db_unlock();
+                return st;
+            }
+            g_stmt_cache[i].in_use = 1;
+            return &g_stmt_cache[i];
+        }
+        if (!slot && !g_stmt_cache[i].key) {
+            slot = &g_stmt_cache[i];
+        }
+    }
+    
+    if (!slot) {
+        /* 缓存已满，不缓存 */
+        db_stmt *st = db_prepare(sql);
+        db_unlock();
+        return st;
+    }
+    
+    if (g_sql.prepare_v2(g_db, sql, -1, &slot->stmt, NULL) != SQLITE_OK || !slot->stmt) {
+        printf("[DB] SQL编译失败: %s, SQL: %.200s...\n", g_sql.errmsg(g_db), sql);
+        if (slot->stmt) g_sql.finalize(slot->stmt);
+        slot->stmt = NULL;
+        db_unlock();
+        return NULL;
+    }
+    slot->key = key;
+    slot->in_use = 1;
+    return slot;
+}
+
+void db_finalize(db_stmt *st) {
+    if (!st) {
+        return;
+    }
+    
+    if (st->key) {
+        g_sql.reset(st->stmt);
+        g_sql.clear_bindings(st->stmt);
+        st->in_use = 0;
     } else {
-        snprintf(cmd, sizeof(cmd), "sqlite3 '%s' \"%s\"", g_db_path, sql);
+        g_sql.finalize(st->stmt);
+        free(st);
+    }
+    db_unlock();
+}
+
+int db_bind_int(db_stmt *st, int idx, int value) {
+    if (!st) return -1;
+    return g_sql.bind_int(st->stmt, idx, value) == SQLITE_OK ? 0 : -1;
+}
+
+int db_bind_int64(db_stmt *st, int idx, long long value) {
+    if (!st) return -1;
+    return g_sql.bind_int64(st->stmt, idx, value) == SQLITE_OK ? 0 : -1;
+}
+
+int db_bind_text(db_stmt *st, int idx, const char *value) {
+    if (!st) return -1;
+    if (!value) {
+        return g_sql.bind_null(st->stmt, idx) == SQLITE_OK ? 0 : -1;
+    }
+    return g_sql.bind_text(st->stmt, idx, value, -1, SQLITE_TRANSIENT) == SQLITE_OK ? 0 : -1;
+}
+
+int db_bind_blob(db_stmt *st, int idx, const void *data, size_t len) {
+    if (!st) return -1;
+    if (!data) {
+        return g_sql.bind_null(st->stmt, idx) == SQLITE_OK ? 0 : -1;
     }
+    return g_sql.bind_blob(st->stmt, idx, data, (int)len, SQLITE_TRANSIENT) == SQLITE_OK ? 0 : -1;
+}
+
+int db_bind_null(db_stmt *st, int idx) {
+    if (!st) return -1;
+    return g_sql.bind_null(st->stmt, idx) == SQLITE_OK ? 0 : -1;
+}
+
+int db_step(db_stmt *st) {
+    if (!st) return DB_ERROR;
     
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(buf, size, "sh", "-c", cmd, NULL);
-    pthread_mutex_unlock(&g_db_mutex);
+    int rc = g_sql.step(st->stmt);
+    if (rc == SQLITE_ROW) return DB_ROW;
+    if (rc == SQLITE_DONE) return DB_DONE;
     
-    if (ret != 0) {
-        buf[0] = '\0';
+    printf("[DB] SQL执行失败: %s\n", g_sql.errmsg(g_db));
+    return DB_ERROR;
+}
+
+int db_column_is_null(db_stmt *st, int col) {
+    return !st || g_sql.column_type(st->stmt, col) == SQLITE_NULL;
+}
+
+int db_column_int(db_stmt *st, int col) {
+    return st ? g_sql.column_int(st->stmt, col) : 0;
+}
+
+long long db_column_int64(db_stmt *st, int col) {
+    return st ? g_sql.column_int64(st->stmt, col) : 0;
+}
+
+const char *db_column_text(db_stmt *st, int col) {
+    const char *text = st ? (const char *)g_sql.column_text(st->stmt, col) : NULL;
+    return text ? text : "";
+}
+
+const void *db_column_blob(db_stmt *st, int col) {
+    return st ? g_sql.column_blob(st->stmt, col) : NULL;
+}
+
+int db_column_bytes(db_stmt *st, int col) {
+    return st ? g_sql.column_bytes(st->stmt, col) : 0;
+}
+
+size_t db_column_copy(db_stmt *st, int col, char *buf, size_t size) {
+    if (!buf || size == 0) {
+        return 0;
+    }
+    
+    const char *text = db_column_text(st, col);
+    size_t len = (size_t)db_column_bytes(st, col);
+    if (len > size - 1) {
+        len = size - 1;
+    }
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+    return len;
+}
+
+int db_foreach(db_stmt *st, db_row_cb cb, void *user_data) {
+    int rows = 0;
+    int rc;
+    
+    if (!st || !cb) {
         return -1;
     }
     
-    /* 去除末尾换行符 */
-    size_t len = strlen(buf);
-    if (len > 0 && buf[len-1] == '\n') {
-        buf[len-1] = '\0';
+    while ((rc = db_step(st)) == DB_ROW) {
+        rows++;
+        if (cb(st, user_data) != 0) {
+            return rows;
+        }
     }
     
-    return 0;
+    return rc == DB_DONE ? rows : -1;
+}
+
+int db_begin(void) {
+    db_lock();
+    if (db_exec_locked("BEGIN;") != 0) {
+        db_unlock();
+        return -1;
+    }
+    return 0;  /* 锁在 db_commit / db_rollback 中释放 */
+}
+
+int db_commit(void) {
+    int ret = db_exec_locked("COMMIT;");
+    if (ret != 0) {
+        db_exec_locked("ROLLBACK;");
+    }
+    db_unlock();
+    return ret;
+}
+
+void db_rollback(void) {
+    db_exec_locked("ROLLBACK;");
+    db_unlock();
+}
+
+int db_changes(void) {
+    db_lock();
+    int n = g_db ? g_sql.changes(g_db) : 0;
+    db_unlock();
+    return n;
+}
+
+long long db_last_insert_id(void) {
+    db_lock();
+    long long id = g_db ? g_sql.last_insert_rowid(g_db) : 0;
+    db_unlock();
+    return id;
 }
 
 
@@ -307,48 +1006,150 @@ void db_unescape_string(char *str) {
  * 配置管理
  *============================================================================*/
 
+/**
+ * 加载配置缓存（调用者须持有数据库锁）
+ * 数据库尚未建表时返回-1，下次读取时重试
+ */
+static int config_cache_load_locked(void) {
+    if (g_config_cache) {
+        return 0;
+    }
+    
+    db_stmt *st = db_prepare("SELECT key, value FROM config;");
+    if (!st) {
+        return -1;
+    }
+    
+    g_config_cache = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    while (db_step(st) == DB_ROW) {
+        if (!db_column_is_null(st, 1)) {
+            g_hash_table_replace(g_config_cache,
+                g_strdup(db_column_text(st, 0)), g_strdup(db_column_text(st, 1)));
+        }
+    }
+    db_finalize(st);
+    
+    printf("[DB] 配置缓存已加载: %u 项\n", g_hash_table_size(g_config_cache));
+    return 0;
+}
+
 int config_get(const char *key, char *value, size_t value_size) {
-    char cmd[512];
+    int ret = -1;
     
     if (!key || !value || value_size == 0) {
         return -1;
     }
     
     value[0] = '\0';
-    snprintf(cmd, sizeof(cmd), 
-        "sqlite3 '%s' \"SELECT value FROM config WHERE key='%s';\"", 
-        g_db_path, key);
     
-    pthread_mutex_lock(&g_db_mutex);
-    int ret = run_command(value, value_size, "sh", "-c", cmd, NULL);
-    pthread_mutex_unlock(&g_db_mutex);
+    db_lock();
+    if (config_cache_load_locked() == 0) {
+        const char *cached = g_hash_table_lookup(g_config_cache, key);
+        if (cached && cached[0] != '\0') {
+            strncpy(value, cached, value_size - 1);
+            value[value_size - 1] = '\0';
+            ret = 0;
+        }
+    }
+    db_unlock();
+    
+    return ret;
+}
+
+int config_set(const char *key, const char *value) {
+    struct { config_change_cb cb; void *user_data; } notify[CONFIG_MAX_LISTENERS];
+    int notify_count = 0;
+    int ret = -1;
     
-    if (ret != 0 || strlen(value) == 0) {
-        value[0] = '\0';
+    if (!key || !value) {
         return -1;
     }
     
-    /* 去除换行符 */
-    size_t len = strlen(value);
-    if (len > 0 && value[len-1] == '\n') {
-        value[len-1] = '\0';
+    db_lock();
+    
+    /* 值未变化时不写库，也不通知 */
+    if (config_cache_load_locked() == 0) {
+        const char *cached = g_hash_table_lookup(g_config_cache, key);
+        if (cached && strcmp(cached, value) == 0) {
+            db_unlock();
+            return 0;
+        }
     }
     
-    return 0;
+    db_stmt *st = db_prepare_cached("config_set",
+        "INSERT OR REPLACE INTO config (key, value) VALUES (?1, ?2);");
+    if (st) {
+        db_bind_text(st, 1, key);
+        db_bind_text(st, 2, value);
+        ret = db_step(st) == DB_DONE ? 0 : -1;
+        db_finalize(st);
+    }
+    
+    if (ret == 0) {
+        if (g_config_cache) {
+            g_hash_table_replace(g_config_cache, g_strdup(key), g_strdup(value));
+        }
+        for (int i = 0; i < CONFIG_MAX_LISTENERS; i++) {
+            if (g_config_listeners[i].id > 0 &&
+                strncmp(key, g_config_listeners[i].prefix, strlen(g_config_listeners[i].prefix)) == 0) {
+                notify[notify_count].cb = g_config_listeners[i].cb;
+                notify[notify_count].user_data = g_config_listeners[i].user_data;
+                notify_count++;
+            }
+        }
+    }
+    
+    db_unlock();
+    
+    /* 在锁外回调，监听者可以安全地调用其他模块 */
+    for (int i = 0; i < notify_count; i++) {
+        notify[i].cb(key, value, notify[i].user_data);
+    }
+    
+    return ret;
 }
 
-int config_set(const char *key, const char *value) {
-    char sql[1024];
+int config_add_listener(const char *prefix, config_change_cb cb, void *user_data) {
+    int id = -1;
     
-    if (!key || !value) {
+    if (!cb) {
         return -1;
     }
     
-    snprintf(sql, sizeof(sql),
-        "INSERT OR REPLACE INTO config (key, value) VALUES ('%s', '%s');",
-        key, value);
+    db_lock();
+    for (int i = 0; i < CONFIG_MAX_LISTENERS; i++) {
+        if (g_config_listeners[i].id == 0) {
+            id = g_config_listener_next_id++;
+            g_config_listeners[i].id = id;
+            strncpy(g_config_listeners[i].prefix, prefix ? prefix : "",
+                    sizeof(g_config_listeners[i].prefix) - 1);
+            g_config_listeners[i].prefix[sizeof(g_config_listeners[i].prefix) - 1] = '\0';
+            g_config_listeners[i].cb = cb;
+            g_config_listeners[i].user_data = user_data;
+            break;
+        }
+    }
+    db_unlock();
     
-    return db_execute_safe(sql);
+    if (id < 0) {
+        printf("[DB] 配置监听数量已达上限\n");
+    }
+    return id;
+}
+
+void config_remove_listener(int id) {
+    if (id <= 0) {
+        return;
+    }
+    
+    db_lock();
+    for (int i = 0; i < CONFIG_MAX_LISTENERS; i++) {
+        if (g_config_listeners[i].id == id) {
+            memset(&g_config_listeners[i], 0, sizeof(g_config_listeners[i]));
+            break;
+        }
+    }
+    db_unlock();
 }
 
 int config_get_int(const char *key, int default_val) {
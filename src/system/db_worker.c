@@ -0,0 +1,243 @@
+/**
+ * @file db_worker.c
+ * @brief 数据库异步工作线程实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <pthread.h>
+#include <glib.h>
+#include "database.h"
+#include "db_worker.h"
+
+typedef struct {
+    int type;
+    db_job_func job;
+    db_done_func done;
+    void *arg;
+    int result;
+} DbJob;
+
+static GQueue g_job_queue = G_QUEUE_INIT;
+static pthread_mutex_t g_worker_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_worker_cond;
+static pthread_t g_worker_thread;
+static int g_worker_running = 0;
+
+/*============================================================================
+ * 完成回调投递
+ *============================================================================*/
+
+static gboolean deliver_done(gpointer data) {
+    DbJob *job = (DbJob *)data;
+    if (job->done) {
+        job->done(job->result, job->arg);
+    }
+    g_free(job);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * 将完成的任务投递到主循环
+ */
+static void finish_job(DbJob *job) {
+    if (!job->done) {
+        g_free(job);
+        return;
+    }
+    g_idle_add_full(G_PRIORITY_DEFAULT, deliver_done, job, NULL);
+}
+
+/*============================================================================
+ * 工作线程
+ *============================================================================*/
+
+/**
+ * 计算截止时间（CLOCK_MONOTONIC）
+ */
+static void deadline_after_ms(struct timespec *ts, int ms) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += ms / 1000;
+    ts->tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * 在窗口期内取下一个写任务，队首不是写任务或超时返回NULL
+ */
+static DbJob *next_write_job(const struct timespec *deadline) {
+    DbJob *job = NULL;
+
+    pthread_mutex_lock(&g_worker_mutex);
+    while (g_queue_is_empty(&g_job_queue) && g_worker_running) {
+        if (pthread_cond_timedwait(&g_worker_cond, &g_worker_mutex, deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+    DbJob *head = (DbJob *)g_queue_peek_head(&g_job_queue);
+    if (head && head->type == DB_JOB_WRITE) {
+        job = (DbJob *)g_queue_pop_head(&g_job_queue);
+    }
+    pthread_mutex_unlock(&g_worker_mutex);
+
+    return job;
+}
+
+/**
+ * 执行一组写任务 - 先在窗口期内收集任务，再共用一个事务执行，提交后投递完成回调
+ * 收集期间不持有数据库锁，主循环的配置/认证读取不会被窗口期阻塞；
+ * 每个任务在自己的保存点内执行，失败的任务只回滚自己的写入
+ */
+static void run_write_batch(DbJob *first) {
+    DbJob *batch[DB_GROUP_COMMIT_MAX];
+    struct timespec deadline;
+    int count = 0;
+
+    batch[count++] = first;
+    deadline_after_ms(&deadline, DB_GROUP_COMMIT_WINDOW_MS);
+    while (count < DB_GROUP_COMMIT_MAX) {
+        DbJob *job = next_write_job(&deadline);
+        if (!job) {
+            break;
+        }
+        batch[count++] = job;
+    }
+
+    int in_tx = (db_begin() == 0);
+
+    for (int i = 0; i < count; i++) {
+        int savepoint = in_tx && db_execute("SAVEPOINT db_job;") == 0;
+        batch[i]->result = batch[i]->job(batch[i]->arg);
+        if (savepoint) {
+            if (batch[i]->result != 0) {
+                db_execute("ROLLBACK TO db_job;");
+            }
+            db_execute("RELEASE db_job;");
+        }
+    }
+
+    if (in_tx && db_commit() != 0) {
+        printf("[DB] 组提交失败，%d 个写任务已回滚\n", count);
+        for (int i = 0; i < count; i++) {
+            batch[i]->result = -1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        finish_job(batch[i]);
+    }
+}
+
+static void *worker_thread_func(void *arg) {
+    (void)arg;
+
+    while (1) {
+        pthread_mutex_lock(&g_worker_mutex);
+        while (g_queue_is_empty(&g_job_queue) && g_worker_running) {
+            pthread_cond_wait(&g_worker_cond, &g_worker_mutex);
+        }
+        DbJob *job = (DbJob *)g_queue_pop_head(&g_job_queue);
+        pthread_mutex_unlock(&g_worker_mutex);
+
+        /* 已停止且队列已空 */
+        if (!job) {
+            break;
+        }
+
+        if (job->type == DB_JOB_WRITE) {
+            run_write_batch(job);
+        } else {
+            job->result = job->job(job->arg);
+            finish_job(job);
+        }
+    }
+
+    return NULL;
+}
+
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
+
+int db_worker_start(void) {
+    pthread_condattr_t attr;
+
+    if (g_worker_running) {
+        return 0;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_worker_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    g_worker_running = 1;
+    if (pthread_create(&g_worker_thread, NULL, worker_thread_func, NULL) != 0) {
+        printf("[DB] 启动数据库工作线程失败\n");
+        g_worker_running = 0;
+        pthread_cond_destroy(&g_worker_cond);
+        return -1;
+    }
+
+    printf("[DB] 数据库工作线程已启动\n");
+    return 0;
+}
+
+void db_worker_stop(void) {
+    pthread_mutex_lock(&g_worker_mutex);
+    if (!g_worker_running) {
+        pthread_mutex_unlock(&g_worker_mutex);
+        return;
+    }
+    g_worker_running = 0;
+    pthread_cond_broadcast(&g_worker_cond);
+    pthread_mutex_unlock(&g_worker_mutex);
+
+    pthread_join(g_worker_thread, NULL);
+    pthread_cond_destroy(&g_worker_cond);
+    printf("[DB] 数据库工作线程已停止\n");
+}
+
+int db_submit(int type, db_job_func job, db_done_func done, void *arg) {
+    if (!job || (type != DB_JOB_READ && type != DB_JOB_WRITE)) {
+        return -1;
+    }
+
+    DbJob *item = g_new0(DbJob, 1);
+    item->type = type;
+    item->job = job;
+    item->done = done;
+    item->arg = arg;
+
+    pthread_mutex_lock(&g_worker_mutex);
+    if (!g_worker_running) {
+        pthread_mutex_unlock(&g_worker_mutex);
+        item->result = job(arg);
+        finish_job(item);
+        return 0;
+    }
+    if (g_queue_get_length(&g_job_queue) >= DB_WORKER_QUEUE_MAX) {
+        pthread_mutex_unlock(&g_worker_mutex);
+        printf("[DB] 数据库任务队列已满\n");
+        g_free(item);
+        return -1;
+    }
+    g_queue_push_tail(&g_job_queue, item);
+    pthread_cond_signal(&g_worker_cond);
+    pthread_mutex_unlock(&g_worker_mutex);
+
+    return 0;
+}
+
+int db_worker_queue_depth(void) {
+    pthread_mutex_lock(&g_worker_mutex);
+    int depth = (int)g_queue_get_length(&g_job_queue);
+    pthread_mutex_unlock(&g_worker_mutex);
+    return depth;
+}
@@ -0,0 +1,205 @@
+/**
+ * @file dbus_query.c
+ * @brief oFono D-Bus 并发查询组实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <gio/gio.h>
+#include "dbus_query.h"
+#include "ofono.h"
+#include "ofono_bus.h"
+
+typedef struct {
+    DbusQueryGroup *group;
+    char *path;
+    char *iface;
+    char *method;
+    GVariant *params;
+    GVariantType *reply_type;
+    GVariant *result;
+    GError *error;
+} DbusQueryCall;
+
+struct DbusQueryGroup {
+    GDBusConnection *conn;
+    gint64 deadline;                          /* g_get_monotonic_time() 微秒 */
+    DbusQueryCall calls[DBUS_QUERY_MAX_CALLS];
+    int count;                                /* 已添加的调用数 */
+    int fired;                                /* 已发出的调用数 */
+    int in_flight;                            /* 尚未返回的调用数 */
+    dbus_query_done_func done;                /* 异步模式的完成回调 */
+    void *user_data;
+};
+
+/*============================================================================
+ * 内部实现
+ *============================================================================*/
+
+static void on_call_done(GObject *source, GAsyncResult *res, gpointer data) {
+    DbusQueryCall *call = (DbusQueryCall *)data;
+    DbusQueryGroup *group = call->group;
+
+    call->result = g_dbus_connection_call_finish(G_DBUS_CONNECTION(source), res, &call->error);
+    if (!call->result) {
+        printf("[DBUS] %s.%s (%s) 失败: %s\n", call->iface, call->method, call->path,
+               call->error ? call->error->message : "unknown");
+    }
+
+    if (--group->in_flight == 0 && group->done) {
+        group->done(group, group->user_data);
+        dbus_query_group_free(group);
+    }
+}
+
+/**
+ * 发出所有尚未发出的调用
+ * @return 发出的调用数
+ */
+static int fire_pending(DbusQueryGroup *group) {
+    int fired = 0;
+
+    for (; group->fired < group->count; group->fired++) {
+        DbusQueryCall *call = &group->calls[group->fired];
+        gint64 remaining_ms = (group->deadline - g_get_monotonic_time()) / 1000;
+
+        if (remaining_ms <= 0) {
+            g_set_error_literal(&call->error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "查询组已超时");
+            continue;
+        }
+
+        group->in_flight++;
+        fired++;
+        g_dbus_connection_call(group->conn, OFONO_SERVICE, call->path, call->iface, call->method,
+                               call->params, call->reply_type, G_DBUS_CALL_FLAGS_NONE,
+                               (int)remaining_ms, NULL, on_call_done, call);
+    }
+    return fired;
+}
+
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
+
+DbusQueryGroup *dbus_query_group_new(int timeout_ms) {
+    GError *error = NULL;
+    /* 与 ofono.c 共用同一条系统总线连接（新引用，dbus_query_group_free 中释放） */
+    GDBusConnection *conn = ofono_bus_get(&error);
+    if (!conn) {
+        printf("[DBUS] 连接系统总线失败: %s\n", error ? error->message : "unknown");
+        if (error) g_error_free(error);
+        return NULL;
+    }
+
+    DbusQueryGroup *group = g_new0(DbusQueryGroup, 1);
+    group->conn = conn;
+    group->deadline = g_get_monotonic_time() + (gint64)timeout_ms * 1000;
+    return group;
+}
+
+int dbus_query_group_add(DbusQueryGroup *group, const char *path, const char *iface,
+                         const char *method, GVariant *params, const char *reply_type) {
+    if (!group || !path || !iface || !method) {
+        if (params) g_variant_unref(g_variant_ref_sink(params));
+        return -1;
+    }
+    if (group->count >= DBUS_QUERY_MAX_CALLS) {
+        printf("[DBUS] 查询组调用数超过上限 %d\n", DBUS_QUERY_MAX_CALLS);
+        if (params) g_variant_unref(g_variant_ref_sink(params));
+        return -1;
+    }
+
+    DbusQueryCall *call = &group->calls[group->count];
+    call->group = group;
+    call->path = g_strdup(path);
+    call->iface = g_strdup(iface);
+    call->method = g_strdup(method);
+    call->params = params ? g_variant_ref_sink(params) : NULL;
+    call->reply_type = reply_type ? g_variant_type_new(reply_type) : NULL;
+    return group->count++;
+}
+
+int dbus_query_group_add_properties(DbusQueryGroup *group, const char *path, const char *iface) {
+    return dbus_query_group_add(group, path, iface, "GetProperties", NULL, "(a{sv})");
+}
+
+int dbus_query_group_run_sync(DbusQueryGroup *group) {
+    if (!group) return 0;
+
+    int first = group->fired;
+    GMainContext *ctx = g_main_context_new();
+
+    /* 回调投递到私有上下文，只迭代它，不会执行调用线程中的其他事件源 */
+    g_main_context_push_thread_default(ctx);
+    fire_pending(group);
+    while (group->in_flight > 0) {
+        g_main_context_iteration(ctx, TRUE);
+    }
+    g_main_context_pop_thread_default(ctx);
+    g_main_context_unref(ctx);
+
+    int ok = 0;
+    for (int i = first; i < group->fired; i++) {
+        if (group->calls[i].result) ok++;
+    }
+    return ok;
+}
+
+/* 没有需要发出的调用时，完成回调仍在主循环中异步执行 */
+static gboolean deliver_empty(gpointer data) {
+    DbusQueryGroup *group = (DbusQueryGroup *)data;
+    group->done(group, group->user_data);
+    dbus_query_group_free(group);
+    return G_SOURCE_REMOVE;
+}
+
+int dbus_query_group_run_async(DbusQueryGroup *group, dbus_query_done_func done, void *user_data) {
+    if (!group || !done || group->in_flight > 0) return -1;
+
+    group->done = done;
+    group->user_data = user_data;
+    if (fire_pending(group) == 0) {
+        g_idle_add(deliver_empty, group);
+    }
+    return 0;
+}
+
+GVariant *dbus_query_group_result(DbusQueryGroup *group, int index) {
+    if (!group || index < 0 || index >= group->count) return NULL;
+    return group->calls[index].result;
+}
+
+const char *dbus_query_group_error(DbusQueryGroup *group, int index) {
+    if (!group || index < 0 || index >= group->count) return NULL;
+    return group->calls[index].error ? group->calls[index].error->message : NULL;
+}
+
+void dbus_query_group_free(DbusQueryGroup *group) {
+    if (!group) return;
+
+    for (int i = 0; i < group->count; i++) {
+        DbusQueryCall *call = &group->calls[i];
+        g_free(call->path);
+        g_free(call->iface);
+        g_free(call->method);
+        if (call->params) g_variant_unref(call->params);
+        if (call->reply_type) g_variant_type_free(call->reply_type);
+        if (call->result) g_variant_unref(call->result);
+        if (call->error) g_error_free(call->error);
+    }
+    g_object_unref(group->conn);
+    g_free(group);
+}
+
+GVariant *dbus_query_lookup_property(GVariant *reply, const char *key) {
+    if (!reply || !key || !g_variant_is_of_type(reply, G_VARIANT_TYPE("(a{sv})"))) {
+        return NULL;
+    }
+
+    GVariant *props = g_variant_get_child_value(reply, 0);
+    GVariant *value = g_variant_lookup_value(props, key, NULL);
+    g_variant_unref(props);
+    return value;
+}
@@ -10,76 +10,428 @@
 #include <unistd.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <spawn.h>
+#include <glib.h>
+#include <glib-unix.h>
 #include "exec_utils.h"
 
-int run_command(char *output, size_t size, const char *cmd, ...) {
-    va_list args;
-    char *argv[32];
+/* 超时后先发 SIGTERM，等待此时间后仍未退出则 SIGKILL */
+#define EXEC_KILL_GRACE_MS  500
+
+/* 子进程退出后等待管道 EOF 的轮询间隔（后台子进程可能继承并占用管道） */
+#define EXEC_POLL_SLICE_MS  100
+
+/* 异步命令每次从管道读取的块大小 */
+#define EXEC_READ_CHUNK     4096
+
+/* 构建以 NULL 结尾的参数数组 */
+static void build_argv(char **argv, int max, const char *cmd, va_list args) {
     int argc = 0;
+    char *arg;
 
-    /* 构建参数数组 */
     argv[argc++] = (char *)cmd;
-    va_start(args, cmd);
-    char *arg;
-    while ((arg = va_arg(args, char *)) != NULL && argc < 31) {
+    while ((arg = va_arg(args, char *)) != NULL && argc < max - 1) {
         argv[argc++] = arg;
     }
-    va_end(args);
     argv[argc] = NULL;
+}
 
-    /* 创建管道 */
-    int pipefd[2];
-    if (pipe(pipefd) == -1) return -1;
+static long long monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-    pid_t pid = fork();
-    if (pid == -1) {
-        close(pipefd[0]);
-        close(pipefd[1]);
+/* 向子进程组发送信号，宽限期内未退出则强制结束，返回时子进程已回收 */
+static void kill_process_group(pid_t pid, int *status) {
+    kill(-pid, SIGTERM);
+
+    long long deadline = monotonic_ms() + EXEC_KILL_GRACE_MS;
+    while (monotonic_ms() < deadline) {
+        if (waitpid(pid, status, WNOHANG) == pid) {
+            kill(-pid, SIGKILL);  /* 清理组内残留的子进程 */
+            return;
+        }
+        usleep(20 * 1000);
+    }
+
+    kill(-pid, SIGKILL);
+    while (waitpid(pid, status, 0) < 0 && errno == EINTR) {
+    }
+}
+
+/* 创建两端均为 FD_CLOEXEC 的管道，避免其他子进程继承（子进程中由 dup2 得到的 1/2 不受影响） */
+static int open_pipe(int pipefd[2]) {
+    if (pipe(pipefd) == -1) {
         return -1;
     }
+    fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+    fcntl(pipefd[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+}
+
+/* 去除尾部空白 */
+static size_t trim_trailing(char *output, size_t total) {
+    while (total > 0 && (output[total-1] == '\n' || output[total-1] == '\r' || output[total-1] == ' ')) {
+        output[--total] = '\0';
+    }
+    return total;
+}
+
+/**
+ * 启动子进程，标准输出重定向到管道写端；merge_stderr 为真时标准错误也写入管道，
+ * 否则继承本进程的标准错误（与 popen 相同）
+ * 使用 posix_spawn（glibc 下为 vfork 语义），不复制父进程页表，
+ * 内存紧张时也不会因 fork 失败；子进程放入以自身 PID 为组号的新进程组
+ */
+static int spawn_child(pid_t *pid, int pipefd[2], int merge_stderr, char *const argv[]) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t sigdefault, sigmask;
+    extern char **environ;
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addclose(&actions, pipefd[0]);
+    posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDOUT_FILENO);
+    if (merge_stderr) {
+        posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDERR_FILENO);
+    }
+    posix_spawn_file_actions_addclose(&actions, pipefd[1]);
+
+    /* 恢复默认信号处理和信号掩码，与 fork+exec 的行为一致 */
+    sigemptyset(&sigmask);
+    sigemptyset(&sigdefault);
+    sigaddset(&sigdefault, SIGPIPE);
+    sigaddset(&sigdefault, SIGINT);
+    sigaddset(&sigdefault, SIGTERM);
+
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setpgroup(&attr, 0);
+    posix_spawnattr_setsigmask(&attr, &sigmask);
+    posix_spawnattr_setsigdefault(&attr, &sigdefault);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK |
+                                    POSIX_SPAWN_SETSIGDEF);
 
-    if (pid == 0) {
-        /* 子进程 */
+    int err = posix_spawnp(pid, argv[0], &actions, &attr, argv, environ);
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0) {
+        printf("[EXEC] 启动命令失败: %s: %s\n", argv[0], strerror(err));
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * 执行命令并捕获输出
+ * 子进程放入独立进程组，超时后整组结束；输出超出缓冲区时继续读取并丢弃，
+ * 避免子进程阻塞在写满的管道上
+ * @param timeout_ms 超时毫秒数，<=0 不限时
+ */
+static int exec_capture(int timeout_ms, char *output, size_t size, char *const argv[]) {
+    int pipefd[2];
+    size_t total = 0;
+    int truncated = 0;
+    int timed_out = 0;
+    int reaped = 0;
+    int status = 0;
+
+    if (!output || size == 0) return EXEC_ERROR;
+    output[0] = '\0';
+
+    if (open_pipe(pipefd) != 0) return EXEC_ERROR;
+
+    pid_t pid;
+    if (spawn_child(&pid, pipefd, 1, argv) != 0) {
         close(pipefd[0]);
-        dup2(pipefd[1], STDOUT_FILENO);
-        dup2(pipefd[1], STDERR_FILENO);
         close(pipefd[1]);
-        execvp(cmd, argv);
-        _exit(127);
+        return EXEC_ERROR;
     }
-
-    /* 父进程 */
     close(pipefd[1]);
 
-    /* 读取输出 */
-    size_t total = 0;
-    ssize_t n;
-    while (total < size - 1 && (n = read(pipefd[0], output + total, size - 1 - total)) > 0) {
-        total += n;
+    long long deadline = timeout_ms > 0 ? monotonic_ms() + timeout_ms : 0;
+    struct pollfd pfd = { .fd = pipefd[0], .events = POLLIN };
+
+    while (1) {
+        int wait_ms = EXEC_POLL_SLICE_MS;
+        if (deadline) {
+            long long left = deadline - monotonic_ms();
+            if (left <= 0) {
+                timed_out = 1;
+                break;
+            }
+            if (left < wait_ms) wait_ms = (int)left;
+        }
+
+        int pr = poll(&pfd, 1, wait_ms);
+        if (pr < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pr == 0) {
+            /* 子进程已退出但管道仍被其后台子进程占用，不再等待 EOF */
+            if (!reaped && waitpid(pid, &status, WNOHANG) == pid) {
+                reaped = 1;
+            }
+            if (reaped) break;
+            continue;
+        }
+
+        char discard[512];
+        char *dst = total < size - 1 ? output + total : discard;
+        size_t room = total < size - 1 ? size - 1 - total : sizeof(discard);
+        ssize_t n = read(pipefd[0], dst, room);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            break;
+        }
+        if (n == 0) break;  /* EOF */
+        if (dst == discard) {
+            truncated = 1;
+        } else {
+            total += (size_t)n;
+        }
     }
     output[total] = '\0';
     close(pipefd[0]);
 
-    /* 等待子进程 */
-    int status;
-    waitpid(pid, &status, 0);
-
-    /* 去除尾部空白 */
-    while (total > 0 && (output[total-1] == '\n' || output[total-1] == '\r' || output[total-1] == ' ')) {
-        output[--total] = '\0';
+    if (timed_out) {
+        printf("[EXEC] 命令超时(%dms)，结束进程组: %s\n", timeout_ms, argv[0]);
+        if (!reaped) kill_process_group(pid, &status);
+        else kill(-pid, SIGKILL);
+    } else if (!reaped) {
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+        }
     }
 
-    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    total = trim_trailing(output, total);
+
+    if (timed_out) return EXEC_TIMEOUT;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) return EXEC_ERROR;
+    return truncated ? EXEC_TRUNCATED : EXEC_OK;
+}
+
+int run_command(char *output, size_t size, const char *cmd, ...) {
+    va_list args;
+    char *argv[32];
+
+    va_start(args, cmd);
+    build_argv(argv, 32, cmd, args);
+    va_end(args);
+
+    /* 保持原有语义：不限时，输出截断不视为失败 */
+    int ret = exec_capture(0, output, size, argv);
+    return ret == EXEC_OK || ret == EXEC_TRUNCATED ? 0 : -1;
 }
 
 int run_command_timeout(int timeout_sec, char *output, size_t size, const char *cmd, ...) {
-    /* 简化实现：直接调用 run_command */
-    /* TODO: 实现真正的超时机制 */
     va_list args;
+    char *argv[32];
+
     va_start(args, cmd);
-    int ret = run_command(output, size, cmd, args);
+    build_argv(argv, 32, cmd, args);
     va_end(args);
-    return ret;
+
+    return exec_capture(timeout_sec > 0 ? timeout_sec * 1000 : 0, output, size, argv);
+}
+
+/*============================================================================
+ * 异步执行
+ *============================================================================*/
+
+typedef struct {
+    GPid pid;
+    int fd;                 /* 管道读端，已关闭为 -1 */
+    guint io_id;
+    guint timeout_id;
+    guint kill_id;
+    GString *output;
+    size_t max_output;
+    int truncated;
+    int timed_out;
+    int timeout_ms;
+    char *name;
+    exec_done_func done;
+    void *user_data;
+} ExecTask;
+
+static int g_async_running = 0;
+
+/* 停止读取管道（EOF，或子进程已退出而后台子进程仍占用管道） */
+static void task_close_pipe(ExecTask *task) {
+    if (task->io_id) {
+        g_source_remove(task->io_id);
+        task->io_id = 0;
+    }
+    if (task->fd >= 0) {
+        close(task->fd);
+        task->fd = -1;
+    }
+}
+
+/**
+ * 读取管道中当前可读的数据
+ * @return 1 已到 EOF 或出错, 0 暂无更多数据
+ */
+static int task_drain(ExecTask *task) {
+    char buf[EXEC_READ_CHUNK];
+
+    while (1) {
+        ssize_t n = read(task->fd, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN ? 0 : 1;
+        }
+        if (n == 0) return 1;
+
+        size_t room = task->max_output - task->output->len;
+        if ((size_t)n > room) {
+            task->truncated = 1;
+            n = (ssize_t)room;
+        }
+        if (n > 0) {
+            g_string_append_len(task->output, buf, n);
+        }
+    }
+}
+
+static gboolean on_task_output(gint fd, GIOCondition condition, gpointer data) {
+    ExecTask *task = (ExecTask *)data;
+    (void)fd;
+    (void)condition;
+
+    if (task_drain(task)) {
+        task->io_id = 0;
+        close(task->fd);
+        task->fd = -1;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static gboolean on_task_kill_grace(gpointer data) {
+    ExecTask *task = (ExecTask *)data;
+    task->kill_id = 0;
+    kill(-task->pid, SIGKILL);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean on_task_timeout(gpointer data) {
+    ExecTask *task = (ExecTask *)data;
+    task->timeout_id = 0;
+    task->timed_out = 1;
+    printf("[EXEC] 命令超时(%dms)，结束进程组: %s\n", task->timeout_ms, task->name);
+    kill(-task->pid, SIGTERM);
+    task->kill_id = g_timeout_add(EXEC_KILL_GRACE_MS, on_task_kill_grace, task);
+    return G_SOURCE_REMOVE;
+}
+
+/* 子进程退出: 读完管道中剩余数据后回调 */
+static void on_task_exit(GPid pid, gint status, gpointer data) {
+    ExecTask *task = (ExecTask *)data;
+    int result;
+
+    if (task->fd >= 0) {
+        task_drain(task);
+    }
+    task_close_pipe(task);
+    if (task->timeout_id) {
+        g_source_remove(task->timeout_id);
+    }
+    if (task->kill_id) {
+        g_source_remove(task->kill_id);
+    }
+    if (task->timed_out) {
+        kill(-pid, SIGKILL);  /* 清理组内残留的子进程 */
+    }
+    g_spawn_close_pid(pid);
+    g_async_running--;
+
+    task->output->len = trim_trailing(task->output->str, task->output->len);
+
+    if (task->timed_out) {
+        result = EXEC_TIMEOUT;
+    } else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        result = EXEC_ERROR;
+    } else {
+        result = task->truncated ? EXEC_TRUNCATED : EXEC_OK;
+    }
+
+    if (task->done) {
+        task->done(result, task->output->str, task->user_data);
+    }
+    g_string_free(task->output, TRUE);
+    g_free(task->name);
+    g_free(task);
+}
+
+/* 启动异步命令，argv 已组装好 */
+static int start_async(int timeout_sec, size_t max_output, int merge_stderr, exec_done_func done,
+                       void *user_data, char *const argv[]) {
+    int pipefd[2];
+    pid_t pid;
+
+    if (open_pipe(pipefd) != 0) return -1;
+    if (spawn_child(&pid, pipefd, merge_stderr, argv) != 0) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return -1;
+    }
+    close(pipefd[1]);
+    fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL) | O_NONBLOCK);
+
+    ExecTask *task = g_new0(ExecTask, 1);
+    task->pid = pid;
+    task->fd = pipefd[0];
+    task->max_output = max_output > 0 ? max_output : EXEC_ASYNC_OUTPUT_MAX;
+    task->output = g_string_sized_new(256);
+    task->name = g_strdup(argv[0]);
+    task->done = done;
+    task->user_data = user_data;
+
+    task->io_id = g_unix_fd_add(task->fd, G_IO_IN | G_IO_HUP | G_IO_ERR, on_task_output, task);
+    if (timeout_sec > 0) {
+        task->timeout_ms = timeout_sec * 1000;
+        task->timeout_id = g_timeout_add(task->timeout_ms, on_task_timeout, task);
+    }
+    g_child_watch_add(pid, on_task_exit, task);
+    g_async_running++;
+
+    return 0;
+}
+
+int run_command_async(int timeout_sec, size_t max_output, exec_done_func done, void *user_data,
+                      const char *cmd, ...) {
+    va_list args;
+    char *argv[32];
+
+    va_start(args, cmd);
+    build_argv(argv, 32, cmd, args);
+    va_end(args);
+
+    return start_async(timeout_sec, max_output, 1, done, user_data, argv);
+}
+
+int run_command_async_stdout(int timeout_sec, size_t max_output, exec_done_func done, void *user_data,
+                             const char *cmd, ...) {
+    va_list args;
+    char *argv[32];
+
+    va_start(args, cmd);
+    build_argv(argv, 32, cmd, args);
+    va_end(args);
+
+    return start_async(timeout_sec, max_output, 0, done, user_data, argv);
+}
+
+int exec_async_running(void) {
+    return g_async_running;
 }
 
 void device_reboot(void) {
@@ -17,12 +17,14 @@
 #include "ofono.h"
 #include "dbus_core.h"
 #include "sysinfo.h"
+#include "at_cache.h"
+#include "singleflight.h"
+#include "at_scheduler.h"
+#include "ofono_bus.h"
 
 /* ==================== 常量定义 ==================== */
 #define OFONO_MODEM_IFACE   "org.ofono.Modem"
 #define DEFAULT_MODEM_PATH  "/ril_0"
-#define AT_COMMAND_TIMEOUT  8000  /* 8秒超时 (毫秒) */
-#define MAX_RETRIES         1
 
 /* ==================== 前向声明 ==================== */
 int ofono_start_data_monitor(void);
@@ -32,7 +34,6 @@ int ofono_is_data_monitor_running(void);
 /* ==================== 全局变量 ==================== */
 static GDBusConnection *g_dbus_conn = NULL;
 static GDBusProxy *g_modem_proxy = NULL;
-static pthread_mutex_t g_at_mutex = PTHREAD_MUTEX_INITIALIZER;
 static char g_last_error[512] = {0};
 static char g_modem_path[64] = DEFAULT_MODEM_PATH;
 
@@ -137,7 +138,7 @@ static int ensure_connection(void) {
         return 1;
     }
 
-    g_dbus_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    g_dbus_conn = ofono_bus_get(&error);
     if (!g_dbus_conn) {
         if (error) g_error_free(error);
         return 0;
@@ -155,6 +156,52 @@ static int validate_at_command(const char *cmd) {
     return 0;
 }
 
+/* 合并层 D-Bus 调用参数 */
+typedef struct {
+    const char *path;
+    const char *iface;
+    const char *method;
+    const GVariantType *reply_type;
+    int timeout_ms;
+} SharedCall;
+
+static int shared_call_flight(void *arg, void **value) {
+    SharedCall *sc = arg;
+    GError *error = NULL;
+
+    GVariant *ret = g_dbus_connection_call_sync(
+        g_dbus_conn, OFONO_SERVICE, sc->path, sc->iface, sc->method,
+        NULL, sc->reply_type, G_DBUS_CALL_FLAGS_NONE, sc->timeout_ms, NULL, &error
+    );
+    if (!ret) {
+        if (error) g_error_free(error);
+        return -1;
+    }
+    *value = ret;
+    return 0;
+}
+
+/**
+ * 无参数的只读 oFono 调用（GetProperties、GetDataCard 等）
+ * 多个线程同时发起相同调用时只发送一次，共享应答
+ * @return 应答 (调用者需 g_variant_unref)，失败返回 NULL
+ */
+static GVariant *call_shared(const char *path, const char *iface, const char *method,
+                             const GVariantType *reply_type, int timeout_ms) {
+    SharedCall sc = { path, iface, method, reply_type, timeout_ms };
+    GVariant *ret = NULL;
+
+    if (!g_dbus_conn) {
+        return NULL;
+    }
+
+    char *key = g_strdup_printf("dbus:%s|%s|%s", path, iface, method);
+    singleflight_do(key, shared_call_flight, &sc,
+                    (SingleflightCopyFunc)g_variant_ref, (GDestroyNotify)g_variant_unref, (void **)&ret);
+    g_free(key);
+    return ret;
+}
+
 /* ==================== dbus_core.h 接口实现 ==================== */
 
 const char *dbus_get_last_error(void) {
@@ -184,7 +231,7 @@ int init_dbus(void) {
 
     /* 获取系统 D-Bus 连接 */
     if (!g_dbus_conn) {
-        g_dbus_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+        g_dbus_conn = ofono_bus_get(&error);
         if (!g_dbus_conn) {
             set_error("连接系统 D-Bus 失败: %s", error ? error->message : "unknown");
             if (error) g_error_free(error);
@@ -192,17 +239,8 @@ int init_dbus(void) {
         }
     }
 
-    /* 创建 oFono Modem 代理对象 */
-    g_modem_proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn,
-        G_DBUS_PROXY_FLAGS_NONE,
-        NULL,
-        OFONO_SERVICE,
-        g_modem_path,
-        OFONO_MODEM_IFACE,
-        NULL,
-        &error
-    );
+    /* 获取 oFono Modem 代理对象（共享缓存） */
+    g_modem_proxy = ofono_bus_proxy(g_modem_path, OFONO_MODEM_IFACE, &error);
 
     if (!g_modem_proxy) {
         set_error("创建 oFono Modem 代理失败: %s", error ? error->message : "unknown");
@@ -223,15 +261,168 @@ void close_dbus(void) {
         g_object_unref(g_dbus_conn);
         g_dbus_conn = NULL;
     }
+    /* 重新初始化时重建代理 */
+    ofono_bus_invalidate();
     printf("D-Bus 连接已关闭\n");
 }
 
-int execute_at(const char *command, char **result) {
+/* 对 SendAtcmd 的错误分类，决定调度器的重试方式 */
+static AtSendStatus classify_at_error(const GError *error) {
+    if (!error) {
+        return AT_SEND_ERROR;
+    }
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT) ||
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_TIMEOUT) ||
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_NO_REPLY)) {
+        return AT_SEND_TIMEOUT;
+    }
+    if (g_error_matches(error, G_IO_ERROR, G_IO_ERROR_CLOSED) ||
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_SERVICE_UNKNOWN) ||
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_NAME_HAS_NO_OWNER) ||
+        g_error_matches(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_OBJECT) ||
+        strstr(error->message, "connection closed")) {
+        return AT_SEND_DISCONNECTED;
+    }
+    if (strstr(error->message, "Operation already in progress")) {
+        return AT_SEND_BUSY;
+    }
+    return AT_SEND_ERROR;
+}
+
+/**
+ * 调度线程使用的 Modem 路径: 数据卡缓存，未缓存时查询一次
+ * 只使用 ofono_bus 的连接，不访问 g_dbus_conn 等全局变量（这些由主线程管理）
+ */
+static void at_transport_modem_path(char *path, size_t size) {
+    if (ofono_bus_get_datacard(path, size) == 0) {
+        return;
+    }
+    snprintf(path, size, "%s", DEFAULT_MODEM_PATH);
+
+    unsigned int generation = ofono_bus_generation();
+    GDBusConnection *conn = ofono_bus_get(NULL);
+    if (!conn) {
+        return;
+    }
+    GVariant *ret = g_dbus_connection_call_sync(
+        conn, OFONO_SERVICE, "/", "org.ofono.Manager", "GetDataCard",
+        NULL, G_VARIANT_TYPE("(o)"), G_DBUS_CALL_FLAGS_NONE, 5000, NULL, NULL
+    );
+    if (ret) {
+        const gchar *datacard = NULL;
+        g_variant_get(ret, "(&o)", &datacard);
+        if (datacard && datacard[0]) {
+            snprintf(path, size, "%s", datacard);
+            ofono_bus_set_datacard(datacard, generation);
+        }
+        g_variant_unref(ret);
+    }
+    g_object_unref(conn);
+}
+
+/**
+ * AT 调度线程的传输函数: 发送一次，不重试
+ * 错误信息通过 error 返回给调度器，不写 g_last_error
+ */
+static AtSendStatus at_transport_send(const char *command, int timeout_ms, char **result, char **error_text) {
     GError *error = NULL;
     GVariant *ret = NULL;
-    int rc = -1;
-    int retry;
+    AtSendStatus status;
+    char modem_path[64];
+
+    *result = NULL;
+
+    at_transport_modem_path(modem_path, sizeof(modem_path));
+    GDBusProxy *proxy = ofono_bus_proxy(modem_path, OFONO_MODEM_IFACE, &error);
+    if (!proxy) {
+        *error_text = g_strdup_printf("创建 oFono Modem 代理失败: %s", error ? error->message : "unknown");
+        if (error) g_error_free(error);
+        return AT_SEND_DISCONNECTED;
+    }
+
+    printf("准备发送 AT 命令: %s\n", command);
+
+    /* 调用 oFono 的 SendAtcmd 方法 */
+    ret = g_dbus_proxy_call_sync(
+        proxy,
+        "SendAtcmd",
+        g_variant_new("(s)", command),
+        G_DBUS_CALL_FLAGS_NONE,
+        timeout_ms,
+        NULL,
+        &error
+    );
+    g_object_unref(proxy);
+
+    if (!ret) {
+        status = classify_at_error(error);
+        printf("调用 SendAtcmd 失败 (%s): %s\n", command, error ? error->message : "unknown");
+        *error_text = g_strdup_printf("调用 SendAtcmd 失败: %s", error ? error->message : "unknown");
+
+        /* 连接断开或 oFono 重启: 丢弃缓存的代理，下次发送时重建（必要时重新连接） */
+        if (status == AT_SEND_DISCONNECTED) {
+            ofono_bus_invalidate();
+        }
+        if (error) g_error_free(error);
+        return status;
+    }
+
+    /* 提取结果字符串 */
+    const gchar *res_str = NULL;
+    if (g_variant_is_of_type(ret, G_VARIANT_TYPE("(s)"))) {
+        g_variant_get(ret, "(&s)", &res_str);
+    }
+
+    if (res_str) {
+        *result = g_strdup(res_str);
+        g_strstrip(*result);
+        printf("AT 命令 (%s) 响应: %s\n", command, *result);
+        status = AT_SEND_OK;
+    } else {
+        *error_text = g_strdup("空响应");
+        status = AT_SEND_ERROR;
+    }
+
+    g_variant_unref(ret);
+    return status;
+}
+
+/* 经调度器执行 AT 命令，调用前已完成参数校验 */
+static int execute_at_scheduled(const char *command, AtPriority prio, char **result) {
+    char *error = NULL;
+
+    if (at_scheduler_start(at_transport_send) != 0) {
+        set_error("AT 调度器启动失败");
+        return -1;
+    }
+
+    int rc = at_scheduler_run(command, prio, 0, result, &error);
+    if (rc == AT_SCHED_EXPIRED || rc == AT_SCHED_CANCELLED) {
+        set_error("%s: %s", error, command);
+    } else if (rc != AT_SCHED_OK) {
+        /* 在调用线程中记录传输函数返回的错误 */
+        set_error("%s", error ? error : "AT 命令执行失败");
+    }
+    g_free(error);
+    return rc == AT_SCHED_OK ? 0 : -1;
+}
+
+/* 合并层参数 */
+typedef struct {
+    const char *command;
+    AtPriority prio;
+} AtFlightArg;
+
+static int execute_at_flight(void *arg, void **value) {
+    AtFlightArg *a = arg;
+    char *res = NULL;
+    int rc = execute_at_scheduled(a->command, a->prio, &res);
+    *value = res;
+    return rc;
+}
 
+/* 执行 AT 命令: background 为 1 时按后台轮询优先级排队 */
+static int execute_at_prio(const char *command, char **result, int background) {
     if (!command || !result) {
         set_error("无效的参数");
         return -1;
@@ -247,83 +438,112 @@ int execute_at(const char *command, char **result) {
         return -1;
     }
 
-    /* 检查 D-Bus 是否已初始化 */
-    if (!is_dbus_initialized()) {
-        printf("D-Bus 未初始化，尝试初始化...\n");
-        if (init_dbus() != 0) {
-            return -1;
-        }
+    /* 有效期内的只读查询直接返回缓存结果 */
+    if (at_cache_lookup(command, result) == 0) {
+        return 0;
     }
 
-    /* 获取互斥锁，确保串行执行 */
-    pthread_mutex_lock(&g_at_mutex);
+    /* D-Bus 连接由调度线程的传输函数通过 ofono_bus 获取 */
+    if (!at_cache_is_query(command)) {
+        return execute_at_scheduled(command, background ? AT_PRIO_BACKGROUND : AT_PRIO_WRITE, result);
+    }
 
-    printf("准备发送 AT 命令: %s\n", command);
+    /* 只读查询: 并发的相同命令共享同一次 modem 应答 */
+    AtFlightArg arg = { command, background ? AT_PRIO_BACKGROUND : AT_PRIO_READ };
+    char *norm = at_cache_key(command);
+    char *key = g_strdup_printf("at:%d:%s", arg.prio, norm);
+    int rc = singleflight_do(key, execute_at_flight, &arg,
+                             (SingleflightCopyFunc)g_strdup, g_free, (void **)result);
+    g_free(key);
+    g_free(norm);
+    return rc;
+}
 
-    /* 重试逻辑 */
-    for (retry = 0; retry <= MAX_RETRIES; retry++) {
-        error = NULL;
+int execute_at(const char *command, char **result) {
+    return execute_at_prio(command, result, 0);
+}
 
-        /* 调用 oFono 的 SendAtcmd 方法 */
-        ret = g_dbus_proxy_call_sync(
-            g_modem_proxy,
-            "SendAtcmd",
-            g_variant_new("(s)", command),
-            G_DBUS_CALL_FLAGS_NONE,
-            AT_COMMAND_TIMEOUT,
-            NULL,
-            &error
-        );
+int execute_at_background(const char *command, char **result) {
+    return execute_at_prio(command, result, 1);
+}
 
-        if (!ret) {
-            printf("调用 SendAtcmd 失败 (尝试 %d/%d) (%s): %s\n",
-                   retry + 1, MAX_RETRIES + 1, command,
-                   error ? error->message : "unknown");
-
-            /* 检测连接关闭错误 */
-            if (error && strstr(error->message, "connection closed")) {
-                printf("检测到连接关闭，尝试重新初始化 D-Bus...\n");
-                g_error_free(error);
-                close_dbus();
-                if (init_dbus() != 0) {
-                    set_error("重新初始化 D-Bus 失败");
-                    break;
-                }
-                continue;
-            }
+/* ==================== 异步 AT 命令 ==================== */
 
-            /* 检测操作进行中错误 */
-            if (error && strstr(error->message, "Operation already in progress")) {
-                printf("检测到 'Operation already in progress'，500ms 后重试...\n");
-                g_error_free(error);
-                g_usleep(500000);  /* 500ms */
-                continue;
-            }
+typedef struct {
+    AtAsyncCallback callback;
+    void *user_data;
+    int rc;
+    char *result;
+    char *error;
+} AtAsyncCall;
 
-            set_error("调用 SendAtcmd 失败: %s", error ? error->message : "unknown");
-            if (error) g_error_free(error);
-            break;
-        }
+static gboolean at_async_dispatch(gpointer data) {
+    AtAsyncCall *call = data;
+    call->callback(call->rc, call->result, call->error, call->user_data);
+    g_free(call->result);
+    g_free(call->error);
+    g_free(call);
+    return G_SOURCE_REMOVE;
+}
 
-        /* 提取结果字符串 */
-        const gchar *res_str = NULL;
-        g_variant_get(ret, "(s)", &res_str);
+/* 记录结果并投递到主循环 */
+static void at_async_complete(AtAsyncCall *call, int rc, const char *result, const char *error) {
+    call->rc = rc;
+    call->result = g_strdup(result);
+    call->error = rc == 0 ? NULL : g_strdup(error ? error : "unknown");
+    g_idle_add(at_async_dispatch, call);
+}
 
-        if (res_str) {
-            *result = g_strdup(res_str);
-            g_strstrip(*result);
-            printf("AT 命令 (%s) 响应: %s\n", command, *result);
-            rc = 0;
-        } else {
-            set_error("空响应");
-        }
+/* 调度器完成回调（调度线程，或调用取消的线程），错误信息由调度器随结果返回 */
+static void at_async_sched_done(int rc, const char *result, const char *error, void *user_data) {
+    at_async_complete(user_data, rc == AT_SCHED_OK ? 0 : -1, result, error);
+}
 
-        g_variant_unref(ret);
-        break;
+unsigned int execute_at_async(const char *command, AtAsyncCallback callback, void *user_data) {
+    AtAsyncCall *call = g_new0(AtAsyncCall, 1);
+    char *cached = NULL;
+
+    call->callback = callback;
+    call->user_data = user_data;
+
+    if (!command) {
+        at_async_complete(call, -1, NULL, "无效的参数");
+        return 0;
     }
 
-    pthread_mutex_unlock(&g_at_mutex);
-    return rc;
+    /* 去除首尾空白 */
+    while (*command == ' ' || *command == '\t') command++;
+
+    /* 验证 AT 命令格式 */
+    if (!validate_at_command(command)) {
+        at_async_complete(call, -1, NULL, "无效的 AT 命令格式");
+        return 0;
+    }
+
+    /* 有效期内的只读查询直接返回缓存结果 */
+    if (at_cache_lookup(command, &cached) == 0) {
+        at_async_complete(call, 0, cached, NULL);
+        g_free(cached);
+        return 0;
+    }
+
+    /* D-Bus 连接由调度线程的传输函数通过 ofono_bus 获取，这里不做同步调用 */
+    if (at_scheduler_start(at_transport_send) != 0) {
+        at_async_complete(call, -1, NULL, "AT 调度器启动失败");
+        return 0;
+    }
+
+    /* 不经 singleflight：并发的相同查询由调度器合并到同一次发送 */
+    AtPriority prio = at_cache_is_query(command) ? AT_PRIO_READ : AT_PRIO_WRITE;
+    unsigned int id = at_scheduler_submit(command, prio, 0, at_async_sched_done, call);
+    if (id == 0) {
+        at_async_complete(call, -1, NULL, "AT 调度器未运行");
+    }
+    return id;
+}
+
+void execute_at_cancel(unsigned int id) {
+    at_scheduler_cancel(id);
 }
 
 /* ==================== ofono.h 接口实现 ==================== */
@@ -344,9 +564,7 @@ void ofono_deinit(void) {
 }
 
 int ofono_network_get_mode_sync(const char* modem_path, char* buffer, int size, int timeout_ms) {
-    GError *error = NULL;
     GVariant *result = NULL;
-    GDBusProxy *proxy = NULL;
     int ret = -1;
 
     if (!modem_path || !buffer || size <= 0) {
@@ -357,25 +575,9 @@ int ofono_network_get_mode_sync(const char* modem_path, char* buffer, int size,
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, modem_path, OFONO_RADIO_SETTINGS,
-        NULL, &error
-    );
-
-    if (!proxy) {
-        if (error) g_error_free(error);
-        return -1;
-    }
-
-    result = g_dbus_proxy_call_sync(
-        proxy, "GetProperties", NULL,
-        G_DBUS_CALL_FLAGS_NONE, timeout_ms, NULL, &error
-    );
-
+    result = call_shared(modem_path, OFONO_RADIO_SETTINGS, "GetProperties",
+                         G_VARIANT_TYPE("(a{sv})"), timeout_ms);
     if (!result) {
-        if (error) g_error_free(error);
-        g_object_unref(proxy);
         return -1;
     }
 
@@ -403,27 +605,27 @@ int ofono_network_get_mode_sync(const char* modem_path, char* buffer, int size,
     }
 
     g_variant_unref(result);
-    g_object_unref(proxy);
     return ret;
 }
 
 char* ofono_get_datacard(void) {
-    GError *error = NULL;
     GVariant *result = NULL;
     char *datacard_path = NULL;
+    char cached[64];
+
+    /* 数据卡只在切卡时变化，切卡或 oFono 重启时缓存失效 */
+    if (ofono_bus_get_datacard(cached, sizeof(cached)) == 0) {
+        return g_strdup(cached);
+    }
 
     if (!g_dbus_conn) {
         return NULL;
     }
 
-    result = g_dbus_connection_call_sync(
-        g_dbus_conn, OFONO_SERVICE, "/", "org.ofono.Manager",
-        "GetDataCard", NULL, G_VARIANT_TYPE("(o)"),
-        G_DBUS_CALL_FLAGS_NONE, 5000, NULL, &error
-    );
-
+    unsigned int generation = ofono_bus_generation();
+    result = call_shared("/", "org.ofono.Manager", "GetDataCard",
+                         G_VARIANT_TYPE("(o)"), 5000);
     if (!result) {
-        if (error) g_error_free(error);
         return NULL;
     }
 
@@ -431,6 +633,7 @@ char* ofono_get_datacard(void) {
     g_variant_get(result, "(&o)", &path);
     if (path && strlen(path) > 0) {
         datacard_path = g_strdup(path);
+        ofono_bus_set_datacard(path, generation);
     }
 
     g_variant_unref(result);
@@ -480,11 +683,7 @@ int ofono_network_set_mode_sync(const char* modem_path, int mode, int timeout_ms
         return -2;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, modem_path, OFONO_RADIO_SETTINGS,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(modem_path, OFONO_RADIO_SETTINGS, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -517,11 +716,7 @@ int ofono_modem_set_online(const char* modem_path, int online, int timeout_ms) {
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, modem_path, "org.ofono.Modem",
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(modem_path, "org.ofono.Modem", &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -559,6 +754,8 @@ int ofono_set_datacard(const char* modem_path) {
         "SetDataCard", g_variant_new("(o)", modem_path),
         NULL, G_DBUS_CALL_FLAGS_NONE, 5000, NULL, &error
     );
+    /* 超时时切卡也可能已生效，无论结果都重新查询数据卡 */
+    ofono_bus_invalidate();
 
     if (!result) {
         if (error) g_error_free(error);
@@ -570,34 +767,16 @@ int ofono_set_datacard(const char* modem_path) {
 }
 
 int ofono_network_get_signal_strength(const char* modem_path, int* strength, int* dbm, int timeout_ms) {
-    GError *error = NULL;
     GVariant *result = NULL;
-    GDBusProxy *proxy = NULL;
     int ret = -1;
 
     if (!modem_path || !ensure_connection()) {
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, modem_path, "org.ofono.NetworkRegistration",
-        NULL, &error
-    );
-
-    if (!proxy) {
-        if (error) g_error_free(error);
-        return -2;
-    }
-
-    result = g_dbus_proxy_call_sync(
-        proxy, "GetProperties", NULL,
-        G_DBUS_CALL_FLAGS_NONE, timeout_ms, NULL, &error
-    );
-
+    result = call_shared(modem_path, "org.ofono.NetworkRegistration", "GetProperties",
+                         G_VARIANT_TYPE("(a{sv})"), timeout_ms);
     if (!result) {
-        if (error) g_error_free(error);
-        g_object_unref(proxy);
         return -3;
     }
 
@@ -629,7 +808,6 @@ int ofono_network_get_signal_strength(const char* modem_path, int* strength, int
     }
 
     g_variant_unref(result);
-    g_object_unref(proxy);
     return ret;
 }
 
@@ -660,12 +838,8 @@ static int find_internet_context_path(char *path_buf, size_t buf_size) {
         return -1;
     }
 
-    /* 创建 ConnectionManager 代理 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER,
-        NULL, &error
-    );
+    /* 获取 ConnectionManager 代理 */
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1368,11 +1542,7 @@ int ofono_get_data_status(int *active) {
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1427,11 +1597,7 @@ int ofono_set_data_status(int active) {
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1483,11 +1649,7 @@ int ofono_get_roaming_status(int *roaming_allowed, int *is_roaming) {
     *is_roaming = 0;
 
     /* 1. 获取 ConnectionManager 的 RoamingAllowed 属性 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1524,11 +1686,7 @@ int ofono_get_roaming_status(int *roaming_allowed, int *is_roaming) {
     g_object_unref(proxy);
 
     /* 2. 获取 NetworkRegistration 的 Status 属性判断是否漫游中 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_NETWORK_REGISTRATION,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_NETWORK_REGISTRATION, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1577,11 +1735,7 @@ int ofono_set_roaming_allowed(int allowed) {
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1618,12 +1772,8 @@ int ofono_get_all_apn_contexts(ApnContext *contexts, int max_count) {
         return -1;
     }
 
-    /* 创建 ConnectionManager 代理 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER,
-        NULL, &error
-    );
+    /* 获取 ConnectionManager 代理 */
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_CONNECTION_MANAGER, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1720,11 +1870,7 @@ int ofono_set_apn_property(const char *context_path, const char *property, const
         return -1;
     }
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1764,11 +1910,7 @@ int ofono_set_apn_properties(const char *context_path,
     }
 
     /* 1. 检查 context 是否激活 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1797,11 +1939,7 @@ int ofono_set_apn_properties(const char *context_path,
 
     /* 2. 如果激活中，先关闭 */
     if (was_active) {
-        proxy = g_dbus_proxy_new_sync(
-            g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-            OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-            NULL, &error
-        );
+        proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
         if (proxy) {
             result = g_dbus_proxy_call_sync(
                 proxy, "SetProperty",
@@ -1836,11 +1974,7 @@ int ofono_set_apn_properties(const char *context_path,
     /* 4. 如果之前是激活状态，重新激活 */
     if (was_active) {
         g_usleep(500000); /* 500ms */
-        proxy = g_dbus_proxy_new_sync(
-            g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-            OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-            NULL, &error
-        );
+        proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
         if (proxy) {
             result = g_dbus_proxy_call_sync(
                 proxy, "SetProperty",
@@ -1872,12 +2006,8 @@ int ofono_get_serving_cell_tech(char *tech, int size) {
 
     tech[0] = '\0';
 
-    /* 创建 NetworkMonitor 代理 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_NETWORK_MONITOR,
-        NULL, &error
-    );
+    /* 获取 NetworkMonitor 代理 */
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_NETWORK_MONITOR, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -1946,12 +2076,8 @@ int ofono_get_serving_cell_info(char *tech, int tech_size, int *band) {
     tech[0] = '\0';
     *band = 0;
 
-    /* 创建 NetworkMonitor 代理 */
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_NETWORK_MONITOR,
-        NULL, &error
-    );
+    /* 获取 NetworkMonitor 代理 */
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_NETWORK_MONITOR, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -2034,11 +2160,7 @@ int ofono_get_network_status(char *status, int size) {
 
     status[0] = '\0';
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, DEFAULT_MODEM_PATH, OFONO_NETWORK_REGISTRATION,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(DEFAULT_MODEM_PATH, OFONO_NETWORK_REGISTRATION, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -2119,11 +2241,7 @@ int ofono_check_and_restore_data(char *result, int size) {
     GDBusProxy *proxy = NULL;
     char apn[128] = {0};
 
-    proxy = g_dbus_proxy_new_sync(
-        g_dbus_conn, G_DBUS_PROXY_FLAGS_NONE, NULL,
-        OFONO_SERVICE, context_path, OFONO_CONNECTION_CONTEXT,
-        NULL, &error
-    );
+    proxy = ofono_bus_proxy(context_path, OFONO_CONNECTION_CONTEXT, &error);
 
     if (!proxy) {
         if (error) g_error_free(error);
@@ -2638,7 +2756,7 @@ int ofono_start_data_monitor(void) {
     printf("[DataMonitor] 启动数据连接监听...\n");
     
     /* 获取 D-Bus 连接 */
-    g_monitor_dbus_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    g_monitor_dbus_conn = ofono_bus_get(&error);
     if (!g_monitor_dbus_conn) {
         printf("[DataMonitor] 获取 D-Bus 连接失败: %s\n", error ? error->message : "unknown");
         if (error) g_error_free(error);
@@ -0,0 +1,252 @@
+/**
+ * @file ofono_bus.c
+ * @brief 共享的系统 D-Bus 连接和 oFono 代理缓存实现
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "ofono_bus.h"
+#include "ofono.h"
+
+static pthread_mutex_t g_bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GDBusConnection *g_bus_conn = NULL;
+static GHashTable *g_proxies = NULL;        /* "path|iface" -> GDBusProxy* */
+static char g_datacard[64] = {0};
+static unsigned int g_generation = 1;
+static guint g_owner_signal_id = 0;         /* NameOwnerChanged (org.ofono) */
+static guint g_datacard_signal_id = 0;      /* Manager PropertyChanged (DataCard) */
+
+/* 清空代理和数据卡缓存（持锁调用） */
+static void drop_caches_locked(void) {
+    if (g_proxies) {
+        g_hash_table_remove_all(g_proxies);
+    }
+    g_datacard[0] = '\0';
+    g_generation++;
+}
+
+void ofono_bus_invalidate(void) {
+    pthread_mutex_lock(&g_bus_mutex);
+    drop_caches_locked();
+    pthread_mutex_unlock(&g_bus_mutex);
+}
+
+/* oFono 重启后对象和唯一名都会变化，缓存的代理作废 */
+static void on_name_owner_changed(GDBusConnection *conn, const gchar *sender_name,
+    const gchar *object_path, const gchar *interface_name, const gchar *signal_name,
+    GVariant *parameters, gpointer user_data) {
+    (void)conn; (void)sender_name; (void)object_path; (void)interface_name;
+    (void)signal_name; (void)user_data;
+
+    const gchar *name = NULL, *old_owner = NULL, *new_owner = NULL;
+    g_variant_get(parameters, "(&s&s&s)", &name, &old_owner, &new_owner);
+    printf("[OFONO_BUS] %s 所有者变化: '%s' -> '%s'，重建代理\n", name, old_owner, new_owner);
+    ofono_bus_invalidate();
+}
+
+/* 切换数据卡后缓存的数据卡路径作废 */
+static void on_manager_property_changed(GDBusConnection *conn, const gchar *sender_name,
+    const gchar *object_path, const gchar *interface_name, const gchar *signal_name,
+    GVariant *parameters, gpointer user_data) {
+    (void)conn; (void)sender_name; (void)object_path; (void)interface_name;
+    (void)signal_name; (void)user_data;
+
+    if (!g_variant_is_of_type(parameters, G_VARIANT_TYPE("(sv)"))) {
+        return;
+    }
+    const gchar *prop_name = NULL;
+    g_variant_get_child(parameters, 0, "&s", &prop_name);
+    if (g_strcmp0(prop_name, "DataCard") == 0) {
+        ofono_bus_invalidate();
+    }
+}
+
+/* 取消订阅并释放连接（持锁调用） */
+static void release_locked(void) {
+    if (g_bus_conn) {
+        if (g_owner_signal_id) {
+            g_dbus_connection_signal_unsubscribe(g_bus_conn, g_owner_signal_id);
+        }
+        if (g_datacard_signal_id) {
+            g_dbus_connection_signal_unsubscribe(g_bus_conn, g_datacard_signal_id);
+        }
+        g_object_unref(g_bus_conn);
+        g_bus_conn = NULL;
+    }
+    g_owner_signal_id = 0;
+    g_datacard_signal_id = 0;
+    drop_caches_locked();
+}
+
+/**
+ * 订阅失效信号（在默认主上下文中执行）
+ * 订阅绑定调用线程的 thread-default 上下文；采集线程在 dbus_query_group_run_sync
+ * 中压入的私有上下文用完即释放，在那里订阅的信号永远收不到
+ */
+static gboolean subscribe_signals(gpointer data) {
+    GDBusConnection *conn = data;
+
+    pthread_mutex_lock(&g_bus_mutex);
+    if (conn == g_bus_conn && !g_owner_signal_id) {
+        g_owner_signal_id = g_dbus_connection_signal_subscribe(
+            g_bus_conn, "org.freedesktop.DBus", "org.freedesktop.DBus", "NameOwnerChanged",
+            "/org/freedesktop/DBus", OFONO_SERVICE, G_DBUS_SIGNAL_FLAGS_NONE,
+            on_name_owner_changed, NULL, NULL);
+        g_datacard_signal_id = g_dbus_connection_signal_subscribe(
+            g_bus_conn, OFONO_SERVICE, "org.ofono.Manager", "PropertyChanged",
+            "/", NULL, G_DBUS_SIGNAL_FLAGS_NONE,
+            on_manager_property_changed, NULL, NULL);
+    }
+    pthread_mutex_unlock(&g_bus_mutex);
+
+    g_object_unref(conn);
+    return G_SOURCE_REMOVE;
+}
+
+/**
+ * 确保连接可用，必要时重新连接（持锁调用）
+ * 新建连接时 *fresh 置 1，调用者释放锁后须调用 request_subscribe
+ */
+static GDBusConnection *connect_locked(int *fresh, GError **error) {
+    if (g_bus_conn && !g_dbus_connection_is_closed(g_bus_conn)) {
+        return g_bus_conn;
+    }
+    if (g_bus_conn) {
+        printf("[OFONO_BUS] 系统总线连接已断开，重新连接\n");
+        release_locked();
+    }
+
+    g_bus_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, error);
+    if (g_bus_conn) {
+        *fresh = 1;
+    }
+    return g_bus_conn;
+}
+
+/* 在默认主上下文中订阅新连接的信号：本线程能获取默认上下文时立即执行，否则交给主循环（不持锁调用） */
+static void request_subscribe(GDBusConnection *conn) {
+    g_main_context_invoke(NULL, subscribe_signals, g_object_ref(conn));
+}
+
+GDBusConnection *ofono_bus_get(GError **error) {
+    GDBusConnection *conn = NULL;
+    int fresh = 0;
+
+    pthread_mutex_lock(&g_bus_mutex);
+    if (connect_locked(&fresh, error)) {
+        conn = g_object_ref(g_bus_conn);
+    }
+    pthread_mutex_unlock(&g_bus_mutex);
+
+    if (fresh) {
+        request_subscribe(conn);
+    }
+    return conn;
+}
+
+GDBusProxy *ofono_bus_proxy(const char *path, const char *iface, GError **error) {
+    GDBusProxy *proxy = NULL;
+    GDBusConnection *conn = NULL;
+    unsigned int generation;
+    int fresh = 0;
+
+    if (!path || !iface) {
+        return NULL;
+    }
+    char *key = g_strdup_printf("%s|%s", path, iface);
+
+    pthread_mutex_lock(&g_bus_mutex);
+    if (g_proxies && (proxy = g_hash_table_lookup(g_proxies, key))) {
+        g_object_ref(proxy);
+    } else if (connect_locked(&fresh, error)) {
+        conn = g_object_ref(g_bus_conn);
+    }
+    generation = g_generation;
+    pthread_mutex_unlock(&g_bus_mutex);
+
+    if (fresh) {
+        request_subscribe(conn);
+    }
+
+    if (proxy || !conn) {
+        g_free(key);
+        return proxy;
+    }
+
+    /* 创建代理需要一次总线往返，不持锁；oFono 不使用标准属性接口，也不需要代理转发信号 */
+    proxy = g_dbus_proxy_new_sync(
+        conn,
+        G_DBUS_PROXY_FLAGS_DO_NOT_LOAD_PROPERTIES | G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS,
+        NULL, OFONO_SERVICE, path, iface, NULL, error
+    );
+    g_object_unref(conn);
+    if (!proxy) {
+        g_free(key);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&g_bus_mutex);
+    /* 信号订阅生效前收不到失效通知，代理不缓存 */
+    if (generation == g_generation && g_owner_signal_id) {
+        if (!g_proxies) {
+            g_proxies = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_object_unref);
+        }
+        GDBusProxy *existing = g_hash_table_lookup(g_proxies, key);
+        if (existing) {
+            /* 其他线程已创建，使用同一个代理 */
+            g_object_unref(proxy);
+            proxy = g_object_ref(existing);
+        } else {
+            if (g_hash_table_size(g_proxies) >= OFONO_BUS_MAX_PROXIES) {
+                g_hash_table_remove_all(g_proxies);
+            }
+            g_hash_table_insert(g_proxies, key, g_object_ref(proxy));
+            key = NULL;
+        }
+    }
+    pthread_mutex_unlock(&g_bus_mutex);
+
+    g_free(key);
+    return proxy;
+}
+
+unsigned int ofono_bus_generation(void) {
+    pthread_mutex_lock(&g_bus_mutex);
+    unsigned int generation = g_generation;
+    pthread_mutex_unlock(&g_bus_mutex);
+    return generation;
+}
+
+int ofono_bus_get_datacard(char *path, size_t size) {
+    int rc = -1;
+
+    pthread_mutex_lock(&g_bus_mutex);
+    if (g_datacard[0]) {
+        snprintf(path, size, "%s", g_datacard);
+        rc = 0;
+    }
+    pthread_mutex_unlock(&g_bus_mutex);
+    return rc;
+}
+
+void ofono_bus_set_datacard(const char *path, unsigned int generation) {
+    if (!path) return;
+
+    pthread_mutex_lock(&g_bus_mutex);
+    /* 没有连接或信号尚未订阅时收不到变化信号，不缓存 */
+    if (generation == g_generation && g_bus_conn && g_datacard_signal_id) {
+        snprintf(g_datacard, sizeof(g_datacard), "%s", path);
+    }
+    pthread_mutex_unlock(&g_bus_mutex);
+}
+
+void ofono_bus_close(void) {
+    pthread_mutex_lock(&g_bus_mutex);
+    release_locked();
+    if (g_proxies) {
+        g_hash_table_destroy(g_proxies);
+        g_proxies = NULL;
+    }
+    pthread_mutex_unlock(&g_bus_mutex);
+}
@@ -12,6 +12,7 @@
 #include <errno.h>
 #include "mongoose.h"
 #include "plugin.h"
+#include "exec_utils.h"
 #include "lib/json_builder.h"
 
 /* 危险命令黑名单 */
@@ -29,7 +30,7 @@ static const char *dangerous_commands[] = {
 };
 
 /* 检查命令是否安全 */
-static int is_command_safe(const char *cmd) {
+int is_command_safe(const char *cmd) {
     for (int i = 0; dangerous_commands[i] != NULL; i++) {
         if (strstr(cmd, dangerous_commands[i]) != NULL) {
             return 0;
@@ -52,40 +53,14 @@ int ensure_plugin_dir(void) {
     return 0;
 }
 
-/* 执行Shell命令 */
-int execute_shell(const char *cmd, char *output, size_t size) {
-    if (!cmd || !output || size == 0) {
+/* 异步执行Shell命令：与原 popen 实现一样只捕获标准输出，插件按 Data 解析结果 */
+int execute_shell_async(const char *cmd, exec_done_func done, void *user_data) {
+    if (!cmd || !is_command_safe(cmd)) {
         return -1;
     }
 
-    /* 安全检查 */
-    if (!is_command_safe(cmd)) {
-        snprintf(output, size, "Error: Command blocked for security reasons");
-        return -1;
-    }
-
-    FILE *fp = popen(cmd, "r");
-    if (!fp) {
-        snprintf(output, size, "Error: Failed to execute command");
-        return -1;
-    }
-
-    size_t total = 0;
-    char buffer[256];
-    output[0] = '\0';
-
-    while (fgets(buffer, sizeof(buffer), fp) != NULL && total < size - 1) {
-        size_t len = strlen(buffer);
-        if (total + len >= size - 1) {
-            len = size - 1 - total;
-        }
-        memcpy(output + total, buffer, len);
-        total += len;
-    }
-    output[total] = '\0';
-
-    int status = pclose(fp);
-    return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+    return run_command_async_stdout(SHELL_EXEC_TIMEOUT_SEC, SHELL_OUTPUT_MAX, done, user_data,
+                                    "sh", "-c", cmd, NULL);
 }
 
 
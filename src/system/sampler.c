@@ -0,0 +1,438 @@
+/**
+ * @file sampler.c
+ * @brief sysfs/procfs 采样器实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <pthread.h>
+#include "sampler.h"
+
+#define SAMPLER_PATH_MAX  256
+
+/* 持久打开的文件 */
+typedef struct {
+    char path[SAMPLER_PATH_MAX];
+    int fd;
+} SamplerFile;
+
+typedef struct {
+    SamplerFile file;
+    int id;
+    char type[32];
+} SamplerZone;
+
+static pthread_mutex_t g_sampler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int g_sampler_ready = 0;
+static char g_root[SAMPLER_ROOT_MAX];
+
+static SamplerFile g_meminfo;
+static SamplerFile g_stat;
+static SamplerFile g_uptime;
+static SamplerZone g_zones[SAMPLER_MAX_ZONES];
+static int g_zone_count = 0;
+
+/*============================================================================
+ * 整数扫描（不分配内存，不依赖 locale）
+ *============================================================================*/
+
+/**
+ * 跳过非数字字符后解析一个无符号整数
+ * @return 数字之后的位置，没有数字时返回 NULL
+ */
+static const char *scan_u64(const char *p, const char *end, unsigned long long *out) {
+    while (p < end && (*p < '0' || *p > '9')) {
+        if (*p == '\n') return NULL;  /* 不跨行 */
+        p++;
+    }
+    if (p >= end) return NULL;
+
+    unsigned long long v = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        v = v * 10 + (unsigned long long)(*p - '0');
+        p++;
+    }
+    *out = v;
+    return p;
+}
+
+/* 解析可能带负号的整数（温度可能为负） */
+static const char *scan_i64(const char *p, const char *end, long long *out) {
+    while (p < end && *p != '-' && (*p < '0' || *p > '9')) {
+        if (*p == '\n') return NULL;
+        p++;
+    }
+    int neg = (p < end && *p == '-');
+    if (neg) p++;
+
+    unsigned long long v;
+    p = scan_u64(p, end, &v);
+    if (!p) return NULL;
+    *out = neg ? -(long long)v : (long long)v;
+    return p;
+}
+
+/* 移动到下一行开头 */
+static const char *next_line(const char *p, const char *end) {
+    const char *nl = memchr(p, '\n', (size_t)(end - p));
+    return nl ? nl + 1 : end;
+}
+
+/*============================================================================
+ * 文件读取
+ *============================================================================*/
+
+static void file_setup(SamplerFile *f, const char *rel) {
+    snprintf(f->path, sizeof(f->path), "%s%s", g_root, rel);
+    f->fd = open(f->path, O_RDONLY | O_CLOEXEC);
+}
+
+static void file_close(SamplerFile *f) {
+    if (f->fd >= 0) {
+        close(f->fd);
+        f->fd = -1;
+    }
+}
+
+/**
+ * 从偏移0重新读取文件内容，失败时重新打开一次
+ * @return 读取的字节数, -1 失败
+ */
+static ssize_t file_pread(SamplerFile *f, char *buf, size_t size) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (f->fd < 0) {
+            f->fd = open(f->path, O_RDONLY | O_CLOEXEC);
+            if (f->fd < 0) return -1;
+        }
+        ssize_t n;
+        do {
+            n = pread(f->fd, buf, size - 1, 0);
+        } while (n < 0 && errno == EINTR);
+        if (n >= 0) {
+            buf[n] = '\0';
+            return n;
+        }
+        file_close(f);
+    }
+    return -1;
+}
+
+/*============================================================================
+ * 温度传感器发现
+ *============================================================================*/
+
+static void discover_zones(void) {
+    char dir_path[SAMPLER_PATH_MAX];
+    snprintf(dir_path, sizeof(dir_path), "%s/sys/class/thermal", g_root);
+
+    DIR *dir = opendir(dir_path);
+    if (!dir) return;
+
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL && g_zone_count < SAMPLER_MAX_ZONES) {
+        if (strncmp(ent->d_name, "thermal_zone", 12) != 0) continue;
+
+        const char *num = ent->d_name + 12;
+        unsigned long long id;
+        if (!scan_u64(num, num + strlen(num), &id)) continue;
+
+        /* 按编号插入排序，保证输出顺序稳定 */
+        int pos = g_zone_count;
+        while (pos > 0 && g_zones[pos - 1].id > (int)id) {
+            g_zones[pos] = g_zones[pos - 1];
+            pos--;
+        }
+        SamplerZone *z = &g_zones[pos];
+        memset(z, 0, sizeof(*z));
+        z->id = (int)id;
+
+        char rel[96];
+        snprintf(rel, sizeof(rel), "/sys/class/thermal/%.64s/type", ent->d_name);
+        file_setup(&z->file, rel);
+        if (file_pread(&z->file, z->type, sizeof(z->type)) > 0) {
+            z->type[strcspn(z->type, "\n")] = '\0';
+        }
+        file_close(&z->file);
+
+        snprintf(rel, sizeof(rel), "/sys/class/thermal/%.64s/temp", ent->d_name);
+        file_setup(&z->file, rel);
+        g_zone_count++;
+    }
+    closedir(dir);
+}
+
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
+
+static void sampler_close_locked(void) {
+    file_close(&g_meminfo);
+    file_close(&g_stat);
+    file_close(&g_uptime);
+    for (int i = 0; i < g_zone_count; i++) {
+        file_close(&g_zones[i].file);
+    }
+    g_zone_count = 0;
+    g_sampler_ready = 0;
+}
+
+static int sampler_init_locked(const char *root) {
+    if (g_sampler_ready) {
+        sampler_close_locked();
+    }
+
+    snprintf(g_root, sizeof(g_root), "%s", root ? root : SAMPLER_DEFAULT_ROOT);
+    /* 去掉末尾的 '/'，避免拼出 "//proc" */
+    size_t len = strlen(g_root);
+    while (len > 0 && g_root[len - 1] == '/') {
+        g_root[--len] = '\0';
+    }
+
+    file_setup(&g_meminfo, "/proc/meminfo");
+    file_setup(&g_stat, "/proc/stat");
+    file_setup(&g_uptime, "/proc/uptime");
+    discover_zones();
+
+    g_sampler_ready = 1;
+    printf("[SAMPLER] 采样器已初始化, root='%s', 温度传感器 %d 个\n", g_root, g_zone_count);
+    return g_meminfo.fd >= 0 || g_stat.fd >= 0 ? 0 : -1;
+}
+
+/* 首次采样时按默认根目录初始化 */
+static void sampler_ensure_locked(void) {
+    if (!g_sampler_ready) {
+        sampler_init_locked(SAMPLER_DEFAULT_ROOT);
+    }
+}
+
+int sampler_init(const char *root) {
+    pthread_mutex_lock(&g_sampler_mutex);
+    int ret = sampler_init_locked(root);
+    pthread_mutex_unlock(&g_sampler_mutex);
+    return ret;
+}
+
+void sampler_deinit(void) {
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_close_locked();
+    pthread_mutex_unlock(&g_sampler_mutex);
+}
+
+int sampler_read_meminfo(SamplerMeminfo *mem) {
+    char buf[2048];  /* 需要的字段都在前几行 */
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    ssize_t n = file_pread(&g_meminfo, buf, sizeof(buf));
+    pthread_mutex_unlock(&g_sampler_mutex);
+    if (n <= 0) return -1;
+
+    static const struct {
+        const char *key;
+        size_t len;
+        size_t offset;
+    } fields[] = {
+        { "MemTotal:",     9, offsetof(SamplerMeminfo, total) },
+        { "MemFree:",      8, offsetof(SamplerMeminfo, free) },
+        { "MemAvailable:", 13, offsetof(SamplerMeminfo, available) },
+        { "Buffers:",      8, offsetof(SamplerMeminfo, buffers) },
+        { "Cached:",       7, offsetof(SamplerMeminfo, cached) },
+    };
+
+    memset(mem, 0, sizeof(*mem));
+    const char *p = buf, *end = buf + n;
+    int found = 0;
+    while (p < end && found < (int)(sizeof(fields) / sizeof(fields[0]))) {
+        for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+            if ((size_t)(end - p) > fields[i].len && memcmp(p, fields[i].key, fields[i].len) == 0) {
+                unsigned long long *dst = (unsigned long long *)((char *)mem + fields[i].offset);
+                if (scan_u64(p + fields[i].len, end, dst)) found++;
+                break;
+            }
+        }
+        p = next_line(p, end);
+    }
+    return mem->total > 0 ? 0 : -1;
+}
+
+/* 解析 cpu 行 "user nice system idle ..."，缺少的字段为0 */
+static const char *parse_cpu_times(const char *p, const char *end, SamplerCpuTimes *times) {
+    unsigned long long *fields[] = {
+        &times->user, &times->nice, &times->system, &times->idle,
+        &times->iowait, &times->irq, &times->softirq, &times->steal
+    };
+    memset(times, 0, sizeof(*times));
+    int count = 0;
+    for (; count < 8; count++) {
+        const char *q = scan_u64(p, end, fields[count]);
+        if (!q) break;
+        p = q;
+    }
+    return count >= 4 ? p : NULL;
+}
+
+int sampler_read_cpu(SamplerCpuTimes *times) {
+    char buf[256];  /* 只需要第一行 */
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    ssize_t n = file_pread(&g_stat, buf, sizeof(buf));
+    pthread_mutex_unlock(&g_sampler_mutex);
+    if (n <= 4 || memcmp(buf, "cpu ", 4) != 0) return -1;
+
+    /* 格式: cpu  user nice system idle iowait irq softirq steal [guest guest_nice] */
+    return parse_cpu_times(buf + 4, buf + n, times) ? 0 : -1;
+}
+
+int sampler_read_cpu_cores(SamplerCpuTimes *total, SamplerCpuTimes *cores, int max_cores) {
+    char buf[4096];  /* cpu 行都在开头，之后的 intr 等行不需要完整读取 */
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    ssize_t n = file_pread(&g_stat, buf, sizeof(buf));
+    pthread_mutex_unlock(&g_sampler_mutex);
+    if (n <= 4 || memcmp(buf, "cpu ", 4) != 0) return -1;
+
+    const char *end = buf + n;
+    if (!parse_cpu_times(buf + 4, end, total)) return -1;
+
+    int count = 0;
+    for (const char *p = next_line(buf, end); p < end; p = next_line(p, end)) {
+        if ((size_t)(end - p) < 4 || memcmp(p, "cpu", 3) != 0 || p[3] < '0' || p[3] > '9') break;
+
+        unsigned long long id;
+        const char *q = scan_u64(p + 3, end, &id);
+        if (!q || !memchr(q, '\n', (size_t)(end - q))) break;  /* 不完整的行 */
+        if (!cores || (int)id >= max_cores) continue;
+
+        if (parse_cpu_times(q, end, &cores[id])) {
+            if ((int)id + 1 > count) count = (int)id + 1;
+        }
+    }
+    return count;
+}
+
+int sampler_list_pids(int *pids, int max) {
+    char dir_path[SAMPLER_PATH_MAX];
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    snprintf(dir_path, sizeof(dir_path), "%s/proc", g_root);
+    pthread_mutex_unlock(&g_sampler_mutex);
+
+    DIR *dir = opendir(dir_path);
+    if (!dir) return -1;
+
+    int count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL && count < max) {
+        const char *name = ent->d_name;
+        if (name[0] < '1' || name[0] > '9') continue;
+
+        unsigned long long pid;
+        const char *end = name + strlen(name);
+        if (scan_u64(name, end, &pid) != end) continue;
+        pids[count++] = (int)pid;
+    }
+    closedir(dir);
+    return count;
+}
+
+int sampler_read_proc_stat(int pid, SamplerProcStat *st) {
+    char path[SAMPLER_PATH_MAX];
+    char buf[512];
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    snprintf(path, sizeof(path), "%s/proc/%d/stat", g_root, pid);
+    pthread_mutex_unlock(&g_sampler_mutex);
+
+    SamplerFile f = { .fd = -1 };
+    snprintf(f.path, sizeof(f.path), "%s", path);
+    ssize_t n = file_pread(&f, buf, sizeof(buf));
+    file_close(&f);
+    if (n <= 0) return -1;
+
+    /* 格式: pid (comm) state ppid ...，comm 中可能含空格和括号，取最后一个 ')' */
+    const char *end = buf + n;
+    const char *lp = memchr(buf, '(', (size_t)n);
+    const char *rp = NULL;
+    for (const char *p = end - 1; p > buf; p--) {
+        if (*p == ')') {
+            rp = p;
+            break;
+        }
+    }
+    if (!lp || !rp || rp < lp || end - rp < 4) return -1;
+
+    memset(st, 0, sizeof(*st));
+    st->pid = pid;
+    size_t len = (size_t)(rp - lp - 1);
+    if (len >= sizeof(st->comm)) len = sizeof(st->comm) - 1;
+    memcpy(st->comm, lp + 1, len);
+
+    /* 从 ppid（第4个字段）开始依次扫描: utime=14, stime=15, starttime=22 */
+    const char *p = rp + 3;
+    for (int field = 4; field <= 22; field++) {
+        unsigned long long v;
+        p = scan_u64(p, end, &v);
+        if (!p) return -1;
+        if (field == 14) st->utime = v;
+        else if (field == 15) st->stime = v;
+        else if (field == 22) st->starttime = v;
+    }
+    return 0;
+}
+
+int sampler_read_uptime(double *uptime) {
+    char buf[64];
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    ssize_t n = file_pread(&g_uptime, buf, sizeof(buf));
+    pthread_mutex_unlock(&g_sampler_mutex);
+    if (n <= 0) return -1;
+
+    /* 格式: 12345.67 23456.78 */
+    unsigned long long sec, frac = 0;
+    const char *end = buf + n;
+    const char *p = scan_u64(buf, end, &sec);
+    if (!p) return -1;
+    if (p < end && *p == '.' && p + 1 < end && p[1] >= '0' && p[1] <= '9') {
+        const char *q = scan_u64(p + 1, end, &frac);
+        double scale = 1.0;
+        for (const char *d = p + 1; d < q; d++) scale *= 10.0;
+        *uptime = (double)sec + (double)frac / scale;
+    } else {
+        *uptime = (double)sec;
+    }
+    return 0;
+}
+
+int sampler_read_thermal(SamplerThermalZone *zones, int max) {
+    char buf[32];
+    int count = 0;
+
+    pthread_mutex_lock(&g_sampler_mutex);
+    sampler_ensure_locked();
+    for (int i = 0; i < g_zone_count && count < max; i++) {
+        ssize_t n = file_pread(&g_zones[i].file, buf, sizeof(buf));
+        long long temp;
+        if (n <= 0 || !scan_i64(buf, buf + n, &temp)) continue;
+
+        zones[count].id = g_zones[i].id;
+        memcpy(zones[count].type, g_zones[i].type, sizeof(zones[count].type));
+        zones[count].temp_milli = (int)temp;
+        count++;
+    }
+    int total = g_zone_count;
+    pthread_mutex_unlock(&g_sampler_mutex);
+
+    return total > 0 ? count : -1;
+}
@@ -173,3 +173,41 @@ void sha256_hash_string(const char *str, char *hex_out)
 {
     sha256_hash_data((const uint8_t *)str, strlen(str), hex_out);
 }
+
+void sha256_hmac(const uint8_t *key, size_t key_len,
+                 const uint8_t *data, size_t len, uint8_t *mac)
+{
+    SHA256_CTX ctx;
+    uint8_t k_pad[64];
+    uint8_t key_hash[SHA256_BLOCK_SIZE];
+    uint8_t inner[SHA256_BLOCK_SIZE];
+
+    /* 超过块长度的密钥先做一次哈希 */
+    if (key_len > sizeof(k_pad)) {
+        sha256_init(&ctx);
+        sha256_update(&ctx, key, key_len);
+        sha256_final(&ctx, key_hash);
+        key = key_hash;
+        key_len = SHA256_BLOCK_SIZE;
+    }
+
+    /* 内层: H((K ^ ipad) || data) */
+    memset(k_pad, 0x36, sizeof(k_pad));
+    for (size_t i = 0; i < key_len; i++) {
+        k_pad[i] ^= key[i];
+    }
+    sha256_init(&ctx);
+    sha256_update(&ctx, k_pad, sizeof(k_pad));
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, inner);
+
+    /* 外层: H((K ^ opad) || inner) */
+    memset(k_pad, 0x5c, sizeof(k_pad));
+    for (size_t i = 0; i < key_len; i++) {
+        k_pad[i] ^= key[i];
+    }
+    sha256_init(&ctx);
+    sha256_update(&ctx, k_pad, sizeof(k_pad));
+    sha256_update(&ctx, inner, sizeof(inner));
+    sha256_final(&ctx, mac);
+}
@@ -0,0 +1,87 @@
+/**
+ * @file singleflight.c
+ * @brief 相同查询的并发合并实现
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+#include "singleflight.h"
+
+typedef struct {
+    int refs;               /* 执行者 + 等待者 */
+    int done;
+    int rc;
+    gpointer value;         /* 供等待者复制的共享结果 */
+    GDestroyNotify destroy;
+    pthread_cond_t cond;
+} Flight;
+
+static pthread_mutex_t g_flight_mutex = PTHREAD_MUTEX_INITIALIZER;
+static GHashTable *g_flights = NULL;    /* key -> 进行中的 Flight */
+
+/* 释放一个引用（调用时已持有锁） */
+static void flight_unref(Flight *f) {
+    if (--f->refs > 0) {
+        return;
+    }
+    if (f->value && f->destroy) {
+        f->destroy(f->value);
+    }
+    pthread_cond_destroy(&f->cond);
+    g_free(f);
+}
+
+int singleflight_do(const char *key, SingleflightFunc fn, void *arg,
+                    SingleflightCopyFunc copy, GDestroyNotify destroy, void **value) {
+    void *result = NULL;
+    int rc;
+
+    *value = NULL;
+
+    pthread_mutex_lock(&g_flight_mutex);
+    if (!g_flights) {
+        g_flights = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    }
+
+    Flight *f = g_hash_table_lookup(g_flights, key);
+    if (f) {
+        /* 已有相同查询在执行，等待其结果 */
+        f->refs++;
+        printf("[SINGLEFLIGHT] 合并到进行中的查询: %s (等待者 %d)\n", key, f->refs - 1);
+        while (!f->done) {
+            pthread_cond_wait(&f->cond, &g_flight_mutex);
+        }
+        rc = f->rc;
+        if (f->value) {
+            *value = copy(f->value);
+        }
+        flight_unref(f);
+        pthread_mutex_unlock(&g_flight_mutex);
+        return rc;
+    }
+
+    f = g_new0(Flight, 1);
+    f->refs = 1;
+    f->destroy = destroy;
+    pthread_cond_init(&f->cond, NULL);
+    g_hash_table_insert(g_flights, g_strdup(key), f);
+    pthread_mutex_unlock(&g_flight_mutex);
+
+    rc = fn(arg, &result);
+
+    pthread_mutex_lock(&g_flight_mutex);
+    g_hash_table_remove(g_flights, key);
+    f->done = 1;
+    f->rc = rc;
+    if (f->refs > 1) {
+        if (result) {
+            f->value = copy(result);
+        }
+        pthread_cond_broadcast(&f->cond);
+    }
+    flight_unref(f);
+    pthread_mutex_unlock(&g_flight_mutex);
+
+    *value = result;
+    return rc;
+}
@@ -6,11 +6,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <pthread.h>
 #include <gio/gio.h>
 #include "sms.h"
 #include "database.h"
 #include "exec_utils.h"
+#include "db_worker.h"
+#include "ofono_bus.h"
 
 /* 短信模块专用互斥锁 */
 static pthread_mutex_t g_sms_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -43,57 +46,25 @@ static void on_ofono_appeared(GDBusConnection *conn, const gchar *name, const gc
 static void on_ofono_vanished(GDBusConnection *conn, const gchar *name, gpointer user_data);
 static void apply_sms_fix_on_init(void);
 
-/* Hex解码函数 - 将hex字符串解码为原始字节 */
-static void hex_decode(const char *hex, char *out, size_t out_size) {
-    size_t i = 0, j = 0;
-    size_t hex_len = strlen(hex);
-    
-    while (i < hex_len && j < out_size - 1) {
-        unsigned int byte;
-        if (sscanf(hex + i, "%2x", &byte) == 1) {
-            out[j++] = (char)byte;
-            i += 2;
-        } else {
-            break;
-        }
-    }
-    out[j] = '\0';
-}
-
 /* 保存短信到数据库 */
 static int save_sms_to_db(const char *sender, const char *content, time_t timestamp) {
-    char sql[2048];
-    char escaped_content[1024];
-    
-    /* 转义单引号 */
-    size_t j = 0;
-    for (size_t i = 0; content[i] && j < sizeof(escaped_content) - 2; i++) {
-        if (content[i] == '\'') {
-            escaped_content[j++] = '\'';
-            escaped_content[j++] = '\'';
-        } else {
-            escaped_content[j++] = content[i];
-        }
+    int ret = -1;
+    
+    /* 在数据库线程执行，由数据库锁串行化；不能再取 g_sms_mutex，
+     * 主线程的删除/设置操作是先取 g_sms_mutex 再取数据库锁 */
+    db_stmt *st = db_prepare_cached("sms_insert",
+        "INSERT INTO sms (sender, content, timestamp, is_read) VALUES (?1, ?2, ?3, 0);");
+    if (st) {
+        db_bind_text(st, 1, sender);
+        db_bind_text(st, 2, content);
+        db_bind_int64(st, 3, (long long)timestamp);
+        ret = db_step(st) == DB_DONE ? 0 : -1;
+        db_finalize(st);
     }
-    escaped_content[j] = '\0';
-    
-    snprintf(sql, sizeof(sql),
-        "INSERT INTO sms (sender, content, timestamp, is_read) VALUES ('%s', '%s', %ld, 0);",
-        sender, escaped_content, (long)timestamp);
     
-    pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_execute(sql);
-    pthread_mutex_unlock(&g_sms_mutex);
-    
-    /* 清理超出限制的旧短信 */
+    /* 超出限制的旧短信由 trg_sms_retention 触发器在插入时删除 */
     if (ret == 0) {
         printf("[SMS] 短信保存成功，当前最大限制: %d\n", g_max_sms_count);
-        snprintf(sql, sizeof(sql),
-            "DELETE FROM sms WHERE id NOT IN (SELECT id FROM sms ORDER BY id DESC LIMIT %d);",
-            g_max_sms_count);
-        pthread_mutex_lock(&g_sms_mutex);
-        db_execute(sql);
-        pthread_mutex_unlock(&g_sms_mutex);
     } else {
         printf("[SMS] 短信保存失败!\n");
     }
@@ -101,6 +72,62 @@ static int save_sms_to_db(const char *sender, const char *content, time_t timest
     return ret;
 }
 
+/* 异步写库任务 - 在数据库线程执行，避免阻塞D-Bus信号处理和HTTP请求 */
+typedef struct {
+    char *peer;         /* 发件人或收件人 */
+    char *content;
+    time_t timestamp;
+} SmsSaveJob;
+
+static SmsSaveJob *sms_save_job_new(const char *peer, const char *content, time_t timestamp) {
+    SmsSaveJob *job = g_new0(SmsSaveJob, 1);
+    job->peer = g_strdup(peer);
+    job->content = g_strdup(content);
+    job->timestamp = timestamp;
+    return job;
+}
+
+static void sms_save_job_free(SmsSaveJob *job) {
+    g_free(job->peer);
+    g_free(job->content);
+    g_free(job);
+}
+
+static int save_incoming_job(void *arg) {
+    SmsSaveJob *job = (SmsSaveJob *)arg;
+    return save_sms_to_db(job->peer, job->content, job->timestamp);
+}
+
+/* 入库完成（主循环） - 已提交后再转发Webhook */
+static void save_incoming_done(int result, void *arg) {
+    SmsSaveJob *job = (SmsSaveJob *)arg;
+    
+    if (result == 0) {
+        printf("[SMS] 短信已保存到数据库\n");
+        
+        /* 发送Webhook通知 */
+        if (g_webhook_config.enabled && strlen(g_webhook_config.url) > 0) {
+            SmsMessage msg = {0};
+            strncpy(msg.sender, job->peer, sizeof(msg.sender) - 1);
+            strncpy(msg.content, job->content, sizeof(msg.content) - 1);
+            msg.timestamp = job->timestamp;
+            send_webhook_notification(&msg);
+        }
+    }
+    
+    sms_save_job_free(job);
+}
+
+static int save_sent_job(void *arg) {
+    SmsSaveJob *job = (SmsSaveJob *)arg;
+    return save_sent_sms_to_db(job->peer, job->content, job->timestamp, "sent");
+}
+
+static void save_sent_done(int result, void *arg) {
+    (void)result;
+    sms_save_job_free((SmsSaveJob *)arg);
+}
+
 /* 订阅短信信号 */
 static void subscribe_sms_signal(void) {
     if (!g_sms_dbus_conn) {
@@ -231,19 +258,11 @@ static void on_incoming_message(GDBusConnection *conn, const gchar *sender_name,
     
     printf("[SMS] 新短信 - 发件人: %s, 内容: %s\n", sender, content);
     
-    /* 保存到数据库 */
-    time_t now = time(NULL);
-    if (save_sms_to_db(sender, content, now) == 0) {
-        printf("[SMS] 短信已保存到数据库\n");
-        
-        /* 发送Webhook通知 */
-        if (g_webhook_config.enabled && strlen(g_webhook_config.url) > 0) {
-            SmsMessage msg = {0};
-            strncpy(msg.sender, sender, sizeof(msg.sender) - 1);
-            strncpy(msg.content, content, sizeof(msg.content) - 1);
-            msg.timestamp = now;
-            send_webhook_notification(&msg);
-        }
+    /* 保存到数据库（异步），入库完成后转发Webhook */
+    SmsSaveJob *job = sms_save_job_new(sender, content, time(NULL));
+    if (db_submit(DB_JOB_WRITE, save_incoming_job, save_incoming_done, job) != 0) {
+        /* 队列已满时同步写入，短信不能丢 */
+        save_incoming_done(save_incoming_job(job), job);
     }
     
     g_variant_unref(props);
@@ -366,7 +385,7 @@ int sms_init(const char *db_path) {
     sms_get_webhook_config(&g_webhook_config);
     
     /* 连接D-Bus */
-    g_sms_dbus_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+    g_sms_dbus_conn = ofono_bus_get(&error);
     if (!g_sms_dbus_conn) {
         printf("[SMS] D-Bus连接失败: %s\n", error ? error->message : "未知错误");
         if (error) g_error_free(error);
@@ -474,93 +493,276 @@ int sms_send(const char *recipient, const char *content, char *result_path, size
     printf("[SMS] 短信发送成功，路径: %s\n", path ? path : "N/A");
     g_variant_unref(result);
     
-    /* 保存发送记录到数据库 */
-    save_sent_sms_to_db(recipient, content, time(NULL), "sent");
+    /* 保存发送记录到数据库（异步） */
+    SmsSaveJob *job = sms_save_job_new(recipient, content, time(NULL));
+    if (db_submit(DB_JOB_WRITE, save_sent_job, save_sent_done, job) != 0) {
+        save_sent_done(save_sent_job(job), job);
+    }
     
     return 0;
 }
 
-/* 获取短信列表 - 使用hex编码避免特殊字符问题，兼容无JSON扩展的SQLite */
-int sms_get_list(SmsMessage *messages, int max_count) {
-    char sql[512];
-    char *output = NULL;
+/* 短信列表填充上下文 */
+typedef struct {
+    void *messages;
+    int max_count;
+    int count;
+} SmsListCtx;
+
+/* 行回调 - 列: id, sender, content, timestamp, is_read */
+static int sms_row_cb(db_stmt *row, void *user_data) {
+    SmsListCtx *ctx = (SmsListCtx *)user_data;
+    SmsMessage *msg = &((SmsMessage *)ctx->messages)[ctx->count++];
+    
+    msg->id = db_column_int(row, 0);
+    db_column_copy(row, 1, msg->sender, sizeof(msg->sender));
+    db_column_copy(row, 2, msg->content, sizeof(msg->content));
+    msg->timestamp = (time_t)db_column_int64(row, 3);
+    msg->is_read = db_column_int(row, 4);
+    
+    return ctx->count >= ctx->max_count;
+}
+
+/* 按 id 倒序查询短信，SQL 中 ?1 为边界ID，?2 为条数 */
+static int sms_query_page(const char *key, const char *sql, int boundary_id,
+                          SmsMessage *messages, int max_count) {
+    SmsListCtx ctx = { messages, max_count, 0 };
+    int ret = 0;
     
     if (!messages || max_count <= 0) return -1;
     
-    /* 分配大缓冲区 */
-    output = (char *)malloc(256 * 1024);
-    if (!output) return -1;
+    pthread_mutex_lock(&g_sms_mutex);
+    db_stmt *st = db_prepare_cached(key, sql);
+    if (!st) {
+        ret = -1;
+    } else {
+        db_bind_int(st, 1, boundary_id);
+        db_bind_int(st, 2, max_count);
+        if (db_foreach(st, sms_row_cb, &ctx) < 0) {
+            printf("[SMS] 获取短信列表失败\n");
+            ret = -1;
+        }
+        db_finalize(st);
+    }
+    pthread_mutex_unlock(&g_sms_mutex);
     
-    /* 使用hex编码content字段，用|分隔，每行一条记录 */
-    snprintf(sql, sizeof(sql),
-        "SELECT id || '|' || sender || '|' || hex(content) || '|' || timestamp || '|' || is_read FROM sms ORDER BY id DESC LIMIT %d;",
-        max_count);
+    return ret < 0 ? -1 : ctx.count;
+}
+
+/* 获取短信列表 */
+int sms_get_list(SmsMessage *messages, int max_count) {
+    int count = sms_get_page(0, messages, max_count);
+    if (count >= 0) {
+        printf("[SMS] 获取到 %d 条短信\n", count);
+    }
+    return count;
+}
+
+/* 分页获取 id 小于 before_id 的短信 */
+int sms_get_page(int before_id, SmsMessage *messages, int max_count) {
+    return sms_query_page("sms_page",
+        "SELECT id, sender, content, timestamp, is_read FROM sms "
+        "WHERE id < ?1 ORDER BY id DESC LIMIT ?2;",
+        before_id > 0 ? before_id : INT_MAX, messages, max_count);
+}
+
+/* 获取 id 大于 since_id 的新短信 */
+int sms_get_since(int since_id, SmsMessage *messages, int max_count) {
+    return sms_query_page("sms_since",
+        "SELECT id, sender, content, timestamp, is_read FROM sms "
+        "WHERE id > ?1 ORDER BY id DESC LIMIT ?2;",
+        since_id > 0 ? since_id : 0, messages, max_count);
+}
+
+/* 获取收件箱统计 */
+int sms_get_stats(SmsStats *stats) {
+    int ret = -1;
+    
+    if (!stats) return -1;
+    memset(stats, 0, sizeof(SmsStats));
     
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_query_string(sql, output, 256 * 1024);
+    db_stmt *st = db_prepare_cached("sms_stats",
+        "SELECT COUNT(*), COALESCE(SUM(is_read = 0), 0), COALESCE(MIN(id), 0), COALESCE(MAX(id), 0) FROM sms;");
+    if (st && db_step(st) == DB_ROW) {
+        stats->total = db_column_int(st, 0);
+        stats->unread = db_column_int(st, 1);
+        stats->oldest_id = db_column_int(st, 2);
+        stats->latest_id = db_column_int(st, 3);
+        ret = 0;
+    }
+    db_finalize(st);
     pthread_mutex_unlock(&g_sms_mutex);
     
-    if (ret != 0 || strlen(output) == 0) {
-        printf("[SMS] 获取短信列表失败或为空\n");
-        free(output);
-        return 0;
+    return ret;
+}
+
+/*============================================================================
+ * 短信搜索
+ *============================================================================*/
+
+/* 搜索方式，由数据库迁移时系统 libsqlite3 支持的全文索引决定 */
+#define SEARCH_UNKNOWN  0
+#define SEARCH_TRIGRAM  1   /* fts5 trigram: 支持任意子串（至少3个字符） */
+#define SEARCH_FTS5     2   /* fts5 unicode61: 按词和前缀匹配，bm25排序 */
+#define SEARCH_FTS4     3   /* fts4: 按词和前缀匹配，按时间排序 */
+#define SEARCH_LIKE     4   /* 无全文索引：LIKE 全表扫描 */
+
+static int g_search_engine = SEARCH_UNKNOWN;
+
+static int detect_search_engine(void) {
+    char sql[256] = {0};
+    
+    if (g_search_engine != SEARCH_UNKNOWN) {
+        return g_search_engine;
     }
     
-    /* 解析输出 - 格式: id|sender|hex_content|timestamp|is_read\n */
-    int count = 0;
-    char *line = output;
-    char *next_line;
-    
-    while (line && *line && count < max_count) {
-        /* 找到行尾 */
-        next_line = strchr(line, '\n');
-        if (next_line) {
-            *next_line = '\0';
-            next_line++;
+    db_query_string("SELECT sql FROM sqlite_master WHERE name = 'sms_fts';", sql, sizeof(sql));
+    if (strstr(sql, "trigram")) g_search_engine = SEARCH_TRIGRAM;
+    else if (strstr(sql, "fts5")) g_search_engine = SEARCH_FTS5;
+    else if (strstr(sql, "fts4")) g_search_engine = SEARCH_FTS4;
+    else g_search_engine = SEARCH_LIKE;
+    
+    return g_search_engine;
+}
+
+static const char *search_engine_name(int engine) {
+    switch (engine) {
+        case SEARCH_TRIGRAM: return "fts5-trigram";
+        case SEARCH_FTS5:    return "fts5";
+        case SEARCH_FTS4:    return "fts4";
+        default:             return "like";
+    }
+}
+
+const char *sms_search_engine(void) {
+    pthread_mutex_lock(&g_sms_mutex);
+    int engine = detect_search_engine();
+    pthread_mutex_unlock(&g_sms_mutex);
+    
+    return search_engine_name(engine);
+}
+
+/* UTF-8 字符数 */
+static int utf8_char_count(const char *s) {
+    int n = 0;
+    for (; *s; s++) {
+        if (((unsigned char)*s & 0xC0) != 0x80) n++;
+    }
+    return n;
+}
+
+/* 是否含非 ASCII 字符 */
+static int has_non_ascii(const char *s) {
+    for (; *s; s++) {
+        if ((unsigned char)*s & 0x80) return 1;
+    }
+    return 0;
+}
+
+/* 拼接单个收件箱/发件箱的查询分支 */
+static void append_search_branch(GString *sql, int engine, int box) {
+    const char *table = box == SMS_BOX_SENT ? "sent_sms" : "sms";
+    const char *peer = box == SMS_BOX_SENT ? "recipient" : "sender";
+    
+    if (sql->len > 0) {
+        g_string_append(sql, " UNION ALL ");
+    }
+    
+    if (engine == SEARCH_LIKE) {
+        g_string_append_printf(sql,
+            "SELECT %d, id, %s, content, timestamp, 0.0 FROM %s "
+            "WHERE content LIKE ?1 ESCAPE '\\' OR %s LIKE ?1 ESCAPE '\\'",
+            box, peer, table, peer);
+    } else {
+        /* bm25 越小越相关；fts4 没有内置相关度函数 */
+        char rank[32] = "0.0";
+        if (engine != SEARCH_FTS4) {
+            snprintf(rank, sizeof(rank), "bm25(%s_fts)", table);
         }
-        
-        /* 跳过空行 */
-        if (strlen(line) == 0) {
-            line = next_line;
-            continue;
+        g_string_append_printf(sql,
+            "SELECT %d, s.id, s.%s, s.content, s.timestamp, %s FROM %s_fts "
+            "JOIN %s s ON s.id = %s_fts.rowid WHERE %s_fts MATCH ?1",
+            box, peer, rank, table, table, table, table);
+    }
+}
+
+int sms_search(const char *query, int box, int offset,
+               SmsSearchHit *hits, int max_count, const char **engine_used) {
+    int count = 0;
+    
+    if (!query || !hits || max_count <= 0 || offset < 0 || strlen(query) == 0) {
+        return -1;
+    }
+    if (!(box & SMS_BOX_ALL)) {
+        box = SMS_BOX_ALL;
+    }
+    
+    pthread_mutex_lock(&g_sms_mutex);
+    
+    int engine = detect_search_engine();
+    
+    /* trigram 不能匹配少于3个字符的查询；unicode61 分词把连续的中文当作一个词，
+     * 无法匹配词中的子串（"验证码" 搜不到 "您的验证码是"），非 ASCII 查询改用 LIKE */
+    if (engine == SEARCH_TRIGRAM && utf8_char_count(query) < 3) {
+        engine = SEARCH_LIKE;
+    } else if (engine != SEARCH_TRIGRAM && has_non_ascii(query)) {
+        engine = SEARCH_LIKE;
+    }
+    if (engine_used) {
+        *engine_used = search_engine_name(engine);
+    }
+    
+    /* 查询词：全文索引按短语匹配（非 trigram 时加前缀匹配），LIKE 转义通配符 */
+    GString *pattern = g_string_new(NULL);
+    if (engine == SEARCH_LIKE) {
+        g_string_append_c(pattern, '%');
+        for (const char *p = query; *p; p++) {
+            if (*p == '%' || *p == '_' || *p == '\\') g_string_append_c(pattern, '\\');
+            g_string_append_c(pattern, *p);
         }
-        
-        /* 解析字段: id|sender|hex_content|timestamp|is_read */
-        char *fields[5] = {NULL};
-        int field_count = 0;
-        char *p = line;
-        char *field_start = p;
-        
-        while (*p && field_count < 5) {
-            if (*p == '|') {
-                *p = '\0';
-                fields[field_count++] = field_start;
-                field_start = p + 1;
-            }
-            p++;
+        g_string_append_c(pattern, '%');
+    } else {
+        g_string_append_c(pattern, '"');
+        for (const char *p = query; *p; p++) {
+            if (*p == '"') g_string_append_c(pattern, '"');
+            g_string_append_c(pattern, *p);
         }
-        if (field_count < 5 && field_start) {
-            fields[field_count++] = field_start;
+        g_string_append(pattern, engine == SEARCH_TRIGRAM ? "\"" : "\"*");
+    }
+    
+    GString *sql = g_string_new(NULL);
+    if (box & SMS_BOX_INBOX) append_search_branch(sql, engine, SMS_BOX_INBOX);
+    if (box & SMS_BOX_SENT) append_search_branch(sql, engine, SMS_BOX_SENT);
+    g_string_append(sql, " ORDER BY 6, 5 DESC, 2 DESC LIMIT ?2 OFFSET ?3;");
+    
+    db_stmt *st = db_prepare(sql->str);
+    if (!st) {
+        count = -1;
+    } else {
+        db_bind_text(st, 1, pattern->str);
+        db_bind_int(st, 2, max_count);
+        db_bind_int(st, 3, offset);
+        int rc;
+        while (count < max_count && (rc = db_step(st)) == DB_ROW) {
+            SmsSearchHit *hit = &hits[count++];
+            hit->box = db_column_int(st, 0);
+            hit->id = db_column_int(st, 1);
+            db_column_copy(st, 2, hit->peer, sizeof(hit->peer));
+            db_column_copy(st, 3, hit->content, sizeof(hit->content));
+            hit->timestamp = (time_t)db_column_int64(st, 4);
         }
-        
-        if (field_count >= 5) {
-            messages[count].id = atoi(fields[0]);
-            strncpy(messages[count].sender, fields[1], sizeof(messages[count].sender) - 1);
-            messages[count].sender[sizeof(messages[count].sender) - 1] = '\0';
-            
-            /* hex解码content */
-            hex_decode(fields[2], messages[count].content, sizeof(messages[count].content));
-            
-            messages[count].timestamp = (time_t)atol(fields[3]);
-            messages[count].is_read = atoi(fields[4]);
-            count++;
+        if (count < max_count && rc == DB_ERROR) {
+            printf("[SMS] 搜索失败: %s\n", query);
+            count = -1;
         }
-        
-        line = next_line;
+        db_finalize(st);
     }
     
-    free(output);
-    printf("[SMS] 获取到 %d 条短信\n", count);
+    pthread_mutex_unlock(&g_sms_mutex);
+    g_string_free(sql, TRUE);
+    g_string_free(pattern, TRUE);
+    
     return count;
 }
 
@@ -592,84 +794,66 @@ int sms_clear_all(void) {
 
 /* 获取Webhook配置 */
 int sms_get_webhook_config(WebhookConfig *config) {
-    char output[4096];
+    int found = 0;
     
     if (!config) return -1;
     
     memset(config, 0, sizeof(WebhookConfig));
     
-    const char *sql = "SELECT enabled, platform, url, body, headers FROM webhook_config WHERE id = 1;";
-    
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_query_rows(sql, "|", output, sizeof(output));
+    db_stmt *st = db_prepare("SELECT enabled, platform, url, body, headers FROM webhook_config WHERE id = 1;");
+    if (st && db_step(st) == DB_ROW) {
+        config->enabled = db_column_int(st, 0);
+        db_column_copy(st, 1, config->platform, sizeof(config->platform));
+        db_column_copy(st, 2, config->url, sizeof(config->url));
+        db_column_copy(st, 3, config->body, sizeof(config->body));
+        db_column_copy(st, 4, config->headers, sizeof(config->headers));
+        found = 1;
+    }
+    db_finalize(st);
     pthread_mutex_unlock(&g_sms_mutex);
     
-    if (ret != 0 || strlen(output) == 0) {
+    if (!found) {
         /* 使用默认配置 */
         config->enabled = 0;
         strcpy(config->platform, "pushplus");
         return 0;
     }
     
-    /* 解析输出 */
-    char *fields[5] = {NULL};
-    int field_count = 0;
-    char *p = output;
-    char *start = p;
-    
-    while (*p && field_count < 5) {
-        if (*p == '|') {
-            *p = '\0';
-            fields[field_count++] = start;
-            start = p + 1;
-        }
-        p++;
-    }
-    if (field_count < 5 && start) {
-        fields[field_count++] = start;
-    }
-    
-    if (field_count >= 5) {
-        config->enabled = atoi(fields[0]);
-        strncpy(config->platform, fields[1], sizeof(config->platform) - 1);
-        strncpy(config->url, fields[2], sizeof(config->url) - 1);
-        strncpy(config->body, fields[3], sizeof(config->body) - 1);
-        strncpy(config->headers, fields[4], sizeof(config->headers) - 1);
-        
-        /* 去除末尾换行符 */
-        char *nl = strchr(config->headers, '\n');
-        if (nl) *nl = '\0';
-        
-        /* 反转义特殊字符 */
-        db_unescape_string(config->url);
-        db_unescape_string(config->body);
-        db_unescape_string(config->headers);
-    }
+    /* 反转义特殊字符 */
+    db_unescape_string(config->url);
+    db_unescape_string(config->body);
+    db_unescape_string(config->headers);
     
     return 0;
 }
 
 /* 保存Webhook配置 */
 int sms_save_webhook_config(const WebhookConfig *config) {
-    char sql[8192];
     char escaped_body[4096];
     char escaped_headers[1024];
     char escaped_url[1024];
+    int ret = -1;
     
     if (!config) return -1;
     
-    /* 转义特殊字符 */
+    /* 转义换行等特殊字符（与读取时的 db_unescape_string 对应） */
     db_escape_string(config->body, escaped_body, sizeof(escaped_body));
     db_escape_string(config->headers, escaped_headers, sizeof(escaped_headers));
     db_escape_string(config->url, escaped_url, sizeof(escaped_url));
     
-    snprintf(sql, sizeof(sql),
-        "INSERT OR REPLACE INTO webhook_config (id, enabled, platform, url, body, headers) "
-        "VALUES (1, %d, '%s', '%s', '%s', '%s');",
-        config->enabled, config->platform, escaped_url, escaped_body, escaped_headers);
-    
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_execute(sql);
+    db_stmt *st = db_prepare("INSERT OR REPLACE INTO webhook_config (id, enabled, platform, url, body, headers) "
+                             "VALUES (1, ?1, ?2, ?3, ?4, ?5);");
+    if (st) {
+        db_bind_int(st, 1, config->enabled);
+        db_bind_text(st, 2, config->platform);
+        db_bind_text(st, 3, escaped_url);
+        db_bind_text(st, 4, escaped_body);
+        db_bind_text(st, 5, escaped_headers);
+        ret = db_step(st) == DB_DONE ? 0 : -1;
+        db_finalize(st);
+    }
     pthread_mutex_unlock(&g_sms_mutex);
     
     if (ret == 0) {
@@ -728,7 +912,7 @@ void sms_maintenance(void) {
     if (!g_sms_dbus_conn || g_dbus_connection_is_closed(g_sms_dbus_conn)) {
         printf("[SMS] D-Bus连接无效，尝试重新连接...\n");
         GError *error = NULL;
-        g_sms_dbus_conn = g_bus_get_sync(G_BUS_TYPE_SYSTEM, NULL, &error);
+        g_sms_dbus_conn = ofono_bus_get(&error);
         if (g_sms_dbus_conn) {
             printf("[SMS] D-Bus重新连接成功\n");
             g_signal_connect(g_sms_dbus_conn, "closed", G_CALLBACK(on_dbus_connection_closed), NULL);
@@ -808,38 +992,21 @@ static void apply_sms_fix_on_init(void) {
 
 /* 保存发送记录到数据库 */
 static int save_sent_sms_to_db(const char *recipient, const char *content, time_t timestamp, const char *status) {
-    char sql[2048];
-    char escaped_content[1024];
-    
-    size_t j = 0;
-    for (size_t i = 0; content[i] && j < sizeof(escaped_content) - 2; i++) {
-        if (content[i] == '\'') {
-            escaped_content[j++] = '\'';
-            escaped_content[j++] = '\'';
-        } else {
-            escaped_content[j++] = content[i];
-        }
-    }
-    escaped_content[j] = '\0';
-    
-    snprintf(sql, sizeof(sql),
-        "INSERT INTO sent_sms (recipient, content, timestamp, status) VALUES ('%s', '%s', %ld, '%s');",
-        recipient, escaped_content, (long)timestamp, status);
-    
-    pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_execute(sql);
-    pthread_mutex_unlock(&g_sms_mutex);
-    
-    /* 清理超出限制的旧发送记录 */
-    if (ret == 0) {
-        snprintf(sql, sizeof(sql),
-            "DELETE FROM sent_sms WHERE id NOT IN (SELECT id FROM sent_sms ORDER BY id DESC LIMIT %d);",
-            g_max_sent_count);
-        pthread_mutex_lock(&g_sms_mutex);
-        db_execute(sql);
-        pthread_mutex_unlock(&g_sms_mutex);
+    int ret = -1;
+    
+    /* 同 save_sms_to_db，不取 g_sms_mutex */
+    db_stmt *st = db_prepare_cached("sent_sms_insert",
+        "INSERT INTO sent_sms (recipient, content, timestamp, status) VALUES (?1, ?2, ?3, ?4);");
+    if (st) {
+        db_bind_text(st, 1, recipient);
+        db_bind_text(st, 2, content);
+        db_bind_int64(st, 3, (long long)timestamp);
+        db_bind_text(st, 4, status);
+        ret = db_step(st) == DB_DONE ? 0 : -1;
+        db_finalize(st);
     }
     
+    /* 超出限制的旧发送记录由 trg_sent_sms_retention 触发器在插入时删除 */
     return ret;
 }
 
@@ -855,89 +1022,40 @@ int sms_delete_sent(int id) {
     return ret;
 }
 
-/* 获取发送记录列表 - 使用hex编码避免特殊字符问题，兼容无JSON扩展的SQLite */
+/* 行回调 - 列: id, recipient, content, timestamp, status */
+static int sent_sms_row_cb(db_stmt *row, void *user_data) {
+    SmsListCtx *ctx = (SmsListCtx *)user_data;
+    SentSmsMessage *msg = &((SentSmsMessage *)ctx->messages)[ctx->count++];
+    
+    msg->id = db_column_int(row, 0);
+    db_column_copy(row, 1, msg->recipient, sizeof(msg->recipient));
+    db_column_copy(row, 2, msg->content, sizeof(msg->content));
+    msg->timestamp = (time_t)db_column_int64(row, 3);
+    db_column_copy(row, 4, msg->status, sizeof(msg->status));
+    
+    return ctx->count >= ctx->max_count;
+}
+
+/* 获取发送记录列表 */
 int sms_get_sent_list(SentSmsMessage *messages, int max_count) {
-    char sql[512];
-    char *output = NULL;
+    SmsListCtx ctx = { messages, max_count, 0 };
     
     if (!messages || max_count <= 0) return -1;
     
-    /* 分配大缓冲区 */
-    output = (char *)malloc(256 * 1024);
-    if (!output) return -1;
-    
-    /* 使用hex编码content字段，用|分隔，每行一条记录 */
-    snprintf(sql, sizeof(sql),
-        "SELECT id || '|' || recipient || '|' || hex(content) || '|' || timestamp || '|' || status FROM sent_sms ORDER BY id DESC LIMIT %d;",
-        max_count);
-    
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_query_string(sql, output, 256 * 1024);
-    pthread_mutex_unlock(&g_sms_mutex);
-    
-    if (ret != 0 || strlen(output) == 0) {
-        printf("[SMS] 获取发送记录列表失败或为空\n");
-        free(output);
-        return 0;
-    }
-    
-    /* 解析输出 - 格式: id|recipient|hex_content|timestamp|status\n */
-    int count = 0;
-    char *line = output;
-    char *next_line;
-    
-    while (line && *line && count < max_count) {
-        /* 找到行尾 */
-        next_line = strchr(line, '\n');
-        if (next_line) {
-            *next_line = '\0';
-            next_line++;
-        }
-        
-        /* 跳过空行 */
-        if (strlen(line) == 0) {
-            line = next_line;
-            continue;
-        }
-        
-        /* 解析字段: id|recipient|hex_content|timestamp|status */
-        char *fields[5] = {NULL};
-        int field_count = 0;
-        char *p = line;
-        char *field_start = p;
-        
-        while (*p && field_count < 5) {
-            if (*p == '|') {
-                *p = '\0';
-                fields[field_count++] = field_start;
-                field_start = p + 1;
-            }
-            p++;
+    db_stmt *st = db_prepare_cached("sent_sms_list",
+        "SELECT id, recipient, content, timestamp, status FROM sent_sms ORDER BY id DESC LIMIT ?1;");
+    if (st) {
+        db_bind_int(st, 1, max_count);
+        if (db_foreach(st, sent_sms_row_cb, &ctx) < 0) {
+            printf("[SMS] 获取发送记录列表失败\n");
         }
-        if (field_count < 5 && field_start) {
-            fields[field_count++] = field_start;
-        }
-        
-        if (field_count >= 5) {
-            messages[count].id = atoi(fields[0]);
-            strncpy(messages[count].recipient, fields[1], sizeof(messages[count].recipient) - 1);
-            messages[count].recipient[sizeof(messages[count].recipient) - 1] = '\0';
-            
-            /* hex解码content */
-            hex_decode(fields[2], messages[count].content, sizeof(messages[count].content));
-            
-            messages[count].timestamp = (time_t)atol(fields[3]);
-            strncpy(messages[count].status, fields[4], sizeof(messages[count].status) - 1);
-            messages[count].status[sizeof(messages[count].status) - 1] = '\0';
-            count++;
-        }
-        
-        line = next_line;
+        db_finalize(st);
     }
+    pthread_mutex_unlock(&g_sms_mutex);
     
-    free(output);
-    printf("[SMS] 获取到 %d 条发送记录\n", count);
-    return count;
+    printf("[SMS] 获取到 %d 条发送记录\n", ctx.count);
+    return ctx.count;
 }
 
 /* 获取最大存储数量 */
@@ -952,23 +1070,16 @@ int sms_get_max_sent_count(void) {
 
 /* 加载配置 */
 static void load_sms_config(void) {
-    char output[128];
-    const char *sql = "SELECT max_count || '|' || max_sent_count FROM sms_config WHERE id = 1;";
-    
     pthread_mutex_lock(&g_sms_mutex);
-    int ret = db_query_string(sql, output, sizeof(output));
-    pthread_mutex_unlock(&g_sms_mutex);
-    
-    if (ret == 0 && strlen(output) > 0) {
-        char *sep = strchr(output, '|');
-        if (sep) {
-            *sep = '\0';
-            int mc = atoi(output);
-            int msc = atoi(sep + 1);
-            if (mc > 0) g_max_sms_count = mc;
-            if (msc > 0) g_max_sent_count = msc;
-        }
+    db_stmt *st = db_prepare("SELECT max_count, max_sent_count FROM sms_config WHERE id = 1;");
+    if (st && db_step(st) == DB_ROW) {
+        int mc = db_column_int(st, 0);
+        int msc = db_column_int(st, 1);
+        if (mc > 0) g_max_sms_count = mc;
+        if (msc > 0) g_max_sent_count = msc;
     }
+    db_finalize(st);
+    pthread_mutex_unlock(&g_sms_mutex);
     
     printf("[SMS] 配置加载完成: 收件箱最大=%d, 发件箱最大=%d\n", g_max_sms_count, g_max_sent_count);
 }
@@ -8,11 +8,15 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/utsname.h>
+#include <pthread.h>
 #include <glib.h>
 #include "sysinfo.h"
 #include "dbus_core.h"
 #include "exec_utils.h"
 #include "ofono.h"
+#include "sampler.h"
+#include "dbus_query.h"
+#include "cpu_monitor.h"
 
 /* 读取文件内容 */
 static int read_file(const char *path, char *buf, size_t size) {
@@ -24,31 +28,10 @@ static int read_file(const char *path, char *buf, size_t size) {
     return 0;
 }
 
-/* 解析 /proc/meminfo */
-static void parse_meminfo(SystemInfo *info) {
-    char buf[4096];
-    if (read_file("/proc/meminfo", buf, sizeof(buf)) != 0) return;
-
-    char *line = strtok(buf, "\n");
-    while (line) {
-        unsigned long val;
-        if (sscanf(line, "MemTotal: %lu kB", &val) == 1) {
-            info->total_ram = val / 1024;
-        } else if (sscanf(line, "MemFree: %lu kB", &val) == 1) {
-            info->free_ram = val / 1024;
-        } else if (sscanf(line, "Cached: %lu kB", &val) == 1) {
-            info->cached_ram = val / 1024;
-        }
-        line = strtok(NULL, "\n");
-    }
-}
-
 double get_uptime(void) {
-    char buf[64];
-    if (read_file("/proc/uptime", buf, sizeof(buf)) != 0) return -1;
     double uptime;
-    if (sscanf(buf, "%lf", &uptime) == 1) return uptime;
-    return -1;
+    if (sampler_read_uptime(&uptime) != 0) return -1;
+    return uptime;
 }
 
 
@@ -72,15 +55,11 @@ int get_serial(char *serial, size_t size) {
     return i > 0 ? 0 : -1;
 }
 
-int get_current_slot(char *slot, char *ril_path) {
+/* 由数据卡路径得到卡槽名和 RIL 路径 */
+static void parse_datacard(const char *datacard, char *slot, char *ril_path) {
     strcpy(slot, "unknown");
     strcpy(ril_path, "unknown");
-
-    /* 使用 ofono D-Bus 接口获取数据卡 */
-    char *datacard = ofono_get_datacard();
-    if (!datacard) {
-        return -1;
-    }
+    if (!datacard || !datacard[0]) return;
 
     /* 解析路径 */
     if (strstr(datacard, "/ril_0")) {
@@ -94,11 +73,28 @@ int get_current_slot(char *slot, char *ril_path) {
         strncpy(ril_path, datacard, 31);
         ril_path[31] = '\0';
     }
+}
 
+int get_current_slot(char *slot, char *ril_path) {
+    strcpy(slot, "unknown");
+    strcpy(ril_path, "unknown");
+
+    /* 使用 ofono D-Bus 接口获取数据卡 */
+    char *datacard = ofono_get_datacard();
+    if (!datacard) {
+        return -1;
+    }
+
+    parse_datacard(datacard, slot, ril_path);
     g_free(datacard);
     return 0;
 }
 
+/* 格式化信号强度: "XX%, -YY dBm" */
+static void format_signal(int strength, int dbm, char *out, size_t size) {
+    snprintf(out, size, "%d%%, -%d dBm", strength, dbm);
+}
+
 int get_signal_strength(char *strength, size_t size) {
     char slot[16], ril_path[32];
     int strength_val = 0, dbm_val = 0;
@@ -114,24 +110,59 @@ int get_signal_strength(char *strength, size_t size) {
         return -1;
     }
 
-    /* 格式化输出: "XX%, -YY dBm" */
-    snprintf(strength, size, "%d%%, -%d dBm", strength_val, dbm_val);
+    format_signal(strength_val, dbm_val, strength, size);
     return 0;
 }
 
+/* 所有温度传感器的平均值 */
 double get_thermal_temp(void) {
-    char output[64];
-    if (run_command(output, sizeof(output), "sh", "-c",
-        "cat /sys/class/thermal/thermal_zone*/temp | awk '{sum+=$1} END {printf \"%.2f\", sum/NR/1000}'",
-        NULL) != 0) {
-        return -1;
+    SamplerThermalZone zones[SAMPLER_MAX_ZONES];
+    int count = sampler_read_thermal(zones, SAMPLER_MAX_ZONES);
+    if (count <= 0) return -1;
+
+    long long sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += zones[i].temp_milli;
+    }
+    return (double)sum / count / 1000.0;
+}
+
+int get_thermal_zones(ThermalZoneInfo *zones, int max) {
+    SamplerThermalZone raw[SAMPLER_MAX_ZONES];
+    int count = sampler_read_thermal(raw, max < SAMPLER_MAX_ZONES ? max : SAMPLER_MAX_ZONES);
+    if (count < 0) return -1;
+
+    for (int i = 0; i < count; i++) {
+        snprintf(zones[i].name, sizeof(zones[i].name), "%s", raw[i].type[0] ? raw[i].type : "unknown");
+        zones[i].id = raw[i].id;
+        zones[i].temp = raw[i].temp_milli / 1000.0;
     }
-    double temp;
-    if (sscanf(output, "%lf", &temp) == 1) return temp;
-    return -1;
+    return count;
 }
 
 
+/* 由服务小区制式和频段号得到网络类型和频段 */
+static void format_serving_cell(const char *tech, int band_num, char *net_type, size_t type_size,
+                                char *band, size_t band_size) {
+    /* 判断网络类型 */
+    if (strcmp(tech, "nr") == 0) {
+        strncpy(net_type, "5G NR", type_size - 1);
+        if (band_num > 0) {
+            snprintf(band, band_size, "N%d", band_num);
+        }
+    } else if (strcmp(tech, "lte") == 0) {
+        strncpy(net_type, "4G LTE", type_size - 1);
+        if (band_num > 0) {
+            snprintf(band, band_size, "B%d", band_num);
+        }
+    } else if (strlen(tech) > 0) {
+        strncpy(net_type, tech, type_size - 1);
+        if (band_num > 0) {
+            snprintf(band, band_size, "%d", band_num);
+        }
+    }
+}
+
 /* 前向声明 airplane.h 中的函数 */
 extern int get_imei(char *imei, size_t size);
 extern int get_iccid(char *iccid, size_t size);
@@ -139,11 +170,7 @@ extern int get_imsi(char *imsi, size_t size);
 extern const char *get_carrier_from_imsi(const char *imsi);
 extern int get_airplane_mode(void);
 
-int get_system_info(SystemInfo *info) {
-    struct utsname uts;
-    char buf[256];
-
-    /* 初始化默认值 */
+void sysinfo_init_defaults(SystemInfo *info) {
     memset(info, 0, sizeof(SystemInfo));
     strcpy(info->hostname, "N/A");
     strcpy(info->sysname, "N/A");
@@ -161,42 +188,66 @@ int get_system_info(SystemInfo *info) {
     strcpy(info->network_mode, "N/A");
     strcpy(info->network_type, "N/A");
     strcpy(info->network_band, "N/A");
+    info->thermal_temp = -1;
     info->is_activated = 1;
+}
 
-    /* uname 信息 */
-    if (uname(&uts) == 0) {
-        strncpy(info->sysname, uts.sysname, sizeof(info->sysname) - 1);
-        strncpy(info->release, uts.release, sizeof(info->release) - 1);
-        strncpy(info->version, uts.version, sizeof(info->version) - 1);
-        strncpy(info->machine, uts.machine, sizeof(info->machine) - 1);
-        strncpy(info->hostname, uts.nodename, sizeof(info->hostname) - 1);
-    }
+/*============================================================================
+ * 分组探测
+ *============================================================================*/
 
-    /* 内存信息 */
-    parse_meminfo(info);
+static int probe_uname(SystemInfo *info) {
+    struct utsname uts;
+    if (uname(&uts) != 0) return -1;
+
+    strncpy(info->sysname, uts.sysname, sizeof(info->sysname) - 1);
+    strncpy(info->release, uts.release, sizeof(info->release) - 1);
+    strncpy(info->version, uts.version, sizeof(info->version) - 1);
+    strncpy(info->machine, uts.machine, sizeof(info->machine) - 1);
+    strncpy(info->hostname, uts.nodename, sizeof(info->hostname) - 1);
+    return 0;
+}
+
+static int probe_memory(SystemInfo *info) {
+    SamplerMeminfo mem;
+    if (sampler_read_meminfo(&mem) != 0) return -1;
 
-    /* 运行时间 */
-    info->uptime = get_uptime();
+    info->total_ram = (unsigned long)(mem.total / 1024);
+    info->free_ram = (unsigned long)(mem.free / 1024);
+    info->cached_ram = (unsigned long)(mem.cached / 1024);
+    return 0;
+}
 
-    /* 序列号 */
-    get_serial(info->serial, sizeof(info->serial));
+static int probe_thermal(SystemInfo *info) {
+    /* 平均值和各传感器 */
+    info->thermal_zone_count = get_thermal_zones(info->thermal_zones, SYSINFO_MAX_THERMAL_ZONES);
+    if (info->thermal_zone_count <= 0) {
+        info->thermal_zone_count = 0;
+        info->thermal_temp = -1;
+        return -1;
+    }
 
-    /* SIM 卡槽 */
-    char ril_path[32];
-    if (get_current_slot(info->sim_slot, ril_path) == 0) {
-        strncpy(info->network_mode, ril_path, sizeof(info->network_mode) - 1);
+    double sum = 0;
+    for (int i = 0; i < info->thermal_zone_count; i++) {
+        sum += info->thermal_zones[i].temp;
     }
+    info->thermal_temp = sum / info->thermal_zone_count;
+    return 0;
+}
 
-    /* 信号强度 */
-    get_signal_strength(info->signal_strength, sizeof(info->signal_strength));
+static int probe_battery(SystemInfo *info) {
+    char buf[256];
+    int ret = -1;
 
-    /* 温度 */
-    info->thermal_temp = get_thermal_temp();
+    strcpy(info->power_status, "N/A");
+    strcpy(info->battery_health, "N/A");
+    info->battery_capacity = 0;
 
     /* 电源状态 */
     if (read_file("/sys/class/power_supply/battery/status", buf, sizeof(buf)) == 0) {
         buf[strcspn(buf, "\n")] = '\0';
         strncpy(info->power_status, buf, sizeof(info->power_status) - 1);
+        ret = 0;
     }
 
     /* 电池健康 */
@@ -209,52 +260,356 @@ int get_system_info(SystemInfo *info) {
     if (read_file("/sys/class/power_supply/battery/capacity", buf, sizeof(buf)) == 0) {
         info->battery_capacity = atoi(buf);
     }
+    return ret;
+}
+
+static int probe_wifi(SystemInfo *info) {
+    char buf[256];
+
+    if (read_file("/var/lib/connman/settings", buf, sizeof(buf)) != 0) return -1;
+
+    char *p = strstr(buf, "Tethering.Identifier=");
+    if (!p) return -1;
+
+    p += strlen("Tethering.Identifier=");
+    char *end = strchr(p, '\n');
+    if (end) *end = '\0';
+    memset(info->ssid, 0, sizeof(info->ssid));
+    strncpy(info->ssid, p, sizeof(info->ssid) - 1);
+    return 0;
+}
+
+/*============================================================================
+ * oFono 查询（并发执行）
+ *============================================================================*/
+
+#define SYSINFO_GROUP_MODEM_MASK  (SYSINFO_GROUP_BIT(SYSINFO_GROUP_SLOT) | \
+                                   SYSINFO_GROUP_BIT(SYSINFO_GROUP_SIGNAL) | \
+                                   SYSINFO_GROUP_BIT(SYSINFO_GROUP_IDENTITY) | \
+                                   SYSINFO_GROUP_BIT(SYSINFO_GROUP_AIRPLANE) | \
+                                   SYSINFO_GROUP_BIT(SYSINFO_GROUP_NET_MODE) | \
+                                   SYSINFO_GROUP_BIT(SYSINFO_GROUP_SERVING))
+
+/* 依赖数据卡 RIL 路径的分组 */
+#define SYSINFO_GROUP_PATH_MASK   (SYSINFO_GROUP_MODEM_MASK & ~SYSINFO_GROUP_BIT(SYSINFO_GROUP_SERVING))
+
+#define SERVING_CELL_PATH  "/ril_0"  /* 与 ofono_get_serving_cell_info 一致 */
+
+/* 读取字符串属性 */
+static int lookup_str_prop(GVariant *reply, const char *key, char *out, size_t size) {
+    GVariant *v = dbus_query_lookup_property(reply, key);
+    if (!v) return -1;
+
+    int ret = -1;
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_STRING)) {
+        const char *s = g_variant_get_string(v, NULL);
+        if (s && s[0]) {
+            snprintf(out, size, "%s", s);
+            ret = 0;
+        }
+    }
+    g_variant_unref(v);
+    return ret;
+}
+
+/* 读取整数属性（byte/int32/uint32） */
+static int lookup_int_prop(GVariant *reply, const char *key, int *out) {
+    GVariant *v = dbus_query_lookup_property(reply, key);
+    if (!v) return -1;
+
+    int ret = 0;
+    if (g_variant_is_of_type(v, G_VARIANT_TYPE_BYTE)) {
+        *out = g_variant_get_byte(v);
+    } else if (g_variant_is_of_type(v, G_VARIANT_TYPE_INT32)) {
+        *out = g_variant_get_int32(v);
+    } else if (g_variant_is_of_type(v, G_VARIANT_TYPE_UINT32)) {
+        *out = (int)g_variant_get_uint32(v);
+    } else if (g_variant_is_of_type(v, G_VARIANT_TYPE_BOOLEAN)) {
+        *out = g_variant_get_boolean(v) ? 1 : 0;
+    } else {
+        ret = -1;
+    }
+    g_variant_unref(v);
+    return ret;
+}
+
+static int parse_signal(GVariant *reply, SystemInfo *info) {
+    int strength = 0, dbm = 0;
+
+    strcpy(info->signal_strength, "N/A");
+    if (lookup_int_prop(reply, "Strength", &strength) != 0) return -1;
+    if (lookup_int_prop(reply, "StrengthDbm", &dbm) != 0) {
+        dbm = -113 + 2 * strength;
+    }
+    format_signal(strength, dbm, info->signal_strength, sizeof(info->signal_strength));
+    return 0;
+}
 
-    /* IMEI */
-    get_imei(info->imei, sizeof(info->imei));
+static int parse_serving(GVariant *reply, SystemInfo *info) {
+    char tech[32] = {0};
+    int band_num = 0;
 
-    /* ICCID */
-    get_iccid(info->iccid, sizeof(info->iccid));
+    strcpy(info->network_type, "N/A");
+    strcpy(info->network_band, "N/A");
+    if (lookup_str_prop(reply, "Technology", tech, sizeof(tech)) != 0) return -1;
+    lookup_int_prop(reply, "Band", &band_num);
+
+    format_serving_cell(tech, band_num, info->network_type, sizeof(info->network_type),
+                        info->network_band, sizeof(info->network_band));
+    return 0;
+}
+
+static int parse_identity(GVariant *modem, GVariant *sim, SystemInfo *info) {
+    int ret = 0;
+
+    /* 换卡或拔卡后不保留旧值 */
+    memset(info->imei, 0, sizeof(info->imei));
+    memset(info->iccid, 0, sizeof(info->iccid));
+    memset(info->imsi, 0, sizeof(info->imsi));
+    memset(info->carrier, 0, sizeof(info->carrier));
+
+    /* oFono 属性缺失时退回 AT 命令 */
+    if (lookup_str_prop(modem, "Serial", info->imei, sizeof(info->imei)) != 0 &&
+        get_imei(info->imei, sizeof(info->imei)) != 0) {
+        ret = -1;
+    }
+    if (lookup_str_prop(sim, "CardIdentifier", info->iccid, sizeof(info->iccid)) != 0 &&
+        get_iccid(info->iccid, sizeof(info->iccid)) != 0) {
+        ret = -1;
+    }
 
     /* IMSI 和运营商 */
-    if (get_imsi(info->imsi, sizeof(info->imsi)) == 0) {
+    if (lookup_str_prop(sim, "SubscriberIdentity", info->imsi, sizeof(info->imsi)) == 0 ||
+        get_imsi(info->imsi, sizeof(info->imsi)) == 0) {
         const char *carrier = get_carrier_from_imsi(info->imsi);
         strncpy(info->carrier, carrier, sizeof(info->carrier) - 1);
+    } else {
+        ret = -1;
+    }
+    return ret;
+}
+
+static int parse_airplane(GVariant *modem, SystemInfo *info) {
+    int online;
+
+    /* 飞行模式即 modem 离线（与 set_airplane_mode 一致），属性缺失时查询 AT+CFUN? */
+    if (lookup_int_prop(modem, "Online", &online) == 0) {
+        info->airplane_mode = online ? 0 : 1;
+        return 0;
     }
 
-    /* 飞行模式 */
     int airplane = get_airplane_mode();
     info->airplane_mode = (airplane == 1) ? 1 : 0;
+    return airplane < 0 ? -1 : 0;
+}
 
-    /* WiFi 信息 */
-    if (read_file("/var/lib/connman/settings", buf, sizeof(buf)) == 0) {
-        char *p = strstr(buf, "Tethering.Identifier=");
-        if (p) {
-            p += strlen("Tethering.Identifier=");
-            char *end = strchr(p, '\n');
-            if (end) *end = '\0';
-            strncpy(info->ssid, p, sizeof(info->ssid) - 1);
-        }
+static int parse_net_mode(GVariant *reply, SystemInfo *info) {
+    char mode_buf[32];
+    if (lookup_str_prop(reply, "TechnologyPreference", mode_buf, sizeof(mode_buf)) != 0) return -1;
+
+    memset(info->select_network_mode, 0, sizeof(info->select_network_mode));
+    strncpy(info->select_network_mode, mode_buf, sizeof(info->select_network_mode) - 1);
+    return 0;
+}
+
+/**
+ * 并发查询 oFono 相关分组
+ * 第一轮: 数据卡路径和服务小区；第二轮: 依赖数据卡路径的 NetworkRegistration、
+ * RadioSettings、Modem、SimManager 属性。两轮共用 SYSINFO_QUERY_TIMEOUT_MS。
+ * @return 成功的分组掩码
+ */
+static unsigned int probe_modem_groups(unsigned int mask, SystemInfo *info) {
+    unsigned int ok = 0;
+    int q_card = -1, q_serving = -1, q_netreg = -1, q_radio = -1, q_modem = -1, q_sim = -1;
+    char ril_path[32] = "";
+
+    DbusQueryGroup *q = dbus_query_group_new(SYSINFO_QUERY_TIMEOUT_MS);
+    if (!q) return 0;
+
+    if (mask & SYSINFO_GROUP_PATH_MASK) {
+        q_card = dbus_query_group_add(q, "/", "org.ofono.Manager", "GetDataCard", NULL, "(o)");
+    }
+    if (mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_SERVING)) {
+        q_serving = dbus_query_group_add(q, SERVING_CELL_PATH, "org.ofono.NetworkMonitor",
+                                         "GetServingCellInformation", NULL, "(a{sv})");
+    }
+    dbus_query_group_run_sync(q);
+
+    if (q_serving >= 0 && parse_serving(dbus_query_group_result(q, q_serving), info) == 0) {
+        ok |= SYSINFO_GROUP_BIT(SYSINFO_GROUP_SERVING);
+    }
+
+    GVariant *card = dbus_query_group_result(q, q_card);
+    if (card) {
+        const char *datacard = NULL;
+        g_variant_get(card, "(&o)", &datacard);
+        parse_datacard(datacard, info->sim_slot, ril_path);
+    } else {
+        strcpy(info->sim_slot, "unknown");
+        strcpy(ril_path, "unknown");
+    }
+    if (mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_SLOT)) {
+        memset(info->network_mode, 0, sizeof(info->network_mode));
+        strncpy(info->network_mode, card ? ril_path : "N/A", sizeof(info->network_mode) - 1);
+        if (card) ok |= SYSINFO_GROUP_BIT(SYSINFO_GROUP_SLOT);
     }
 
-    /* 网络模式选择 - 使用 ofono D-Bus 接口 */
-    char mode_buf[64] = {0};
-    if (strcmp(ril_path, "unknown") != 0 && strlen(ril_path) > 0) {
-        if (ofono_network_get_mode_sync(ril_path, mode_buf, sizeof(mode_buf), OFONO_TIMEOUT_MS) == 0) {
-            strncpy(info->select_network_mode, mode_buf, sizeof(info->select_network_mode) - 1);
+    if (ril_path[0] == '/') {
+        if (mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_SIGNAL)) {
+            q_netreg = dbus_query_group_add_properties(q, ril_path, "org.ofono.NetworkRegistration");
+        }
+        if (mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_NET_MODE)) {
+            q_radio = dbus_query_group_add_properties(q, ril_path, OFONO_RADIO_SETTINGS);
         }
+        if (mask & (SYSINFO_GROUP_BIT(SYSINFO_GROUP_IDENTITY) | SYSINFO_GROUP_BIT(SYSINFO_GROUP_AIRPLANE))) {
+            q_modem = dbus_query_group_add_properties(q, ril_path, "org.ofono.Modem");
+        }
+        if (mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_IDENTITY)) {
+            q_sim = dbus_query_group_add_properties(q, ril_path, "org.ofono.SimManager");
+        }
+        dbus_query_group_run_sync(q);
+    } else if (mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_SIGNAL)) {
+        strcpy(info->signal_strength, "N/A");
+    }
+
+    if (q_netreg >= 0 && parse_signal(dbus_query_group_result(q, q_netreg), info) == 0) {
+        ok |= SYSINFO_GROUP_BIT(SYSINFO_GROUP_SIGNAL);
+    }
+    if (q_radio >= 0 && parse_net_mode(dbus_query_group_result(q, q_radio), info) == 0) {
+        ok |= SYSINFO_GROUP_BIT(SYSINFO_GROUP_NET_MODE);
+    }
+    if ((mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_AIRPLANE)) &&
+        parse_airplane(dbus_query_group_result(q, q_modem), info) == 0) {
+        ok |= SYSINFO_GROUP_BIT(SYSINFO_GROUP_AIRPLANE);
     }
+    if ((mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_IDENTITY)) &&
+        parse_identity(dbus_query_group_result(q, q_modem), dbus_query_group_result(q, q_sim), info) == 0) {
+        ok |= SYSINFO_GROUP_BIT(SYSINFO_GROUP_IDENTITY);
+    }
+
+    dbus_query_group_free(q);
+    return ok;
+}
+
+/* 不经过 oFono D-Bus 的分组 */
+static int probe_local(SysinfoGroup group, SystemInfo *info) {
+    switch (group) {
+    case SYSINFO_GROUP_UNAME:
+        return probe_uname(info);
+    case SYSINFO_GROUP_SERIAL:
+        return get_serial(info->serial, sizeof(info->serial));
+    case SYSINFO_GROUP_MEMORY:
+        return probe_memory(info);
+    case SYSINFO_GROUP_UPTIME:
+        info->uptime = get_uptime();
+        return info->uptime < 0 ? -1 : 0;
+    case SYSINFO_GROUP_CPU:
+        info->cpu_usage = get_cpu_usage();
+        return 0;
+    case SYSINFO_GROUP_THERMAL:
+        return probe_thermal(info);
+    case SYSINFO_GROUP_BATTERY:
+        return probe_battery(info);
+    case SYSINFO_GROUP_WIFI:
+        return probe_wifi(info);
+    case SYSINFO_GROUP_QOS:
+        return get_qos_info(&info->qci, &info->downlink_rate, &info->uplink_rate);
+    default:
+        return -1;
+    }
+}
+
+unsigned int sysinfo_probe_groups(unsigned int mask, SystemInfo *info) {
+    unsigned int ok = 0;
 
-    /* 网络类型和频段 */
-    get_network_type_and_band(info->network_type, sizeof(info->network_type),
-                              info->network_band, sizeof(info->network_band));
+    if (mask & SYSINFO_GROUP_MODEM_MASK) {
+        ok |= probe_modem_groups(mask & SYSINFO_GROUP_MODEM_MASK, info);
+    }
+    for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+        unsigned int bit = SYSINFO_GROUP_BIT(g);
+        if ((mask & bit) && !(bit & SYSINFO_GROUP_MODEM_MASK) && probe_local((SysinfoGroup)g, info) == 0) {
+            ok |= bit;
+        }
+    }
+    return ok;
+}
 
-    /* QoS 签约速率 */
-    get_qos_info(&info->qci, &info->downlink_rate, &info->uplink_rate);
+#define COPY_FIELD(f)  memcpy(&dst->f, &src->f, sizeof(dst->f))
+
+void sysinfo_copy_group(SysinfoGroup group, SystemInfo *dst, const SystemInfo *src) {
+    switch (group) {
+    case SYSINFO_GROUP_UNAME:
+        COPY_FIELD(hostname);
+        COPY_FIELD(sysname);
+        COPY_FIELD(release);
+        COPY_FIELD(version);
+        COPY_FIELD(machine);
+        break;
+    case SYSINFO_GROUP_SERIAL:
+        COPY_FIELD(serial);
+        break;
+    case SYSINFO_GROUP_MEMORY:
+        COPY_FIELD(total_ram);
+        COPY_FIELD(free_ram);
+        COPY_FIELD(cached_ram);
+        break;
+    case SYSINFO_GROUP_UPTIME:
+        COPY_FIELD(uptime);
+        break;
+    case SYSINFO_GROUP_CPU:
+        COPY_FIELD(cpu_usage);
+        break;
+    case SYSINFO_GROUP_THERMAL:
+        COPY_FIELD(thermal_temp);
+        COPY_FIELD(thermal_zones);
+        COPY_FIELD(thermal_zone_count);
+        break;
+    case SYSINFO_GROUP_BATTERY:
+        COPY_FIELD(power_status);
+        COPY_FIELD(battery_health);
+        COPY_FIELD(battery_capacity);
+        break;
+    case SYSINFO_GROUP_WIFI:
+        COPY_FIELD(ssid);
+        break;
+    case SYSINFO_GROUP_SLOT:
+        COPY_FIELD(sim_slot);
+        COPY_FIELD(network_mode);
+        break;
+    case SYSINFO_GROUP_SIGNAL:
+        COPY_FIELD(signal_strength);
+        break;
+    case SYSINFO_GROUP_IDENTITY:
+        COPY_FIELD(imei);
+        COPY_FIELD(iccid);
+        COPY_FIELD(imsi);
+        COPY_FIELD(carrier);
+        break;
+    case SYSINFO_GROUP_AIRPLANE:
+        COPY_FIELD(airplane_mode);
+        break;
+    case SYSINFO_GROUP_NET_MODE:
+        COPY_FIELD(select_network_mode);
+        break;
+    case SYSINFO_GROUP_SERVING:
+        COPY_FIELD(network_type);
+        COPY_FIELD(network_band);
+        break;
+    case SYSINFO_GROUP_QOS:
+        COPY_FIELD(qci);
+        COPY_FIELD(downlink_rate);
+        COPY_FIELD(uplink_rate);
+        break;
+    default:
+        break;
+    }
+}
 
-    /* CPU 使用率 */
-    info->cpu_usage = get_cpu_usage();
+#undef COPY_FIELD
 
+int get_system_info(SystemInfo *info) {
+    sysinfo_init_defaults(info);
+    sysinfo_probe_groups(SYSINFO_GROUP_ALL, info);
     return 0;
 }
 
@@ -263,14 +618,14 @@ int get_system_info(SystemInfo *info) {
 /* AT+CGEQOSRDP 返回: +CGEQOSRDP: 1,8,0,0,0,0,500000,60000 */
 /* 索引1=QCI, 索引6=下行速率(kbps), 索引7=上行速率(kbps) */
 int get_qos_info(int *qci, int *downlink, int *uplink) {
-    extern int execute_at(const char *command, char **result);
+    extern int execute_at_background(const char *command, char **result);
     char *result = NULL;
     
     *qci = 0;
     *downlink = 0;
     *uplink = 0;
 
-    if (execute_at("AT+CGEQOSRDP", &result) != 0 || !result) {
+    if (execute_at_background("AT+CGEQOSRDP", &result) != 0 || !result) {
         return -1;
     }
 
@@ -315,112 +670,51 @@ int get_network_type_and_band(char *net_type, size_t type_size, char *band, size
         return -1;
     }
 
-    /* 判断网络类型 */
-    if (strcmp(tech, "nr") == 0) {
-        strncpy(net_type, "5G NR", type_size - 1);
-        if (band_num > 0) {
-            snprintf(band, band_size, "N%d", band_num);
-        }
-    } else if (strcmp(tech, "lte") == 0) {
-        strncpy(net_type, "4G LTE", type_size - 1);
-        if (band_num > 0) {
-            snprintf(band, band_size, "B%d", band_num);
-        }
-    } else if (strlen(tech) > 0) {
-        strncpy(net_type, tech, type_size - 1);
-        if (band_num > 0) {
-            snprintf(band, band_size, "%d", band_num);
-        }
-    }
-
+    format_serving_cell(tech, band_num, net_type, type_size, band, band_size);
     return 0;
 }
 
-/* 获取 CPU 使用率 - 通过读取 /proc/stat 计算 */
-/* /proc/stat 格式: cpu user nice system idle iowait irq softirq steal guest guest_nice */
-/* CPU使用率 = 100 - (idle_diff / total_diff * 100) */
+/* 获取 CPU 使用率 - 优先使用 cpu_monitor 的定时采样 */
+/* 监控未运行时退回到与上次调用之间的差值: CPU使用率 = 100 - (idle_diff / total_diff * 100) */
 
-/* 静态变量保存上次采样数据 */
-static unsigned long long prev_user = 0, prev_nice = 0, prev_system = 0;
-static unsigned long long prev_idle = 0, prev_iowait = 0, prev_irq = 0;
-static unsigned long long prev_softirq = 0, prev_steal = 0;
+/* 上次采样数据（仅退回路径使用） */
+static SamplerCpuTimes g_prev_cpu;
 static int cpu_initialized = 0;
+static pthread_mutex_t g_prev_cpu_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 double get_cpu_usage(void) {
-    char buf[1024];
-    unsigned long long user, nice, system, idle, iowait, irq, softirq, steal;
-    
-    /* 读取 /proc/stat */
-    FILE *f = fopen("/proc/stat", "r");
-    if (!f) return 0;
-    
-    if (fgets(buf, sizeof(buf), f) == NULL) {
-        fclose(f);
-        return 0;
-    }
-    fclose(f);
-    
-    /* 解析第一行 cpu 数据 */
-    /* 格式: cpu  user nice system idle iowait irq softirq steal [guest guest_nice] */
-    int ret = sscanf(buf, "cpu %llu %llu %llu %llu %llu %llu %llu %llu",
-                     &user, &nice, &system, &idle, &iowait, &irq, &softirq, &steal);
-    if (ret < 4) return 0;
-    
-    /* 如果某些字段不存在，设为0 */
-    if (ret < 5) iowait = 0;
-    if (ret < 6) irq = 0;
-    if (ret < 7) softirq = 0;
-    if (ret < 8) steal = 0;
-    
-    /* 首次调用，保存数据并返回0 */
-    if (!cpu_initialized) {
-        prev_user = user;
-        prev_nice = nice;
-        prev_system = system;
-        prev_idle = idle;
-        prev_iowait = iowait;
-        prev_irq = irq;
-        prev_softirq = softirq;
-        prev_steal = steal;
-        cpu_initialized = 1;
-        return 0;
-    }
-    
+    double usage = cpu_monitor_total_now();
+    if (usage >= 0) return usage;
+
+    SamplerCpuTimes cur;
+    if (sampler_read_cpu(&cur) != 0) return 0;
+
+    pthread_mutex_lock(&g_prev_cpu_mutex);
+    SamplerCpuTimes prev = g_prev_cpu;
+    int have_prev = cpu_initialized;
+    g_prev_cpu = cur;
+    cpu_initialized = 1;
+    pthread_mutex_unlock(&g_prev_cpu_mutex);
+
+    /* 首次调用返回0 */
+    if (!have_prev) return 0;
+
     /* 计算差值 */
-    unsigned long long user_diff = user - prev_user;
-    unsigned long long nice_diff = nice - prev_nice;
-    unsigned long long system_diff = system - prev_system;
-    unsigned long long idle_diff = idle - prev_idle;
-    unsigned long long iowait_diff = iowait - prev_iowait;
-    unsigned long long irq_diff = irq - prev_irq;
-    unsigned long long softirq_diff = softirq - prev_softirq;
-    unsigned long long steal_diff = steal - prev_steal;
-    
-    /* 总时间差 */
-    unsigned long long total_diff = user_diff + nice_diff + system_diff + idle_diff +
-                                    iowait_diff + irq_diff + softirq_diff + steal_diff;
-    
-    /* 保存当前值供下次使用 */
-    prev_user = user;
-    prev_nice = nice;
-    prev_system = system;
-    prev_idle = idle;
-    prev_iowait = iowait;
-    prev_irq = irq;
-    prev_softirq = softirq;
-    prev_steal = steal;
-    
+    unsigned long long idle_diff = (cur.idle - prev.idle) + (cur.iowait - prev.iowait);
+    unsigned long long total_diff = (cur.user - prev.user) + (cur.nice - prev.nice) +
+                                    (cur.system - prev.system) + (cur.irq - prev.irq) +
+                                    (cur.softirq - prev.softirq) + (cur.steal - prev.steal) +
+                                    idle_diff;
+
     /* 避免除零 */
     if (total_diff == 0) return 0;
-    
-    /* CPU使用率 = 100 - idle百分比 */
-    /* idle时间包括 idle + iowait */
-    double idle_percent = (double)(idle_diff + iowait_diff) / total_diff * 100.0;
-    double usage = 100.0 - idle_percent;
-    
+
+    /* CPU使用率 = 100 - idle百分比，idle时间包括 idle + iowait */
+    usage = 100.0 - (double)idle_diff / total_diff * 100.0;
+
     /* 限制范围 0-100 */
     if (usage < 0) usage = 0;
     if (usage > 100) usage = 100;
-    
+
     return usage;
 }
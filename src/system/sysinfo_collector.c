@@ -0,0 +1,248 @@
+/**
+ * @file sysinfo_collector.c
+ * @brief 系统信息后台采集器实现
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "sysinfo_collector.h"
+
+#define NEVER_DUE  (-1LL)
+
+static const int g_refresh_ms[SYSINFO_GROUP_COUNT] = {
+    [SYSINFO_GROUP_UNAME]    = SYSINFO_REFRESH_ONCE,
+    [SYSINFO_GROUP_SERIAL]   = SYSINFO_REFRESH_ONCE,
+    [SYSINFO_GROUP_MEMORY]   = SYSINFO_REFRESH_FAST_MS,
+    [SYSINFO_GROUP_UPTIME]   = SYSINFO_REFRESH_FAST_MS,
+    [SYSINFO_GROUP_CPU]      = SYSINFO_REFRESH_FAST_MS,
+    [SYSINFO_GROUP_THERMAL]  = SYSINFO_REFRESH_RADIO_MS,
+    [SYSINFO_GROUP_BATTERY]  = SYSINFO_REFRESH_SLOT_MS,
+    [SYSINFO_GROUP_WIFI]     = SYSINFO_REFRESH_SLOW_MS,
+    [SYSINFO_GROUP_SLOT]     = SYSINFO_REFRESH_SLOT_MS,
+    [SYSINFO_GROUP_SIGNAL]   = SYSINFO_REFRESH_SIGNAL_MS,
+    [SYSINFO_GROUP_IDENTITY] = SYSINFO_REFRESH_IDENTITY_MS,
+    [SYSINFO_GROUP_AIRPLANE] = SYSINFO_REFRESH_RADIO_MS,
+    [SYSINFO_GROUP_NET_MODE] = SYSINFO_REFRESH_SLOW_MS,
+    [SYSINFO_GROUP_SERVING]  = SYSINFO_REFRESH_RADIO_MS,
+    [SYSINFO_GROUP_QOS]      = SYSINFO_REFRESH_SLOW_MS,
+};
+
+static pthread_mutex_t g_collector_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_collector_cond;
+static pthread_t g_collector_thread;
+static int g_collector_running = 0;
+
+/* 以下均受 g_collector_mutex 保护 */
+static SystemInfo g_snapshot;
+static long long g_updated_ms[SYSINFO_GROUP_COUNT];  /* 上次采集完成时间, 0 表示未采集 */
+static long long g_due_ms[SYSINFO_GROUP_COUNT];      /* 下次采集时间, NEVER_DUE 表示不再采集 */
+static long long g_demand_ms[SYSINFO_GROUP_COUNT];   /* 上次被请求的时间 */
+static unsigned int g_parked;                        /* 因无人读取而暂停的分组 */
+
+/*============================================================================
+ * 时间
+ *============================================================================*/
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void ms_to_timespec(long long ms, struct timespec *ts) {
+    ts->tv_sec = (time_t)(ms / 1000);
+    ts->tv_nsec = (long)(ms % 1000) * 1000000L;
+}
+
+/*============================================================================
+ * 采集线程
+ *============================================================================*/
+
+/**
+ * 采集一批分组：在锁外探测（oFono 查询并发执行），完成后把各组字段合并进快照
+ */
+static void collect_groups(unsigned int mask) {
+    SystemInfo scratch;
+
+    pthread_mutex_lock(&g_collector_mutex);
+    scratch = g_snapshot;
+    pthread_mutex_unlock(&g_collector_mutex);
+
+    unsigned int ok = sysinfo_probe_groups(mask, &scratch);
+    long long now = now_ms();
+
+    pthread_mutex_lock(&g_collector_mutex);
+
+    /* 数据卡槽变化后身份信息和网络模式立即重新采集 */
+    if ((mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_SLOT)) && g_updated_ms[SYSINFO_GROUP_SLOT] != 0 &&
+        strcmp(g_snapshot.network_mode, scratch.network_mode) != 0) {
+        printf("[SYSINFO] 数据卡槽变化: %s -> %s\n", g_snapshot.network_mode, scratch.network_mode);
+        if (!(mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_IDENTITY))) g_due_ms[SYSINFO_GROUP_IDENTITY] = now;
+        if (!(mask & SYSINFO_GROUP_BIT(SYSINFO_GROUP_NET_MODE))) g_due_ms[SYSINFO_GROUP_NET_MODE] = now;
+    }
+
+    for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+        if (!(mask & SYSINFO_GROUP_BIT(g))) continue;
+
+        sysinfo_copy_group((SysinfoGroup)g, &g_snapshot, &scratch);
+        g_updated_ms[g] = now;
+
+        /* 探测期间收到刷新请求时 g_due_ms 已被重新设置，保留该请求 */
+        if (g_due_ms[g] == NEVER_DUE) {
+            if (g_refresh_ms[g] == SYSINFO_REFRESH_ONCE) {
+                g_due_ms[g] = (ok & SYSINFO_GROUP_BIT(g)) ? NEVER_DUE : now + SYSINFO_RETRY_MS;
+            } else {
+                g_due_ms[g] = now + g_refresh_ms[g];
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&g_collector_mutex);
+}
+
+static void *collector_thread_func(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_collector_mutex);
+    while (g_collector_running) {
+        long long now = now_ms();
+        long long wake = NEVER_DUE;
+        unsigned int mask = 0;
+
+        /* 所有到期的组一起采集，oFono 查询可以并发 */
+        for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+            if (g_due_ms[g] == NEVER_DUE) continue;
+            if (g_due_ms[g] <= now) {
+                /* 采集过且长时间没人读取的周期分组暂停，等下次请求 */
+                if (g_refresh_ms[g] != SYSINFO_REFRESH_ONCE && g_updated_ms[g] != 0 &&
+                    now - g_demand_ms[g] > SYSINFO_IDLE_MS) {
+                    g_due_ms[g] = NEVER_DUE;
+                    g_parked |= SYSINFO_GROUP_BIT(g);
+                    continue;
+                }
+                mask |= SYSINFO_GROUP_BIT(g);
+            } else if (wake == NEVER_DUE || g_due_ms[g] < wake) {
+                wake = g_due_ms[g];
+            }
+        }
+
+        if (mask) {
+            for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+                if (mask & SYSINFO_GROUP_BIT(g)) g_due_ms[g] = NEVER_DUE;  /* 采集中 */
+            }
+            pthread_mutex_unlock(&g_collector_mutex);
+            collect_groups(mask);
+            pthread_mutex_lock(&g_collector_mutex);
+            continue;
+        }
+
+        if (wake == NEVER_DUE) {
+            pthread_cond_wait(&g_collector_cond, &g_collector_mutex);
+        } else {
+            struct timespec ts;
+            ms_to_timespec(wake, &ts);
+            pthread_cond_timedwait(&g_collector_cond, &g_collector_mutex, &ts);
+        }
+    }
+    pthread_mutex_unlock(&g_collector_mutex);
+    return NULL;
+}
+
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
+
+int sysinfo_collector_start(void) {
+    pthread_condattr_t attr;
+
+    if (g_collector_running) {
+        return 0;
+    }
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&g_collector_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    sysinfo_init_defaults(&g_snapshot);
+    long long now = now_ms();
+    for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+        g_updated_ms[g] = 0;
+        g_due_ms[g] = now;
+        g_demand_ms[g] = now;
+    }
+    g_parked = 0;
+
+    g_collector_running = 1;
+    if (pthread_create(&g_collector_thread, NULL, collector_thread_func, NULL) != 0) {
+        printf("[SYSINFO] 启动系统信息采集线程失败\n");
+        g_collector_running = 0;
+        pthread_cond_destroy(&g_collector_cond);
+        return -1;
+    }
+
+    printf("[SYSINFO] 系统信息采集线程已启动\n");
+    return 0;
+}
+
+void sysinfo_collector_stop(void) {
+    pthread_mutex_lock(&g_collector_mutex);
+    if (!g_collector_running) {
+        pthread_mutex_unlock(&g_collector_mutex);
+        return;
+    }
+    g_collector_running = 0;
+    pthread_cond_broadcast(&g_collector_cond);
+    pthread_mutex_unlock(&g_collector_mutex);
+
+    pthread_join(g_collector_thread, NULL);
+    pthread_cond_destroy(&g_collector_cond);
+    printf("[SYSINFO] 系统信息采集线程已停止\n");
+}
+
+/* 记录需求，恢复已暂停的分组（需持有锁） */
+static void demand_groups_locked(unsigned int mask, long long now) {
+    for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+        if (!(mask & SYSINFO_GROUP_BIT(g))) continue;
+        g_demand_ms[g] = now;
+        if (g_parked & SYSINFO_GROUP_BIT(g)) {
+            g_parked &= ~SYSINFO_GROUP_BIT(g);
+            g_due_ms[g] = now;
+            pthread_cond_signal(&g_collector_cond);
+        }
+    }
+}
+
+int sysinfo_collector_snapshot(SystemInfo *info, long long age_ms[SYSINFO_GROUP_COUNT], unsigned int mask) {
+    pthread_mutex_lock(&g_collector_mutex);
+    if (!g_collector_running) {
+        pthread_mutex_unlock(&g_collector_mutex);
+        return -1;
+    }
+    demand_groups_locked(mask, now_ms());
+
+    *info = g_snapshot;
+    if (age_ms) {
+        long long now = now_ms();
+        for (int g = 0; g < SYSINFO_GROUP_COUNT; g++) {
+            age_ms[g] = g_updated_ms[g] ? now - g_updated_ms[g] : -1;
+        }
+    }
+    pthread_mutex_unlock(&g_collector_mutex);
+    return 0;
+}
+
+void sysinfo_collector_refresh(SysinfoGroup group) {
+    if (group < 0 || group >= SYSINFO_GROUP_COUNT) return;
+
+    pthread_mutex_lock(&g_collector_mutex);
+    if (g_collector_running) {
+        g_parked &= ~SYSINFO_GROUP_BIT(group);
+        g_due_ms[group] = now_ms();
+        pthread_cond_signal(&g_collector_cond);
+    }
+    pthread_mutex_unlock(&g_collector_mutex);
+}
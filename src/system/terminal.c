@@ -0,0 +1,406 @@
+/**
+ * @file terminal.c
+ * @brief Web终端实现 - PTY会话与WebSocket之间的双向转发
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+#include <glib.h>
+#include <glib-unix.h>
+#include "mongoose.h"
+#include "terminal.h"
+#include "http_server.h"
+#include "http_utils.h"
+
+/* 每次从PTY读取的块大小 */
+#define TERMINAL_READ_CHUNK  4096
+
+typedef struct {
+    int in_use;
+    unsigned long conn_id;      /* 0 表示连接已关闭，等待Shell退出 */
+    GPid pid;
+    int master;                 /* PTY主设备，已关闭为 -1 */
+    guint read_id;              /* 0 表示未监听（背压暂停或已EOF） */
+    guint write_id;
+    guint kill_id;
+    int eof;
+    GByteArray *input;          /* 尚未写入PTY的输入 */
+} TermSession;
+
+static TermSession g_sessions[TERMINAL_MAX_SESSIONS];
+
+/*============================================================================
+ * 会话管理
+ *============================================================================*/
+
+static TermSession *find_session(unsigned long conn_id) {
+    for (int i = 0; i < TERMINAL_MAX_SESSIONS; i++) {
+        if (g_sessions[i].in_use && g_sessions[i].conn_id == conn_id) {
+            return &g_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+static TermSession *alloc_session(void) {
+    for (int i = 0; i < TERMINAL_MAX_SESSIONS; i++) {
+        if (!g_sessions[i].in_use) {
+            return &g_sessions[i];
+        }
+    }
+    return NULL;
+}
+
+/* 停止监听并关闭PTY主设备（Shell所在会话会收到 SIGHUP） */
+static void session_close_pty(TermSession *s) {
+    if (s->read_id) {
+        g_source_remove(s->read_id);
+        s->read_id = 0;
+    }
+    if (s->write_id) {
+        g_source_remove(s->write_id);
+        s->write_id = 0;
+    }
+    if (s->master >= 0) {
+        close(s->master);
+        s->master = -1;
+    }
+}
+
+/* 释放会话槽位（Shell已回收） */
+static void session_free(TermSession *s) {
+    session_close_pty(s);
+    if (s->kill_id) {
+        g_source_remove(s->kill_id);
+    }
+    if (s->input) {
+        g_byte_array_free(s->input, TRUE);
+    }
+    g_spawn_close_pid(s->pid);
+    memset(s, 0, sizeof(*s));
+}
+
+/*============================================================================
+ * PTY与Shell
+ *============================================================================*/
+
+/**
+ * 打开PTY主设备并解锁从设备
+ * 直接使用 /dev/ptmx 和 TIOCSPTLCK/TIOCGPTN，无需 posix_openpt 所需的特性宏
+ */
+static int open_pty(int *master, char *slave, size_t size) {
+    int fd = open("/dev/ptmx", O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (fd < 0) {
+        printf("[TERM] 打开 /dev/ptmx 失败: %s\n", strerror(errno));
+        return -1;
+    }
+
+    int unlock = 0;
+    unsigned int index = 0;
+    if (ioctl(fd, TIOCSPTLCK, &unlock) != 0 || ioctl(fd, TIOCGPTN, &index) != 0) {
+        printf("[TERM] 初始化PTY失败: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    snprintf(slave, size, "/dev/pts/%u", index);
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    *master = fd;
+    return 0;
+}
+
+/**
+ * 在新会话中启动Shell，PTY从设备作为控制终端
+ * posix_spawn 无法设置控制终端，这里使用 fork；每个会话只启动一次
+ */
+static int spawn_shell(const char *slave, GPid *pid) {
+    extern char **environ;
+    static const int reset_signals[] = { SIGPIPE, SIGINT, SIGTERM, SIGHUP, SIGQUIT, SIGCHLD };
+
+    /* fork 之后只能调用异步信号安全函数，环境变量在父进程中准备好 */
+    GPtrArray *env = g_ptr_array_new();
+    for (char **e = environ; *e; e++) {
+        if (strncmp(*e, "TERM=", 5) != 0) {
+            g_ptr_array_add(env, *e);
+        }
+    }
+    g_ptr_array_add(env, "TERM=" TERMINAL_TERM);
+    g_ptr_array_add(env, NULL);
+
+    pid_t child = fork();
+    if (child < 0) {
+        printf("[TERM] fork 失败: %s\n", strerror(errno));
+        g_ptr_array_free(env, TRUE);
+        return -1;
+    }
+
+    if (child == 0) {
+        struct sigaction sa;
+        sigset_t mask;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = SIG_DFL;
+        for (size_t i = 0; i < sizeof(reset_signals) / sizeof(reset_signals[0]); i++) {
+            sigaction(reset_signals[i], &sa, NULL);
+        }
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, NULL);
+
+        /* 新会话中第一个打开的终端成为控制终端 */
+        setsid();
+        int fd = open(slave, O_RDWR);
+        if (fd < 0) {
+            _exit(127);
+        }
+        ioctl(fd, TIOCSCTTY, 0);
+        dup2(fd, STDIN_FILENO);
+        dup2(fd, STDOUT_FILENO);
+        dup2(fd, STDERR_FILENO);
+        if (fd > STDERR_FILENO) {
+            close(fd);
+        }
+
+        execle(TERMINAL_SHELL, "sh", "-l", (char *)NULL, (char **)env->pdata);
+        _exit(127);
+    }
+
+    g_ptr_array_free(env, TRUE);
+    *pid = child;
+    return 0;
+}
+
+static void set_window_size(TermSession *s, int cols, int rows) {
+    struct winsize ws;
+
+    if (s->master < 0 || cols <= 0 || rows <= 0 || cols > 1000 || rows > 1000) {
+        return;
+    }
+    memset(&ws, 0, sizeof(ws));
+    ws.ws_col = (unsigned short)cols;
+    ws.ws_row = (unsigned short)rows;
+    ioctl(s->master, TIOCSWINSZ, &ws);  /* 内核向前台进程组发送 SIGWINCH */
+}
+
+/*============================================================================
+ * 数据转发
+ *============================================================================*/
+
+/**
+ * 读取一块PTY输出并发送到连接
+ * @return 1 还有数据可读, 0 暂无数据, -1 EOF或出错
+ */
+static int forward_output(TermSession *s, struct mg_connection *c) {
+    char buf[TERMINAL_READ_CHUNK];
+
+    ssize_t n = read(s->master, buf, sizeof(buf));
+    if (n < 0) {
+        if (errno == EINTR) return 1;
+        return errno == EAGAIN ? 0 : -1;  /* 从设备全部关闭后 Linux 返回 EIO */
+    }
+    if (n == 0) {
+        return -1;
+    }
+    if (c) {
+        mg_ws_send(c, buf, (size_t)n, WEBSOCKET_OP_BINARY);
+    }
+    return 1;
+}
+
+static gboolean on_pty_readable(gint fd, GIOCondition condition, gpointer data) {
+    TermSession *s = (TermSession *)data;
+    struct mg_connection *c = http_server_find_conn(s->conn_id);
+    (void)fd;
+    (void)condition;
+
+    int ret = forward_output(s, c);
+    if (ret < 0) {
+        /* Shell 退出由子进程监听处理 */
+        s->eof = 1;
+        s->read_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+
+    /* 背压: 客户端接收过慢时暂停读取，PTY缓冲写满后Shell自然阻塞 */
+    if (c && c->send.len > TERMINAL_SEND_HIGH_WATER) {
+        s->read_id = 0;
+        return G_SOURCE_REMOVE;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void flush_input(TermSession *s);
+
+static gboolean on_pty_writable(gint fd, GIOCondition condition, gpointer data) {
+    TermSession *s = (TermSession *)data;
+    (void)fd;
+    (void)condition;
+
+    s->write_id = 0;
+    flush_input(s);
+    return G_SOURCE_REMOVE;
+}
+
+/* 将缓存的输入写入PTY，写不下时等待可写 */
+static void flush_input(TermSession *s) {
+    while (s->input->len > 0 && s->master >= 0) {
+        ssize_t n = write(s->master, s->input->data, s->input->len);
+        if (n > 0) {
+            g_byte_array_remove_range(s->input, 0, (guint)n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            if (!s->write_id) {
+                s->write_id = g_unix_fd_add(s->master, G_IO_OUT, on_pty_writable, s);
+            }
+            return;
+        }
+        g_byte_array_set_size(s->input, 0);  /* PTY已失效，丢弃 */
+        return;
+    }
+}
+
+static gboolean on_kill_grace(gpointer data) {
+    TermSession *s = (TermSession *)data;
+    s->kill_id = 0;
+    kill(-s->pid, SIGKILL);
+    return G_SOURCE_REMOVE;
+}
+
+/* Shell退出: 发送剩余输出后关闭WebSocket */
+static void on_shell_exit(GPid pid, gint status, gpointer data) {
+    TermSession *s = (TermSession *)data;
+    (void)status;
+
+    struct mg_connection *c = s->conn_id ? http_server_find_conn(s->conn_id) : NULL;
+    if (c) {
+        while (s->master >= 0 && !s->eof && forward_output(s, c) > 0) {
+        }
+        mg_ws_send(c, "", 0, WEBSOCKET_OP_CLOSE);
+        c->is_draining = 1;
+    }
+
+    printf("[TERM] 终端会话结束, pid=%d\n", (int)pid);
+    session_free(s);
+}
+
+/*============================================================================
+ * 对外接口
+ *============================================================================*/
+
+void handle_terminal_ws(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    /* 缺少握手头时 mg_ws_upgrade 只回 426 而不升级，关闭时不会走 WebSocket 清理，
+     * 必须在创建 PTY 和 Shell 之前拒绝 */
+    if (mg_http_get_header(hm, "Sec-WebSocket-Key") == NULL) {
+        HTTP_ERROR(c, 400, "需要 WebSocket 连接");
+        return;
+    }
+
+    TermSession *s = alloc_session();
+    if (!s) {
+        HTTP_ERROR(c, 503, "终端会话数已达上限");
+        return;
+    }
+
+    char slave[32];
+    int master;
+    GPid pid;
+    if (open_pty(&master, slave, sizeof(slave)) != 0) {
+        HTTP_ERROR(c, 500, "创建终端失败");
+        return;
+    }
+    if (spawn_shell(slave, &pid) != 0) {
+        close(master);
+        HTTP_ERROR(c, 500, "启动Shell失败");
+        return;
+    }
+
+    memset(s, 0, sizeof(*s));
+    s->in_use = 1;
+    s->conn_id = c->id;
+    s->pid = pid;
+    s->master = master;
+    s->input = g_byte_array_new();
+    set_window_size(s, 80, 24);
+
+    s->read_id = g_unix_fd_add(master, G_IO_IN | G_IO_HUP | G_IO_ERR, on_pty_readable, s);
+    g_child_watch_add(pid, on_shell_exit, s);
+
+    mg_ws_upgrade(c, hm, NULL);
+    printf("[TERM] 终端会话已创建, pid=%d, conn=%lu\n", (int)pid, c->id);
+}
+
+void terminal_ws_message(struct mg_connection *c, struct mg_ws_message *wm) {
+    TermSession *s = find_session(c->id);
+    if (!s || s->master < 0 || wm->data.len < 1) {
+        return;
+    }
+
+    const char *payload = wm->data.buf + 1;
+    size_t len = wm->data.len - 1;
+
+    switch (wm->data.buf[0]) {
+    case '0':
+        if (s->input->len + len > TERMINAL_INPUT_MAX) {
+            printf("[TERM] 输入缓冲已满，丢弃 %lu 字节\n", (unsigned long)len);
+            return;
+        }
+        g_byte_array_append(s->input, (const guint8 *)payload, (guint)len);
+        flush_input(s);
+        break;
+    case '1': {
+        struct mg_str json = mg_str_n(payload, len);
+        set_window_size(s, (int)mg_json_get_long(json, "$.cols", 0),
+                        (int)mg_json_get_long(json, "$.rows", 0));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void terminal_ws_poll(struct mg_connection *c) {
+    TermSession *s = find_session(c->id);
+    if (!s || s->read_id || s->eof || s->master < 0) {
+        return;
+    }
+    if (c->send.len < TERMINAL_SEND_LOW_WATER) {
+        s->read_id = g_unix_fd_add(s->master, G_IO_IN | G_IO_HUP | G_IO_ERR, on_pty_readable, s);
+    }
+}
+
+void terminal_ws_close(struct mg_connection *c) {
+    TermSession *s = find_session(c->id);
+    if (!s) {
+        return;
+    }
+
+    /* 关闭PTY使会话收到 SIGHUP，宽限期后仍未退出则强制结束；槽位在Shell回收后释放 */
+    s->conn_id = 0;
+    session_close_pty(s);
+    kill(-s->pid, SIGHUP);
+    s->kill_id = g_timeout_add(TERMINAL_KILL_GRACE_MS, on_kill_grace, s);
+}
+
+void terminal_shutdown(void) {
+    for (int i = 0; i < TERMINAL_MAX_SESSIONS; i++) {
+        TermSession *s = &g_sessions[i];
+        if (s->in_use) {
+            s->conn_id = 0;
+            kill(-s->pid, SIGKILL);
+            session_close_pty(s);
+        }
+    }
+}
@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <time.h>
 #include <pthread.h>
 #include <sys/stat.h>
 #include <glib.h>
@@ -17,6 +18,7 @@
 #include "airplane.h"  /* 飞行模式控制 */
 #include "http_utils.h"
 #include "json_builder.h"
+#include "http_server.h"
 
 #define VNSTAT_DB "/var/lib/vnstat/vnstat.db"
 #define NETWORK_IFACE "sipa_eth0"
@@ -24,6 +26,15 @@
 static int is_flow_control_running = 0;
 static pthread_t flow_control_thread;
 
+/* 流量控制线程的检查间隔，配置变更时提前唤醒 */
+#define FLOW_CONTROL_INTERVAL_SEC 15
+
+/* vnstat 查询超时（秒） */
+#define VNSTAT_TIMEOUT_SEC 10
+#define VNSTAT_OUTPUT_SIZE 16384  /* vnstat --json 输出缓冲区 */
+static pthread_mutex_t flow_control_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t flow_control_cond = PTHREAD_COND_INITIALIZER;
+
 /* 流量配置 */
 typedef struct {
     long long much;
@@ -45,21 +56,29 @@ static void save_traffic_config(TrafficConfig *config) {
 }
 
 
-/* 从 vnstat 获取流量数据 */
+/* 解析 vnstat --json 输出 - 使用mongoose JSON API */
+static void parse_vnstat_json(const char *output, long long *rx, long long *tx) {
+    struct mg_str json = mg_str(output);
+    *rx = mg_json_get_long(json, "$.interfaces[0].traffic.total.rx", 0);
+    *tx = mg_json_get_long(json, "$.interfaces[0].traffic.total.tx", 0);
+}
+
+/**
+ * 从 vnstat 获取流量数据（同步，仅在流量控制线程中使用）
+ * 带小时/日/月历史的输出经常超过缓冲区；traffic.total 位于 JSON 开头，
+ * 截断的输出仍可解析，因此 EXEC_TRUNCATED 也接受
+ */
 static void get_traffic_from_vnstat(long long *rx, long long *tx) {
-    char output[4096];
+    char *output = g_malloc(VNSTAT_OUTPUT_SIZE);
     *rx = 0;
     *tx = 0;
 
-    if (run_command(output, sizeof(output), "/home/root/6677/vnstat", 
-                    "-i", NETWORK_IFACE, "--json", NULL) != 0) {
-        return;
+    int rc = run_command_timeout(VNSTAT_TIMEOUT_SEC, output, VNSTAT_OUTPUT_SIZE, "/home/root/6677/vnstat",
+                                 "-i", NETWORK_IFACE, "--json", NULL);
+    if (rc == EXEC_OK || rc == EXEC_TRUNCATED) {
+        parse_vnstat_json(output, rx, tx);
     }
-
-    /* 使用mongoose JSON API解析 */
-    struct mg_str json = mg_str(output);
-    *rx = mg_json_get_long(json, "$.interfaces[0].traffic.total.rx", 0);
-    *tx = mg_json_get_long(json, "$.interfaces[0].traffic.total.tx", 0);
+    g_free(output);
 }
 
 /* 格式化字节数 */
@@ -95,11 +114,26 @@ static void *flow_control_thread_func(void *arg) {
         } else {
             set_airplane_mode(0);  /* 流量正常，关闭飞行模式 */
         }
-        sleep(15);
+
+        /* 等待下一个周期，或被配置变更唤醒 */
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += FLOW_CONTROL_INTERVAL_SEC;
+        pthread_mutex_lock(&flow_control_mutex);
+        pthread_cond_timedwait(&flow_control_cond, &flow_control_mutex, &deadline);
+        pthread_mutex_unlock(&flow_control_mutex);
     }
     return NULL;
 }
 
+/* 流量配置变更回调 - 唤醒流量控制线程立即重新检查 */
+static void on_traffic_config_changed(const char *key, const char *value, void *user_data) {
+    (void)key; (void)value; (void)user_data;
+    pthread_mutex_lock(&flow_control_mutex);
+    pthread_cond_signal(&flow_control_cond);
+    pthread_mutex_unlock(&flow_control_mutex);
+}
+
 /* 初始化 vnstat 数据库 */
 static void init_vnstat_db(void) {
     struct stat st;
@@ -116,6 +150,7 @@ static void init_vnstat_db(void) {
 /* 初始化流量统计 */
 void init_traffic(void) {
     init_vnstat_db();
+    config_add_listener("traffic_", on_traffic_config_changed, NULL);
 
     /* 启动流量控制 */
     TrafficConfig config = read_traffic_config();
@@ -128,12 +163,17 @@ void init_traffic(void) {
 }
 
 
-/* GET /api/get/Total - 获取流量统计 */
-void handle_get_traffic_total(struct mg_connection *c, struct mg_http_message *hm) {
-    HTTP_CHECK_GET(c, hm);
+static void traffic_total_done(int result, const char *output, void *user_data) {
+    struct mg_connection *c = http_server_find_conn(GPOINTER_TO_SIZE(user_data));
+    long long rx = 0, tx = 0;
 
-    long long rx, tx;
-    get_traffic_from_vnstat(&rx, &tx);
+    if (!c) {
+        return;
+    }
+    /* 与 get_traffic_from_vnstat 相同，超过输出上限被截断时 traffic.total 仍可解析 */
+    if (result == EXEC_OK || result == EXEC_TRUNCATED) {
+        parse_vnstat_json(output, &rx, &tx);
+    }
 
     char rx_str[32], tx_str[32], total_str[32];
     format_bytes(rx, rx_str, sizeof(rx_str));
@@ -149,6 +189,17 @@ void handle_get_traffic_total(struct mg_connection *c, struct mg_http_message *h
     HTTP_OK_FREE(c, json_finish(j));
 }
 
+/* GET /api/get/Total - 获取流量统计 */
+void handle_get_traffic_total(struct mg_connection *c, struct mg_http_message *hm) {
+    HTTP_CHECK_GET(c, hm);
+
+    /* vnstat 异步执行，只捕获标准输出（警告信息不能混进 JSON），启动失败时按无数据回复 */
+    if (run_command_async_stdout(VNSTAT_TIMEOUT_SEC, 0, traffic_total_done, GSIZE_TO_POINTER(c->id),
+                                 "/home/root/6677/vnstat", "-i", NETWORK_IFACE, "--json", NULL) != 0) {
+        traffic_total_done(EXEC_ERROR, "", GSIZE_TO_POINTER(c->id));
+    }
+}
+
 /* GET /api/get/set - 获取流量配置 */
 void handle_get_traffic_config(struct mg_connection *c, struct mg_http_message *hm) {
     HTTP_CHECK_GET(c, hm);
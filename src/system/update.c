@@ -9,51 +9,219 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <glib.h>
 #include "update.h"
 #include "exec_utils.h"
 #include "mongoose.h"
 
+/* 外部命令超时（秒） */
+#define UPDATE_DOWNLOAD_TIMEOUT_SEC  600
+#define UPDATE_CHECK_TIMEOUT_SEC     20
+#define UPDATE_EXTRACT_TIMEOUT_SEC   120
+#define UPDATE_INSTALL_TIMEOUT_SEC   300
+
 /* 获取当前版本 */
 const char* update_get_version(void) {
     return FIRMWARE_VERSION;
 }
 
-/* 从URL下载更新包 */
-int update_download(const char *url) {
-    char output[1024];
-    
-    if (!url || strlen(url) == 0) {
+/*============================================================================
+ * 异步更新任务
+ *
+ * 每个步骤先执行主命令，失败后执行一次备用命令（curl→wget, unzip→busybox unzip）
+ *============================================================================*/
+
+/* 命令输出上限 */
+#define UPDATE_OUTPUT_MAX        2048
+#define UPDATE_CHECK_OUTPUT_MAX  4096
+
+typedef enum {
+    UPDATE_STEP_DOWNLOAD,
+    UPDATE_STEP_EXTRACT,
+    UPDATE_STEP_INSTALL,
+    UPDATE_STEP_CHECK
+} UpdateStep;
+
+typedef struct {
+    UpdateStep step;
+    int attempt;                    /* 0 主命令, 1 备用命令 */
+    char *url;
+    update_done_func done;
+    update_check_func check_done;
+    void *user_data;
+} UpdateTask;
+
+/* 下载/解压/安装互斥，避免并发请求同时改写更新文件 */
+static int g_update_busy = 0;
+
+static void on_update_command_done(int result, const char *output, void *user_data);
+
+/* 启动当前步骤的命令 */
+static int start_update_command(UpdateTask *task) {
+    switch (task->step) {
+    case UPDATE_STEP_DOWNLOAD:
+        if (task->attempt == 0) {
+            return run_command_async(UPDATE_DOWNLOAD_TIMEOUT_SEC, UPDATE_OUTPUT_MAX, on_update_command_done, task,
+                                     "curl", "-k", "-s", "-L", "-o", UPDATE_ZIP_PATH, task->url, NULL);
+        }
+        return run_command_async(UPDATE_DOWNLOAD_TIMEOUT_SEC, UPDATE_OUTPUT_MAX, on_update_command_done, task,
+                                 "wget", "--no-check-certificate", "-q", "-O", UPDATE_ZIP_PATH, task->url, NULL);
+    case UPDATE_STEP_EXTRACT:
+        if (task->attempt == 0) {
+            return run_command_async(UPDATE_EXTRACT_TIMEOUT_SEC, UPDATE_OUTPUT_MAX, on_update_command_done, task,
+                                     "unzip", "-o", UPDATE_ZIP_PATH, "-d", UPDATE_EXTRACT_DIR, NULL);
+        }
+        return run_command_async(UPDATE_EXTRACT_TIMEOUT_SEC, UPDATE_OUTPUT_MAX, on_update_command_done, task,
+                                 "busybox", "unzip", "-o", UPDATE_ZIP_PATH, "-d", UPDATE_EXTRACT_DIR, NULL);
+    case UPDATE_STEP_INSTALL:
+        if (task->attempt == 0) {
+            return run_command_async(UPDATE_INSTALL_TIMEOUT_SEC, UPDATE_OUTPUT_MAX, on_update_command_done, task,
+                                     "sh", UPDATE_INSTALL_SCRIPT, NULL);
+        }
         return -1;
+    case UPDATE_STEP_CHECK:
+        if (task->attempt == 0) {
+            return run_command_async(UPDATE_CHECK_TIMEOUT_SEC, UPDATE_CHECK_OUTPUT_MAX, on_update_command_done, task,
+                                     "curl", "-k", "-s", "-L", task->url, NULL);
+        }
+        return run_command_async(UPDATE_CHECK_TIMEOUT_SEC, UPDATE_CHECK_OUTPUT_MAX, on_update_command_done, task,
+                                 "wget", "--no-check-certificate", "-q", "-O", "-", task->url, NULL);
     }
+    return -1;
+}
+
+/* 解析版本信息 - 使用mongoose JSON API */
+static int parse_version_info(const char *output, update_info_t *info) {
+    struct mg_str json = mg_str(output);
     
-    /* 清理旧文件 */
-    update_cleanup();
+    /* 提取version字段 */
+    char *version = mg_json_get_str(json, "$.version");
+    if (version) {
+        strncpy(info->version, version, sizeof(info->version) - 1);
+        free(version);
+    }
     
-    /* 优先使用curl（更常见），失败再用wget */
-    int ret = run_command(output, sizeof(output), "curl", "-k", "-s", "-L", "-o", UPDATE_ZIP_PATH, url, NULL);
-    if (ret != 0) {
-        ret = run_command(output, sizeof(output), "wget", "--no-check-certificate", "-q", "-O", UPDATE_ZIP_PATH, url, NULL);
-        if (ret != 0) {
-            return -1;
-        }
+    /* 提取url字段 */
+    char *url = mg_json_get_str(json, "$.url");
+    if (url) {
+        strncpy(info->url, url, sizeof(info->url) - 1);
+        free(url);
     }
     
-    /* 检查文件是否存在 */
-    struct stat st;
-    if (stat(UPDATE_ZIP_PATH, &st) != 0 || st.st_size == 0) {
+    /* 提取changelog字段 */
+    char *changelog = mg_json_get_str(json, "$.changelog");
+    if (changelog) {
+        strncpy(info->changelog, changelog, sizeof(info->changelog) - 1);
+        free(changelog);
+    }
+    
+    /* 提取size字段 */
+    info->size = (size_t)mg_json_get_long(json, "$.size", 0);
+    
+    /* 提取required字段 */
+    bool required = false;
+    mg_json_get_bool(json, "$.required", &required);
+    info->required = required ? 1 : 0;
+    
+    if (strlen(info->version) == 0) {
         return -1;
     }
     
     return 0;
 }
 
+static void on_update_command_done(int result, const char *output, void *user_data) {
+    UpdateTask *task = (UpdateTask *)user_data;
+    int ok;
+
+    /* 版本检查需要完整的JSON；其余步骤的输出被截断不算失败 */
+    if (task->step == UPDATE_STEP_CHECK) {
+        ok = (result == EXEC_OK);
+    } else {
+        ok = (result == EXEC_OK || result == EXEC_TRUNCATED);
+    }
+
+    /* 主命令失败，改用备用命令 */
+    if (!ok && task->attempt == 0 && task->step != UPDATE_STEP_INSTALL) {
+        task->attempt = 1;
+        if (start_update_command(task) == 0) {
+            return;
+        }
+    }
+
+    if (task->step == UPDATE_STEP_CHECK) {
+        update_info_t info;
+        memset(&info, 0, sizeof(info));
+        int ret = (ok && parse_version_info(output, &info) == 0) ? 0 : -1;
+        task->check_done(ret, &info, task->user_data);
+    } else {
+        g_update_busy = 0;
+
+        if (ok && task->step == UPDATE_STEP_DOWNLOAD) {
+            /* 检查文件是否存在 */
+            struct stat st;
+            if (stat(UPDATE_ZIP_PATH, &st) != 0 || st.st_size == 0) {
+                ok = 0;
+            }
+        }
+        if (result == EXEC_TIMEOUT && task->step == UPDATE_STEP_INSTALL) {
+            output = "安装脚本执行超时";
+        }
+        printf("[UPDATE] 步骤 %d %s\n", task->step, ok ? "完成" : "失败");
+        if (task->done) {
+            task->done(ok ? 0 : -1, output, task->user_data);
+        }
+    }
+
+    g_free(task->url);
+    g_free(task);
+}
+
+/* 创建任务并启动第一个命令 */
+static int start_update_task(UpdateStep step, const char *url, update_done_func done,
+                             update_check_func check_done, void *user_data) {
+    UpdateTask *task = g_new0(UpdateTask, 1);
+    task->step = step;
+    task->url = g_strdup(url);
+    task->done = done;
+    task->check_done = check_done;
+    task->user_data = user_data;
+
+    if (start_update_command(task) != 0) {
+        g_free(task->url);
+        g_free(task);
+        return -1;
+    }
+    if (step != UPDATE_STEP_CHECK) {
+        g_update_busy = 1;
+    }
+    return 0;
+}
+
+int update_is_busy(void) {
+    return g_update_busy;
+}
+
+/* 从URL下载更新包 */
+int update_download_async(const char *url, update_done_func done, void *user_data) {
+    if (!url || strlen(url) == 0 || g_update_busy) {
+        return -1;
+    }
+    
+    /* 清理旧文件 */
+    update_cleanup();
+    
+    /* 优先使用curl（更常见），失败再用wget */
+    return start_update_task(UPDATE_STEP_DOWNLOAD, url, done, NULL, user_data);
+}
+
 /* 解压更新包 */
-int update_extract(void) {
-    char output[2048];
+int update_extract_async(update_done_func done, void *user_data) {
+    char output[256];
     struct stat st;
 
     /* 检查ZIP文件是否存在 */
-    if (stat(UPDATE_ZIP_PATH, &st) != 0) {
+    if (g_update_busy || stat(UPDATE_ZIP_PATH, &st) != 0) {
         return -1;
     }
     
@@ -61,38 +229,26 @@ int update_extract(void) {
     run_command(output, sizeof(output), "rm", "-rf", UPDATE_EXTRACT_DIR, NULL);
     run_command(output, sizeof(output), "mkdir", "-p", UPDATE_EXTRACT_DIR, NULL);
     
-    /* 解压ZIP - 优先使用unzip，失败则尝试busybox unzip */
-    int ret = run_command(output, sizeof(output), "unzip", "-o", UPDATE_ZIP_PATH, "-d", UPDATE_EXTRACT_DIR, NULL);
-    if (ret != 0) {
-        ret = run_command(output, sizeof(output), "busybox", "unzip", "-o", UPDATE_ZIP_PATH, "-d", UPDATE_EXTRACT_DIR, NULL);
-        if (ret != 0) {
-            return -1;
-        }
-    }
-    
-    return 0;
+    /* 解压ZIP - 优先使用unzip，失败则尝试busybox unzip（文件列表输出被截断不算失败） */
+    return start_update_task(UPDATE_STEP_EXTRACT, NULL, done, NULL, user_data);
 }
 
 
 /* 执行安装脚本 */
-int update_install(char *output, size_t size) {
+int update_install_async(update_done_func done, void *user_data) {
+    char output[256];
     struct stat st;
     
     /* 检查安装脚本是否存在 */
-    if (stat(UPDATE_INSTALL_SCRIPT, &st) != 0) {
-        snprintf(output, size, "安装脚本不存在");
+    if (g_update_busy || stat(UPDATE_INSTALL_SCRIPT, &st) != 0) {
         return -1;
     }
     
     /* 添加执行权限 */
-    run_command(output, size, "chmod", "+x", UPDATE_INSTALL_SCRIPT, NULL);
+    run_command(output, sizeof(output), "chmod", "+x", UPDATE_INSTALL_SCRIPT, NULL);
     
     /* 执行安装脚本 */
-    if (run_command(output, size, "sh", UPDATE_INSTALL_SCRIPT, NULL) != 0) {
-        return -1;
-    }
-    
-    return 0;
+    return start_update_task(UPDATE_STEP_INSTALL, NULL, done, NULL, user_data);
 }
 
 /* 清理更新临时文件 */
@@ -102,62 +258,13 @@ void update_cleanup(void) {
     run_command(output, sizeof(output), "rm", "-rf", UPDATE_EXTRACT_DIR, NULL);
 }
 
-/* 检查远程版本 - 使用mongoose JSON API解析响应 */
-int update_check_version(const char *check_url, update_info_t *info) {
-    char output[4096];
-    
-    if (!check_url || !info) {
-        return -1;
-    }
-    
-    memset(info, 0, sizeof(update_info_t));
-    
-    /* 优先使用curl获取版本信息，失败再用wget */
-    int ret = run_command(output, sizeof(output), "curl", "-k", "-s", "-L", check_url, NULL);
-    if (ret != 0) {
-        ret = run_command(output, sizeof(output), "wget", "--no-check-certificate", "-q", "-O", "-", check_url, NULL);
-        if (ret != 0) {
-            return -1;
-        }
-    }
-    
-    /* 使用mongoose JSON API解析 */
-    struct mg_str json = mg_str(output);
-    
-    /* 提取version字段 */
-    char *version = mg_json_get_str(json, "$.version");
-    if (version) {
-        strncpy(info->version, version, sizeof(info->version) - 1);
-        free(version);
-    }
-    
-    /* 提取url字段 */
-    char *url = mg_json_get_str(json, "$.url");
-    if (url) {
-        strncpy(info->url, url, sizeof(info->url) - 1);
-        free(url);
-    }
-    
-    /* 提取changelog字段 */
-    char *changelog = mg_json_get_str(json, "$.changelog");
-    if (changelog) {
-        strncpy(info->changelog, changelog, sizeof(info->changelog) - 1);
-        free(changelog);
-    }
-    
-    /* 提取size字段 */
-    info->size = (size_t)mg_json_get_long(json, "$.size", 0);
-    
-    /* 提取required字段 */
-    bool required = false;
-    mg_json_get_bool(json, "$.required", &required);
-    info->required = required ? 1 : 0;
-    
-    if (strlen(info->version) == 0) {
+/* 检查远程版本 - 优先使用curl获取版本信息，失败再用wget */
+int update_check_version_async(const char *check_url, update_check_func done, void *user_data) {
+    if (!check_url || !done) {
         return -1;
     }
     
-    return 0;
+    return start_update_task(UPDATE_STEP_CHECK, check_url, NULL, done, user_data);
 }
 
 
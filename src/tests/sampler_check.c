@@ -0,0 +1,260 @@
+/**
+ * @file sampler_check.c
+ * @brief 采样器自检：在临时目录中伪造 procfs/sysfs，校验各项解析结果
+ *
+ * 本机编译运行: make check
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "sampler.h"
+
+static char g_root[64];
+static int g_failed = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "[SAMPLER_CHECK] 失败 %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+        g_failed++; \
+    } \
+} while (0)
+
+/*============================================================================
+ * 伪造目录
+ *============================================================================*/
+
+static void make_dir(const char *rel) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s%s", g_root, rel);
+    mkdir(path, 0755);
+}
+
+static void write_file(const char *rel, const char *content) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s%s", g_root, rel);
+    FILE *fp = fopen(path, "w");
+    if (!fp) {
+        fprintf(stderr, "[SAMPLER_CHECK] 无法创建 %s\n", path);
+        exit(2);
+    }
+    fputs(content, fp);
+    fclose(fp);
+}
+
+static void build_tree(void) {
+    make_dir("/proc");
+    make_dir("/proc/1234");
+    make_dir("/proc/77");
+    make_dir("/proc/42");       /* 没有 stat 文件 */
+    make_dir("/proc/self");
+    make_dir("/proc/0");
+    make_dir("/proc/12a");
+    make_dir("/sys");
+    make_dir("/sys/class");
+    make_dir("/sys/class/thermal");
+    make_dir("/sys/class/thermal/thermal_zone10");
+    make_dir("/sys/class/thermal/thermal_zone2");
+    make_dir("/sys/class/thermal/thermal_zone1");   /* 没有 temp 文件 */
+    make_dir("/sys/class/thermal/cooling_device0");
+
+    /* SwapCached 不能被当成 Cached */
+    write_file("/proc/meminfo",
+               "MemTotal:        1000000 kB\n"
+               "MemFree:          200000 kB\n"
+               "MemAvailable:     500000 kB\n"
+               "Buffers:           10000 kB\n"
+               "SwapCached:          123 kB\n"
+               "Cached:           300000 kB\n"
+               "Active:           400000 kB\n");
+
+    write_file("/proc/uptime", "12345.67 23456.78\n");
+
+    write_file("/sys/class/thermal/thermal_zone10/type", "cpu-thmzone\n");
+    write_file("/sys/class/thermal/thermal_zone10/temp", "45000\n");
+    write_file("/sys/class/thermal/thermal_zone2/type", "board-thmzone\n");
+    write_file("/sys/class/thermal/thermal_zone2/temp", "-5500\n");
+    write_file("/sys/class/thermal/thermal_zone1/type", "broken\n");
+
+    /* comm 中含空格和括号，应取到最后一个 ')' */
+    char line[512];
+    int len = snprintf(line, sizeof(line), "1234 (a) b (c) S");
+    for (int field = 4; field <= 25; field++) {
+        len += snprintf(line + len, sizeof(line) - (size_t)len, " %d", field * 1000 + field);
+    }
+    snprintf(line + len, sizeof(line) - (size_t)len, "\n");
+    write_file("/proc/1234/stat", line);
+
+    /* 超长 comm 截断为15字节 */
+    write_file("/proc/77/stat",
+               "77 (0123456789abcdefgh) R 1 77 77 0 -1 4194560 0 0 0 0 "
+               "11 22 0 0 20 0 1 0 33 0 0\n");
+}
+
+/* 生成超过 4096 字节的 /proc/stat，最后一个 cpu 行被读取缓冲截断 */
+static int write_long_stat(void) {
+    static char buf[8192];
+    int len = snprintf(buf, sizeof(buf), "cpu  1 2 3 4 5 6 7 8 0 0\n");
+    int complete = 0;
+    for (int id = 0; len < 6000; id++) {
+        len += snprintf(buf + len, sizeof(buf) - (size_t)len,
+                        "cpu%d %d 0 %d 1000 0 0 0 0 0 0\n", id, id * 10, id);
+        /* 采样器只读取前 4095 字节 */
+        if (len <= 4095) complete = id + 1;
+    }
+    write_file("/proc/stat", buf);
+    return complete;
+}
+
+/*============================================================================
+ * 各项检查
+ *============================================================================*/
+
+static void check_meminfo(void) {
+    SamplerMeminfo mem;
+    CHECK(sampler_read_meminfo(&mem) == 0);
+    CHECK(mem.total == 1000000);
+    CHECK(mem.free == 200000);
+    CHECK(mem.available == 500000);
+    CHECK(mem.buffers == 10000);
+    CHECK(mem.cached == 300000);
+}
+
+static void check_stat(void) {
+    SamplerCpuTimes total, cores[4];
+
+    /* cpu1 只有4个字段，其余为0；遇到 intr 行停止 */
+    write_file("/proc/stat",
+               "cpu  10 20 30 40 50 60 70 80 0 0\n"
+               "cpu0 1 2 3 4 5 6 7 8 0 0\n"
+               "cpu1 5 6 7 8\n"
+               "intr 100 1 2 3\n"
+               "cpu2 9 9 9 9 9 9 9 9 0 0\n");
+    CHECK(sampler_init(g_root) == 0);
+
+    SamplerCpuTimes times;
+    CHECK(sampler_read_cpu(&times) == 0);
+    CHECK(times.user == 10 && times.nice == 20 && times.system == 30 && times.idle == 40);
+    CHECK(times.iowait == 50 && times.irq == 60 && times.softirq == 70 && times.steal == 80);
+
+    memset(cores, 0xff, sizeof(cores));
+    CHECK(sampler_read_cpu_cores(&total, cores, 4) == 2);
+    CHECK(total.idle == 40 && total.steal == 80);
+    CHECK(cores[0].user == 1 && cores[0].steal == 8);
+    CHECK(cores[1].user == 5 && cores[1].idle == 8);
+    CHECK(cores[1].iowait == 0 && cores[1].steal == 0);
+
+    /* 超出 max_cores 的核心被跳过，不写越界 */
+    CHECK(sampler_read_cpu_cores(&total, cores, 1) == 1);
+
+    /* 缓冲末尾不完整的 cpuN 行不计入 */
+    int complete = write_long_stat();
+    static SamplerCpuTimes many[256];
+    int count = sampler_read_cpu_cores(&total, many, 256);
+    CHECK(count == complete);
+    if (count > 1) {
+        CHECK(many[count - 1].user == (unsigned long long)(count - 1) * 10);
+        CHECK(many[count - 1].system == (unsigned long long)(count - 1));
+        CHECK(many[count - 1].idle == 1000);
+    }
+
+    /* 格式不对的首行 */
+    write_file("/proc/stat", "intr 1 2 3\n");
+    CHECK(sampler_read_cpu(&times) == -1);
+    CHECK(sampler_read_cpu_cores(&total, cores, 4) == -1);
+}
+
+static void check_uptime(void) {
+    double uptime = 0;
+    CHECK(sampler_read_uptime(&uptime) == 0);
+    CHECK(uptime > 12345.669 && uptime < 12345.671);
+}
+
+static void check_thermal(void) {
+    SamplerThermalZone zones[SAMPLER_MAX_ZONES];
+    int count = sampler_read_thermal(zones, SAMPLER_MAX_ZONES);
+
+    /* 按编号排序，缺少 temp 的 zone1 被跳过 */
+    CHECK(count == 2);
+    if (count == 2) {
+        CHECK(zones[0].id == 2);
+        CHECK(strcmp(zones[0].type, "board-thmzone") == 0);
+        CHECK(zones[0].temp_milli == -5500);
+        CHECK(zones[1].id == 10);
+        CHECK(strcmp(zones[1].type, "cpu-thmzone") == 0);
+        CHECK(zones[1].temp_milli == 45000);
+    }
+    CHECK(sampler_read_thermal(zones, 1) == 1);
+}
+
+static void check_pids(void) {
+    int pids[16];
+    int count = sampler_list_pids(pids, 16);
+
+    /* 只接受纯数字且不以0开头的目录名 */
+    CHECK(count == 3);
+    int seen = 0;
+    for (int i = 0; i < count; i++) {
+        if (pids[i] == 1234) seen |= 1;
+        else if (pids[i] == 77) seen |= 2;
+        else if (pids[i] == 42) seen |= 4;
+    }
+    CHECK(seen == 7);
+    CHECK(sampler_list_pids(pids, 1) == 1);
+
+    SamplerProcStat st;
+    CHECK(sampler_read_proc_stat(1234, &st) == 0);
+    CHECK(st.pid == 1234);
+    CHECK(strcmp(st.comm, "a) b (c") == 0);
+    CHECK(st.utime == 14014);
+    CHECK(st.stime == 15015);
+    CHECK(st.starttime == 22022);
+
+    CHECK(sampler_read_proc_stat(77, &st) == 0);
+    CHECK(strcmp(st.comm, "0123456789abcde") == 0);
+    CHECK(st.utime == 11 && st.stime == 22 && st.starttime == 33);
+
+    CHECK(sampler_read_proc_stat(42, &st) == -1);
+    CHECK(sampler_read_proc_stat(99999, &st) == -1);
+}
+
+/*============================================================================
+ * 入口
+ *============================================================================*/
+
+int main(void) {
+    snprintf(g_root, sizeof(g_root), "/tmp/sampler_check.XXXXXX");
+    if (!mkdtemp(g_root)) {
+        perror("mkdtemp");
+        return 2;
+    }
+    build_tree();
+
+    /* 末尾的 '/' 应被去掉 */
+    char root_slash[80];
+    snprintf(root_slash, sizeof(root_slash), "%s/", g_root);
+    write_file("/proc/stat", "cpu  1 2 3 4\n");
+    CHECK(sampler_init(root_slash) == 0);
+
+    check_meminfo();
+    check_uptime();
+    check_thermal();
+    check_pids();
+    check_stat();
+    sampler_deinit();
+
+    char cmd[128];
+    snprintf(cmd, sizeof(cmd), "rm -rf '%s'", g_root);
+    if (system(cmd) != 0) {
+        fprintf(stderr, "[SAMPLER_CHECK] 无法删除临时目录 %s\n", g_root);
+    }
+
+    if (g_failed) {
+        fprintf(stderr, "[SAMPLER_CHECK] %d 项检查失败\n", g_failed);
+        return 1;
+    }
+    fprintf(stderr, "[SAMPLER_CHECK] 全部通过\n");
+    return 0;
+}
@@ -371,6 +371,15 @@ export function useApi() {
 
 // ==================== 插件管理API ====================
 
+// 创建Web终端WebSocket连接（浏览器WebSocket无法设置请求头，Token通过URL参数传递）
+export function openTerminalSocket() {
+  const proto = window.location.protocol === 'https:' ? 'wss' : 'ws'
+  const token = encodeURIComponent(getAuthToken())
+  const ws = new WebSocket(`${proto}://${window.location.host}${BASE_URL}/api/terminal/ws?token=${token}`)
+  ws.binaryType = 'arraybuffer'
+  return ws
+}
+
 // 执行Shell命令
 export async function executeShell(command) {
   return request('/api/shell', {
@@ -682,16 +682,17 @@ export default {
   // Terminal
   terminal: {
     title: 'Web Terminal',
-    subtitle: 'ttyd port 7681',
+    subtitle: 'WebSocket Shell',
     loading: 'Loading...',
-    openNewTab: 'Open in new tab',
+    openNewTab: 'Open ttyd in new tab',
     refresh: 'Refresh Terminal',
     fullscreen: 'Fullscreen',
     exitFullscreen: 'Exit Fullscreen',
     connectionFailed: 'Connection failed',
+    disconnected: 'Disconnected',
     mobileWarning: 'Mobile experience may be limited, recommend using desktop',
     instructions: 'Instructions',
-    tip1: 'This terminal is provided by ttyd service, port 7681',
+    tip1: 'Click the terminal and type; output streams live. Use ttyd for full-screen programs (vi, top)',
     tip2: 'Supports full Shell command operations',
     tip3: 'Click top-right buttons to refresh, fullscreen or open in new window'
   },
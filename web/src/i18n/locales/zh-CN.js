@@ -681,16 +681,17 @@ export default {
   // Web终端模块
   terminal: {
     title: 'Web终端',
-    subtitle: 'ttyd 端口 7681',
+    subtitle: 'WebSocket Shell',
     loading: '加载中...',
-    openNewTab: '在新标签页打开',
+    openNewTab: '在新标签页打开 ttyd',
     refresh: '刷新终端',
     fullscreen: '全屏显示',
     exitFullscreen: '退出全屏',
     connectionFailed: '连接失败',
+    disconnected: '连接已断开',
     mobileWarning: '移动端体验可能不佳，建议使用电脑访问',
     instructions: '使用说明',
-    tip1: '此终端通过 ttyd 服务提供，端口 7681',
+    tip1: '点击终端区域后直接输入，输出实时显示；全屏程序（如 vi、top）请使用 ttyd',
     tip2: '支持完整的 Shell 命令操作',
     tip3: '点击右上角按钮可刷新、全屏或在新窗口打开'
   },